@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Monday, 7th April 2025 4:38:11 pm
+ * Last Modified: Sunday, 18th October 2026 9:55:40 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -49,6 +49,15 @@
 #include "src/LCDHandler.h"
 #include "src/LampControl.h"
 #include "src/MemoryUtils.h"
+#include "src/PresetStore.h"
+#include "src/TimerStateMachine.h"
+#include "src/SerialOutput.h"
+#include "src/SerialCommands.h"
+#include "src/Telemetry.h"
+#include "src/ExposureHistory.h"
+#include "src/ClockCalibration.h"
+#include "src/LightMeter.h"
+#include "src/OutputScheduler.h"
  
 #define SERIAL_BAUD 115200
 /**
@@ -59,8 +68,7 @@
  * It also tests the LCD and enlarger lamp to ensure they are functioning correctly.
  */
 void setup() {
-  Serial.begin(SERIAL_BAUD);
-  while (!Serial);  // Waiting for Serial Monitor
+  Serial.begin(SERIAL_BAUD); // No waiting for a Serial Monitor: the timer must run without one
   randomSeed(analogRead(0));
   initializeButtons();
   testLCD();
@@ -69,22 +77,33 @@ void setup() {
   initializeEncoder();
   testEnlargerLamp();
   displayStaticText();
-  restoreEEPROMAddress(); // Restore address from EEPROM!
+  restoreEEPROMAddress(); // Resume the wear leveling ring, restore the stored delay
+  loadPresets(); // Cache the preset profile store in RAM
+  loadClockCalibration(); // Oscillator correction for the exposure deadlines
+  loadHistory(); // Find the newest exposure in the EEPROM history log
 }
 void loop() {
   // Handle input from buttons and rotary encoder
   inputHandler();
 
-  // Check if exposure is in progress
-  if (startExposure) {
-      handleEnlargerLamp(); // Manage relay operation during exposure
-  }
-  else {
-      handleEncoderInput(); // Read rotary encoder input for timer adjustment
-  }
+  pollSerialCommands(); // Remote control: at most one command per pass, never waits for input
 
-  // Update the big digit display on the LCD if timer value changes
-  updateTimerDisplay();
-  if (EEPROM_FAILED) displayEEPROMError();
+  handleEncoderInput(); // Adjust the timer, or extend a running exposure
 
+  // Run the current timer state: exposure countdown, display updates, fault screen
+  tickTimerStateMachine();
+
+  tickOutputs(); // Timed safelight and buzzer switches that are due, one port write each
+
+  tickLightMeter(); // Host builds only: catch up on ADC conversions; the ISR samples on the board
+
+  tickClockCalibration(); // Follow a running oscillator calibration, store its result when idle
+
+  tickHistory(); // Copy finished exposures to the EEPROM log, one byte per pass while idle
+
+  tickPresets(); // Commit a preset delay changed by an exposure, one byte per pass once idle
+
+  tickTelemetry(); // Loop latency, and a state sample when the stream is on and one is due
+
+  flushSerialOutput(); // Send queued replies, telemetry and log records without waiting on the UART
 }
\ No newline at end of file
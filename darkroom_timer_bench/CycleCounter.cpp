@@ -0,0 +1,57 @@
+/*
+ * File: CycleCounter.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:15:33 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:15:33 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#include "CycleCounter.h"
+
+static volatile uint16_t timer1Overflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+    ++timer1Overflows;
+}
+
+namespace CycleCounter {
+    void begin() {
+        TCCR1A = 0;
+        TCCR1B = 0;
+        TCNT1 = 0;
+        timer1Overflows = 0;
+        TIFR1 = _BV(TOV1);
+        TIMSK1 = _BV(TOIE1);
+        TCCR1B = _BV(CS10); // normal mode, clk/1
+    }
+
+    uint32_t now() {
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t low = TCNT1;
+        uint16_t high = timer1Overflows;
+        // An overflow that happened after cli() is not counted yet
+        if ((TIFR1 & _BV(TOV1)) && low < 0x8000) {
+            ++high;
+        }
+        SREG = sreg;
+        return (static_cast<uint32_t>(high) << 16) | low;
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * File: CycleCounter.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:15:33 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:15:33 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief 32-bit CPU cycle counter on Timer1.
+ *
+ * Timer1 runs at the CPU clock (no prescaler) and its overflow interrupt
+ * extends the 16-bit count, so one reading costs a handful of cycles and
+ * spans about 268 s at 16 MHz. Nothing else in the firmware uses Timer1.
+ *
+ * The same counter works on a real board and in simavr, so benchmark
+ * numbers from both are comparable.
+ */
+namespace CycleCounter {
+    /** @brief Starts Timer1 at clk/1 with the overflow interrupt enabled. */
+    void begin();
+
+    /** @brief Cycles since begin(), consistent even across a pending overflow. */
+    uint32_t now();
+}
+
+#endif // CYCLE_COUNTER_H
@@ -0,0 +1,210 @@
+/*
+* File: darkroom_timer_bench.ino
+* Project: Darkroom Enlarger Timer
+* File Created: Sunday, 18th October 2026 8:16:02 pm
+* Author: Andrei Grichine (andrei.grichine@gmail.com)
+* -----
+* Last Modified: Sunday, 18th October 2026 10:02:13 pm
+* Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+* -----
+* Copyright 2019 - 2024, Prime73 Inc. MIT License
+* 
+* Copyright (c) 2024 Prime73 Inc.
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy of
+* this software and associated documentation files (the "Software"), to deal in
+* the Software without restriction, including without limitation the rights to
+* use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+* of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+* -----
+* HISTORY:
+*/
+
+/**
+ * @brief Cycle-count microbenchmarks of the firmware hot paths.
+ *
+ * Runs the real firmware objects from src/ and prints one CSV line per
+ * benchmark case on Serial:
+ *
+ *   function,case,calls,min_cycles,mean_cycles,max_cycles
+ *
+ * Cycles come from Timer1 at the CPU clock (see CycleCounter.h); the cost of
+ * the measurement itself is calibrated away. Interrupts stay enabled, as in
+ * the firmware, so max_cycles includes the odd millis() or sampling tick.
+ * A line "# done" ends the run, after which the CPU sleeps with interrupts
+ * off, which is also how simavr knows to stop (see darkroom_timer_sim).
+ *
+ * On a real board the exposure cases switch the relay: unplug the enlarger.
+ *
+ * Experimental: the sketch has not yet been built with the AVR toolchain or
+ * run under simavr, so no reference CSV exists to compare against.
+ */
+
+#include <avr/sleep.h>
+#include "src/constants.h"
+#include "src/ButtonHandler.h"
+#include "src/encoderHandler.h"
+#include "src/EncoderAcceleration.h"
+#include "src/LCDHandler.h"
+#include "src/LampControl.h"
+#include "src/MemoryUtils.h"
+#include "src/PresetStore.h"
+#include "src/TimerStateMachine.h"
+#include "src/VerticalDebounce.h"
+#include "CycleCounter.h"
+
+#define SERIAL_BAUD 115200
+
+typedef void (*BenchFunction)();
+
+static uint32_t measurementOverhead = 0;
+static uint16_t iteration = 0; // Call number within the current case, for prepare functions
+
+/**
+ * @brief Times `calls` calls of `call`, each preceded by an untimed `prepare`.
+ */
+static void runCase(const __FlashStringHelper* function, const __FlashStringHelper* variant,
+                    uint16_t calls, BenchFunction prepare, BenchFunction call) {
+    uint32_t minCycles = UINT32_MAX;
+    uint32_t maxCycles = 0;
+    uint32_t totalCycles = 0;
+    for (iteration = 0; iteration < calls; ++iteration) {
+        if (prepare) {
+            prepare();
+        }
+        uint32_t start = CycleCounter::now();
+        call();
+        uint32_t cycles = CycleCounter::now() - start;
+        cycles = (cycles > measurementOverhead) ? cycles - measurementOverhead : 0;
+        minCycles = min(minCycles, cycles);
+        maxCycles = max(maxCycles, cycles);
+        totalCycles += cycles;
+    }
+    Serial.print(function);
+    Serial.print(',');
+    Serial.print(variant);
+    Serial.print(',');
+    Serial.print(calls);
+    Serial.print(',');
+    Serial.print(minCycles);
+    Serial.print(',');
+    Serial.print(totalCycles / calls);
+    Serial.print(',');
+    Serial.println(maxCycles);
+    Serial.flush(); // keep the UART interrupt out of the next case
+}
+
+// --- Cases ---
+// Each one is a plain function, so every measurement has the same call overhead.
+
+static void nothing() {}
+
+static VerticalDebouncer benchDebouncer;
+static uint8_t benchSample = 0;
+static void debounceStable() { benchDebouncer = VerticalDebouncer(); benchSample = 0; }
+static void debounceToggling() { benchSample = (iteration & 4) ? 0x50 : 0x00; } // both buttons, edge every 4 samples
+static void debounceCall() { debounceSample(benchDebouncer, benchSample); }
+
+static EncoderAccelerator benchAccelerator;
+static long benchDelay = 0;
+static uint16_t benchStep = 0;
+static void linearDetent() { benchDelay = 12300; }
+static void fstopDetent() { benchDelay = 12300; exposureMode = ExposureMode::FSTOP; }
+static void encoderStepCall() {
+    benchStep = accelerationStep(benchAccelerator, exposureMode, true, millis());
+    benchDelay = applyEncoderStep(benchDelay, exposureMode, true, benchStep);
+}
+
+static void sameDelay() { timerDelay = 12300; }
+static void allDigitsChange() { timerDelay = (iteration & 1) ? 88800 : 11100; }
+static void lastDigitChanges() { timerDelay = (iteration & 1) ? 12300 : 12400; }
+
+static void drawEight() { drawOrEraseBigDigit(LCDLayout4x20::LCD_OFFSET + LCDLayout4x20::FIRST_BIG_DIGIT_OFFSET, 8, false); }
+static void eraseDigit() { drawOrEraseBigDigit(LCDLayout4x20::LCD_OFFSET + LCDLayout4x20::FIRST_BIG_DIGIT_OFFSET, 0, true); }
+
+static void farDeadline() { exposureDeadline = micros() + 60000000UL; }
+static void movingDeadline() { exposureDeadline = micros() + ((iteration & 1) ? 88800000UL : 11100000UL); }
+
+static void writeSameValue() { writeEEPROMWithRetry(EEPROM_START_ADDRESS, 12300); }
+static void writeNewValue() { writeEEPROMWithRetry(EEPROM_START_ADDRESS, (iteration & 1) ? 12300 : 45600); }
+
+static void calibrate() {
+    measurementOverhead = 0;
+    uint32_t best = UINT32_MAX;
+    for (uint8_t i = 0; i < 16; ++i) {
+        uint32_t start = CycleCounter::now();
+        nothing();
+        best = min(best, CycleCounter::now() - start);
+    }
+    measurementOverhead = best;
+}
+
+void setup() {
+    Serial.begin(SERIAL_BAUD);
+    initializeButtons();
+    initializeLCD();
+    initializeEncoder();
+    testEnlargerLamp();
+    displayStaticText();
+    restoreEEPROMAddress();
+    loadPresets();
+    selectPreset(NO_PRESET);
+    CycleCounter::begin();
+    calibrate();
+
+    Serial.println(F("function,case,calls,min_cycles,mean_cycles,max_cycles"));
+
+    runCase(F("debounceSample"), F("stable"), 64, debounceStable, debounceCall);
+    runCase(F("debounceSample"), F("toggling"), 64, debounceToggling, debounceCall);
+
+    runCase(F("inputHandler"), F("no_events"), 64, nullptr, inputHandler);
+
+    runCase(F("handleEncoderInput"), F("no_detent"), 64, nullptr, handleEncoderInput);
+    exposureMode = ExposureMode::LINEAR;
+    runCase(F("encoderDetent"), F("linear"), 32, linearDetent, encoderStepCall);
+    runCase(F("encoderDetent"), F("fstop"), 32, fstopDetent, encoderStepCall);
+    exposureMode = ExposureMode::LINEAR;
+
+    runCase(F("updateTimerDisplay"), F("unchanged"), 64, sameDelay, updateTimerDisplay);
+    runCase(F("updateTimerDisplay"), F("last_digit"), 16, lastDigitChanges, updateTimerDisplay);
+    runCase(F("updateTimerDisplay"), F("all_digits"), 16, allDigitsChange, updateTimerDisplay);
+
+    runCase(F("drawOrEraseBigDigit"), F("draw"), 16, nullptr, drawEight);
+    runCase(F("drawOrEraseBigDigit"), F("erase"), 16, nullptr, eraseDigit);
+
+    // The lamp control of the old handleEnlargerLamp() now lives in the state machine ticks
+    timerDelay = 12300;
+    runCase(F("tickTimerStateMachine"), F("idle"), 64, sameDelay, tickTimerStateMachine);
+    dispatchTimerEvent(TimerEvent::START);
+    tickTimerStateMachine(); // ARMED -> EXPOSING, relay on
+    runCase(F("tickTimerStateMachine"), F("exposing"), 64, farDeadline, tickTimerStateMachine);
+    runCase(F("tickTimerStateMachine"), F("exposing_redraw"), 16, movingDeadline, tickTimerStateMachine);
+    dispatchTimerEvent(TimerEvent::ABORT);
+
+    runCase(F("writeEEPROMWithRetry"), F("unchanged"), 16, nullptr, writeSameValue);
+    runCase(F("writeEEPROMWithRetry"), F("new_value"), 8, nullptr, writeNewValue);
+
+    // Deepest the stack got across all the cases above
+    Serial.print(F("# min_free_stack,"));
+    Serial.println(minFreeStack());
+    Serial.println(F("# done"));
+    Serial.flush();
+    cli();
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    sleep_cpu();
+}
+
+void loop() {}
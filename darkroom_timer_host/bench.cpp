@@ -0,0 +1,181 @@
+/*
+ * File: bench.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:12:14 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:58:23 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#include "bench.h"
+#include <EEPROM.h>
+#include <MD_REncoder.h>
+#include <LiquidCrystal_I2C.h>
+#include "../src/ButtonHandler.h"
+#include "../src/LampControl.h"
+
+namespace {
+    bool booted = false;
+    unsigned long long loopCount = 0;
+    bench::RelayLog relayLog = {0, 0, 0};
+    bool relayOn = false;
+    unsigned long long relayOnSince = 0;
+
+    /** @brief Books a relay edge at the current virtual time. */
+    void watchRelay() {
+        bool on = hal::gpio::level(RELAY_PIN) == HIGH;
+        if (on == relayOn) {
+            return;
+        }
+        unsigned long long now = hal::clock::now();
+        if (on) {
+            ++relayLog.switchOns;
+            relayOnSince = now;
+        } else {
+            relayLog.lastOnMicros = static_cast<unsigned long>(now - relayOnSince);
+            relayLog.onMicros += now - relayOnSince;
+        }
+        relayOn = on;
+    }
+
+    void releaseButtons() {
+        hal::gpio::set(TIMER_BUTTON_PIN, HIGH);
+        hal::gpio::set(ROTARY_ENCODER_BUTTON_PIN, HIGH);
+    }
+}
+
+namespace bench {
+    void boot() {
+        if (!booted) {
+            hal::clock::reset();
+            hal::gpio::reset();
+            hal::lcd::reset();
+            hal::serial::reset();
+            hal::eeprom::reset(); // a new board, whatever earlier tests left behind
+            setup();
+            watchRelay(); // the lamp test in setup() is not an exposure
+            resetRelay();
+            booted = true;
+        }
+        releaseButtons();
+        hal::encoder::clear();
+        run(100);
+    }
+
+    void run(unsigned long ms) {
+        unsigned long long end = hal::clock::now() + ms * 1000ULL;
+        while (hal::clock::now() < end) {
+            loop();
+            ++loopCount;
+            watchRelay();
+            hal::clock::advance(LOOP_PERIOD_US);
+        }
+    }
+
+    void press(uint8_t pin, unsigned long holdMs) {
+        hal::gpio::set(pin, LOW);
+        run(holdMs);
+        hal::gpio::set(pin, HIGH);
+        run(50); // debounce and gesture dispatch
+    }
+
+    void turn(int detents, unsigned long gapMs) {
+        int direction = detents < 0 ? -1 : 1;
+        for (int i = 0; i != detents; i += direction) {
+            hal::encoder::turn(direction);
+            run(gapMs);
+        }
+    }
+
+    const RelayLog& relay() { return relayLog; }
+
+    void resetRelay() {
+        relayLog.switchOns = 0;
+        relayLog.onMicros = 0;
+        relayLog.lastOnMicros = 0;
+    }
+
+    unsigned long lampMicrosFor(long delayMillis, unsigned long switchOns) {
+        unsigned long requested = static_cast<unsigned long>(delayMillis) * 1000UL;
+        return requested + lampCompensationMicros(requested) + (switchOns - 1) * lampRestartMicros();
+    }
+
+    unsigned long long loops() { return loopCount; }
+
+    void sendLine(const char* line, unsigned long ms) {
+        hal::serial::receive(line);
+        hal::serial::receive("\n");
+        run(ms);
+    }
+
+    std::string command(const char* line, unsigned long ms) {
+        hal::serial::reset();
+        sendLine(line, ms);
+        const std::string& sent = hal::serial::transmitted();
+        size_t end = sent.rfind("\r\n");
+        if (end == std::string::npos) {
+            return "";
+        }
+        size_t start = sent.rfind('\0', end);
+        start = (start == std::string::npos) ? 0 : start + 1;
+        return sent.substr(start, end - start);
+    }
+
+    std::vector<Frame> sentFrames() {
+        std::vector<Frame> frames;
+        std::vector<uint8_t> encoded;
+        for (char c : hal::serial::transmitted()) {
+            uint8_t byte = static_cast<uint8_t>(c);
+            if (byte != 0) {
+                encoded.push_back(byte);
+                continue;
+            }
+            // Undo the COBS stuffing, then check the CRC-8 over type and payload
+            std::vector<uint8_t> decoded;
+            bool valid = !encoded.empty();
+            for (size_t i = 0; valid && i < encoded.size();) {
+                uint8_t code = encoded[i];
+                valid = code != 0 && i + code <= encoded.size();
+                for (uint8_t k = 1; valid && k < code; ++k) {
+                    decoded.push_back(encoded[i + k]);
+                }
+                i += code;
+                if (valid && code < 0xFF && i < encoded.size()) {
+                    decoded.push_back(0);
+                }
+            }
+            uint8_t crc = 0;
+            for (size_t i = 0; valid && i + 1 < decoded.size(); ++i) {
+                crc ^= decoded[i];
+                for (uint8_t bit = 0; bit < 8; ++bit) {
+                    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+                }
+            }
+            Frame frame = {0, encoded};
+            if (valid && decoded.size() >= 2 && crc == decoded.back()) {
+                frame.type = decoded.front();
+                frame.payload.assign(decoded.begin() + 1, decoded.end() - 1);
+            }
+            frames.push_back(frame);
+            encoded.clear();
+        }
+        return frames;
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * File: bench.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:12:14 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:58:23 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/**
+ * @file bench.h
+ * @brief Drives the complete sketch (setup() and loop()) in virtual time.
+ *
+ * The bench plays the darkroom: it presses buttons, turns the encoder and
+ * lets loop() run, advancing the virtual clock by LOOP_PERIOD_US per pass. It
+ * timestamps every relay edge on the virtual clock, so exposure lengths are
+ * measured exactly rather than sampled.
+ */
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#include <Arduino.h>
+
+namespace bench {
+    /** @brief Virtual time per loop() pass, close to the board's loop rate with the LCD idle. */
+    constexpr unsigned long LOOP_PERIOD_US = 500;
+
+    /** @brief Relay activity since the last resetRelay(). */
+    struct RelayLog {
+        unsigned long switchOns;          // Off -> on edges
+        unsigned long long onMicros;      // Total time on
+        unsigned long lastOnMicros;       // Length of the last completed on period
+    };
+
+    /**
+     * @brief Powers the board on: runs setup() on the first call.
+     *
+     * Firmware state lives for the whole test binary, so later calls only
+     * release the buttons and drain pending encoder detents.
+     */
+    void boot();
+    /** @brief Runs loop() for the given virtual time. */
+    void run(unsigned long ms);
+    /** @brief Holds a button down for holdMs, releases it and lets it settle. */
+    void press(uint8_t pin, unsigned long holdMs = 100);
+    /** @brief Turns the encoder one detent at a time, gapMs apart (slow turns give fine steps). */
+    void turn(int detents, unsigned long gapMs = 200);
+    /** @brief One chunk of serial output between 0x00 delimiters (see SerialOutput.h). */
+    struct Frame {
+        uint8_t type;                   // FrameType, or 0 for anything that is not a valid frame (text lines)
+        std::vector<uint8_t> payload;   // Payload without type and CRC; the raw bytes when type is 0
+    };
+
+    const RelayLog& relay();
+    void resetRelay();
+    /**
+     * @brief Relay-on time of an exposure of delayMillis with the lamp compensation
+     * of src/LampModel.h, switched on switchOns times (pauses).
+     */
+    unsigned long lampMicrosFor(long delayMillis, unsigned long switchOns = 1);
+    /** @brief Sends one command line to the serial command interface and lets loop() run for ms. */
+    void sendLine(const char* line, unsigned long ms = 20);
+    /** @brief Sends one command line, lets loop() run and returns the last reply line (without CR LF). */
+    std::string command(const char* line, unsigned long ms = 20);
+    /** @brief Decodes everything sent with Serial.write() since hal::serial::reset(). */
+    std::vector<Frame> sentFrames();
+    /** @brief Number of loop() passes since boot. */
+    unsigned long long loops();
+}
+
+#endif // HOST_BENCH_H
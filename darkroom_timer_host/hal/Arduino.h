@@ -0,0 +1,175 @@
+/*
+ * File: Arduino.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:46:37 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:00:56 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/**
+ * @file Arduino.h
+ * @brief Host (g++) stand-in for the Arduino core used by the firmware in src/.
+ *
+ * Only the parts of the core the firmware actually uses are provided. Time is
+ * virtual: millis()/micros() return the simulated clock and delay() advances
+ * it instantly, so long waits cost no wall-clock time.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+// C++ headers used by the HAL and the bench, included before the min()/max() macros below
+#include <string>
+#include <vector>
+
+#define PROGMEM
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define NUM_DIGITAL_PINS 20
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define PSTR(s) (s)
+typedef const char* PGM_P;
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t*>(addr))
+#define pgm_read_ptr(addr) (*reinterpret_cast<void* const*>(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define snprintf_P snprintf
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/*
+ * Interrupts: a simulated interrupt handler runs through runInterrupt(), which
+ * holds the same (recursive) lock that noInterrupts() takes. Firmware code that
+ * masks interrupts is therefore never interleaved with a handler, even when the
+ * handler runs on another thread, as in the concurrency stress tests.
+ */
+void noInterrupts();
+void interrupts();
+void runInterrupt(void (*handler)());
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void randomSeed(unsigned long seed);
+char* dtostrf(double value, signed char width, unsigned char precision, char* buffer);
+
+/**
+ * @brief Serial stand-in. Output goes to stdout only when echo is enabled.
+ *
+ * write() models the UART transmit buffer of the Arduino core: 63 bytes that
+ * drain at 115200 baud on the virtual clock, as reported by availableForWrite().
+ * Bytes given to write() are kept for hal::serial::transmitted(); bytes
+ * passed to hal::serial::receive() are returned by available() and read().
+ */
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    explicit operator bool() const { return true; }
+    size_t print(const char* text);
+    size_t print(char c);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(int value) { return print(static_cast<long>(value)); }
+    size_t print(unsigned int value) { return print(static_cast<unsigned long>(value)); }
+    size_t print(const __FlashStringHelper* text) { return print(reinterpret_cast<const char*>(text)); }
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + print('\n'); }
+    size_t println() { return print('\n'); }
+    size_t write(uint8_t byte);
+    int availableForWrite();
+    int available();
+    int read();
+    bool echo = false;
+};
+extern HostSerial Serial;
+
+// Sketch entry points, as declared by the Arduino core
+void setup();
+void loop();
+
+namespace hal {
+namespace clock {
+    /** @brief Sets the virtual clock back to zero. */
+    void reset();
+    /** @brief Moves the virtual clock forward (delay() does the same from firmware code). */
+    void advance(unsigned long us);
+    /** @brief Full 64-bit virtual time, which does not wrap like micros(). */
+    unsigned long long now();
+    /**
+     * @brief Makes the board's oscillator run ppm parts per million fast (negative: slow).
+     *
+     * millis() and micros() then drift against now(), which stays real time,
+     * as on a Nano clone with a ceramic resonator. reset() sets it back to 0.
+     */
+    void setDriftPpm(long ppm);
+}
+namespace serial {
+    /** @brief Bytes written with Serial.write() since the last reset(). */
+    const std::string& transmitted();
+    /** @brief Bytes arriving from the host, for Serial.read(). */
+    void receive(const char* text);
+    /** @brief Empties the transmit buffer, the captured bytes and the receive buffer. */
+    void reset();
+}
+namespace gpio {
+    /** @brief Drives an input pin from outside, e.g. a button pulling it LOW. */
+    void set(uint8_t pin, uint8_t level);
+    /** @brief Current level of a pin as last written by the firmware or set(). */
+    uint8_t level(uint8_t pin);
+    /** @brief Mode last given to pinMode(). */
+    uint8_t mode(uint8_t pin);
+    /** @brief Number of level changes of a pin since the last reset(). */
+    unsigned long transitions(uint8_t pin);
+    /** @brief Every pin INPUT and LOW, counters cleared. */
+    void reset();
+}
+namespace analog {
+    /**
+     * @brief Sets the voltage on an analog input, in ADC counts (fractions allowed).
+     *
+     * analogRead() adds a dither that steps through 16 levels of 1/16 LSB, like
+     * the noise of a real sensor, so averaging 16 conversions resolves the fraction.
+     */
+    void set(uint8_t channel, double level);
+    /** @brief Every analog input back to 0. */
+    void reset();
+}
+}
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,74 @@
+/*
+ * File: ArduinoUnit.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:46:56 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 7:46:56 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/**
+ * @file ArduinoUnit.h
+ * @brief Minimal host implementation of the ArduinoUnit API used by the tests.
+ *
+ * Supports the `test(name)` macro and the assertions the test files use, so
+ * the same test sources run on the board and on the host.
+ */
+#ifndef HOST_ARDUINOUNIT_H
+#define HOST_ARDUINOUNIT_H
+
+#include <Arduino.h>
+
+class Test {
+public:
+    typedef void (*Function)();
+    Test(const char* name, Function function);
+    /** @brief Runs every registered test once and prints a summary. */
+    static void run();
+    static int failed();
+    static void fail(const char* file, int line, const char* expression);
+
+private:
+    const char* name;
+    Function function;
+    Test* next;
+    static Test* first;
+    static Test* current;
+    static bool currentFailed;
+    static int failures;
+};
+
+#define test(name) \
+    static void test_##name(); \
+    static Test test_registration_##name(#name, test_##name); \
+    static void test_##name()
+
+#define HOST_ASSERT(condition, text) \
+    do { if (!(condition)) { Test::fail(__FILE__, __LINE__, text); return; } } while (0)
+
+#define assertEqual(a, b) HOST_ASSERT((a) == (b), #a " == " #b)
+#define assertNotEqual(a, b) HOST_ASSERT((a) != (b), #a " != " #b)
+#define assertLess(a, b) HOST_ASSERT((a) < (b), #a " < " #b)
+#define assertLessOrEqual(a, b) HOST_ASSERT((a) <= (b), #a " <= " #b)
+#define assertMore(a, b) HOST_ASSERT((a) > (b), #a " > " #b)
+#define assertMoreOrEqual(a, b) HOST_ASSERT((a) >= (b), #a " >= " #b)
+#define assertTrue(a) HOST_ASSERT((a), #a)
+#define assertFalse(a) HOST_ASSERT(!(a), "!(" #a ")")
+
+#endif // HOST_ARDUINOUNIT_H
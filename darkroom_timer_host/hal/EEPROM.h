@@ -0,0 +1,94 @@
+/*
+ * File: EEPROM.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:46:37 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 7:46:37 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/**
+ * @file EEPROM.h
+ * @brief Host stand-in for the AVR EEPROM library with fault injection.
+ *
+ * Mirrors the AVR library semantics that matter for wear: put() goes through
+ * update(), so only bytes that differ are programmed. Every programmed byte is
+ * counted per cell, cells can be given a finite endurance, and a power cut can
+ * be scheduled after any number of byte writes.
+ */
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <Arduino.h>
+
+constexpr int HOST_EEPROM_SIZE = 1024;
+
+class EEPROMClass {
+public:
+    uint8_t read(int address) const;
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value) {
+        if (read(address) != value) {
+            write(address, value);
+        }
+    }
+    template <typename T> T& get(int address, T& value) const {
+        uint8_t* bytes = reinterpret_cast<uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bytes[i] = read(address + i);
+        }
+        return value;
+    }
+    template <typename T> const T& put(int address, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            update(address + i, bytes[i]);
+        }
+        return value;
+    }
+    uint16_t length() const { return HOST_EEPROM_SIZE; }
+};
+extern EEPROMClass EEPROM;
+
+namespace hal {
+namespace eeprom {
+    /** @brief Fills the whole EEPROM with a value (0xFF = erased chip) and clears the fault state. */
+    void reset(uint8_t value = 0xFF);
+    /** @brief Number of bytes programmed since the last reset. */
+    unsigned long writeCount();
+    /**
+     * @brief Cuts the power after `writes` more byte writes.
+     * @param tear If true, the first lost write leaves its cell erased (0xFF) instead of untouched.
+     */
+    void powerCutAfter(unsigned long writes, bool tear = false);
+    /** @brief Restores power (further writes succeed again). */
+    void powerOn();
+    /** @brief Direct access to the backing store for snapshots. */
+    uint8_t* cells();
+    /**
+     * @brief Sets how many program cycles a cell survives. A worn-out cell keeps
+     *        its last value, so write verification fails. reset() makes every cell unlimited.
+     */
+    void setEndurance(int address, unsigned long cycles);
+    /** @brief Number of program cycles a cell has seen since the last reset. */
+    unsigned long wear(int address);
+}
+}
+
+#endif // HOST_EEPROM_H
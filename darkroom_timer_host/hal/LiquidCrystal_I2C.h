@@ -0,0 +1,77 @@
+/*
+ * File: LiquidCrystal_I2C.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:46:37 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:14:22 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/**
+ * @file LiquidCrystal_I2C.h
+ * @brief Host stand-in for the New-LiquidCrystal I2C driver.
+ *
+ * Writes land in a character buffer the size of the display, so tests can
+ * read back what the firmware shows (see hal::lcd). Custom characters are
+ * stored by their code (1-7), like the controller's DDRAM does.
+ */
+#ifndef HOST_LIQUIDCRYSTAL_I2C_H
+#define HOST_LIQUIDCRYSTAL_I2C_H
+
+#include <Arduino.h>
+
+#define POSITIVE 1
+#define NEGATIVE 0
+
+constexpr uint8_t HOST_LCD_COLS = 20;
+constexpr uint8_t HOST_LCD_ROWS = 4;
+
+class LiquidCrystal_I2C {
+public:
+    LiquidCrystal_I2C(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, int) {}
+    void begin(uint8_t cols, uint8_t rows);
+    void backlight();
+    void noBacklight();
+    void clear();
+    void setCursor(uint8_t col, uint8_t row);
+    void createChar(uint8_t, uint8_t*) {}
+    size_t write(uint8_t value);
+    size_t print(const char* text);
+    size_t print(const __FlashStringHelper* text) { return print(reinterpret_cast<const char*>(text)); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(long value);
+    size_t print(int value) { return print(static_cast<long>(value)); }
+};
+
+namespace hal {
+namespace lcd {
+    /** @brief Blanks the display, homes the cursor and turns the backlight off (power-on state). */
+    void reset();
+    /** @brief Raw contents of one row, HOST_LCD_COLS bytes plus a terminating NUL. */
+    const char* row(uint8_t row);
+    /** @brief True if the backlight is on. */
+    bool backlight();
+    /** @brief Number of bytes written to the display since the last reset (I2C traffic proxy). */
+    unsigned long writeCount();
+    /** @brief Prints the display to stdout, custom characters and 0xFF as '#', 0xFE as ' '. */
+    void dump();
+}
+}
+
+#endif // HOST_LIQUIDCRYSTAL_I2C_H
@@ -0,0 +1,62 @@
+/*
+ * File: MD_REncoder.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:10:40 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:10:40 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/**
+ * @file MD_REncoder.h
+ * @brief Host stand-in for the MD_REncoder rotary encoder library.
+ *
+ * There are no quadrature pins to decode: tests script detents with
+ * hal::encoder::turn() and read() hands them out one per call, as the library
+ * reports one direction per detent.
+ */
+#ifndef HOST_MD_RENCODER_H
+#define HOST_MD_RENCODER_H
+
+#include <Arduino.h>
+
+#define DIR_NONE 0x00
+#define DIR_CW 0x10
+#define DIR_CCW 0x20
+
+class MD_REncoder {
+public:
+    MD_REncoder(uint8_t pinA, uint8_t pinB) {}
+    void begin() {}
+    /** @brief Next scripted detent: DIR_CW, DIR_CCW or DIR_NONE. */
+    uint8_t read();
+};
+
+namespace hal {
+namespace encoder {
+    /** @brief Queues detents: positive counts turn clockwise, negative ones counterclockwise. */
+    void turn(int detents);
+    /** @brief Number of queued detents not read yet. */
+    size_t pending();
+    /** @brief Drops the queued detents. */
+    void clear();
+}
+}
+
+#endif // HOST_MD_RENCODER_H
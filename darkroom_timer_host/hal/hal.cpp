@@ -0,0 +1,418 @@
+/*
+ * File: hal.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:46:56 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:00:56 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/*
+ * Host implementations of the Arduino core, EEPROM and ArduinoUnit stand-ins
+ * declared in this directory.
+ */
+
+#include <deque>
+#include <mutex>
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ArduinoUnit.h>
+#include <LiquidCrystal_I2C.h>
+#include <MD_REncoder.h>
+
+// --- Virtual clock ---
+// virtualMicros is real time; boardMicros is what the board's oscillator counts,
+// which runs driftPpm fast (or slow) against it.
+static unsigned long long virtualMicros = 0;
+static unsigned long long boardMicros = 0;
+static long driftPpm = 0;
+static long long driftRemainder = 0;
+
+static void advanceVirtual(unsigned long long us) {
+    virtualMicros += us;
+    long long drift = static_cast<long long>(us) * driftPpm + driftRemainder;
+    boardMicros += us + drift / 1000000;
+    driftRemainder = drift % 1000000;
+}
+
+unsigned long millis() { return static_cast<unsigned long>(boardMicros / 1000); }
+unsigned long micros() { return static_cast<unsigned long>(boardMicros); }
+void delay(unsigned long ms) { advanceVirtual(ms * 1000ULL * 1000000 / (1000000 + driftPpm)); }
+void delayMicroseconds(unsigned int us) { advanceVirtual(us * 1000000ULL / (1000000 + driftPpm)); }
+
+namespace hal {
+namespace clock {
+    void reset() { virtualMicros = 0; boardMicros = 0; driftPpm = 0; driftRemainder = 0; }
+    void advance(unsigned long us) { advanceVirtual(us); }
+    unsigned long long now() { return virtualMicros; }
+    void setDriftPpm(long ppm) { driftPpm = ppm; }
+}
+}
+
+// --- Interrupts ---
+static std::recursive_mutex interruptLock;
+
+void noInterrupts() { interruptLock.lock(); }
+void interrupts() { interruptLock.unlock(); }
+void runInterrupt(void (*handler)()) {
+    std::lock_guard<std::recursive_mutex> guard(interruptLock);
+    handler();
+}
+
+// --- GPIO ---
+static uint8_t pinLevels[NUM_DIGITAL_PINS];
+static uint8_t pinModes[NUM_DIGITAL_PINS];
+static unsigned long pinTransitions[NUM_DIGITAL_PINS];
+
+// --- ADC ---
+static constexpr uint8_t ANALOG_CHANNELS = 8;
+static double analogLevels[ANALOG_CHANNELS];
+static unsigned int analogDither = 0;
+
+static void setPinLevel(uint8_t pin, uint8_t level) {
+    if (pinLevels[pin] != level) {
+        pinLevels[pin] = level;
+        ++pinTransitions[pin];
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin >= NUM_DIGITAL_PINS) {
+        return;
+    }
+    pinModes[pin] = mode;
+    if (mode == INPUT_PULLUP) {
+        setPinLevel(pin, HIGH);
+    }
+}
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < NUM_DIGITAL_PINS) {
+        setPinLevel(pin, value ? HIGH : LOW);
+    }
+}
+int digitalRead(uint8_t pin) { return pin < NUM_DIGITAL_PINS ? pinLevels[pin] : LOW; }
+
+namespace hal {
+namespace gpio {
+    void set(uint8_t pin, uint8_t level) { digitalWrite(pin, level); }
+    uint8_t level(uint8_t pin) { return pin < NUM_DIGITAL_PINS ? pinLevels[pin] : LOW; }
+    uint8_t mode(uint8_t pin) { return pin < NUM_DIGITAL_PINS ? pinModes[pin] : INPUT; }
+    unsigned long transitions(uint8_t pin) { return pin < NUM_DIGITAL_PINS ? pinTransitions[pin] : 0; }
+    void reset() {
+        memset(pinLevels, LOW, sizeof(pinLevels));
+        memset(pinModes, INPUT, sizeof(pinModes));
+        memset(pinTransitions, 0, sizeof(pinTransitions));
+    }
+}
+namespace analog {
+    void set(uint8_t channel, double level) {
+        if (channel < ANALOG_CHANNELS) analogLevels[channel] = level;
+    }
+    void reset() {
+        for (double& level : analogLevels) level = 0;
+    }
+}
+}
+
+int analogRead(uint8_t channel) {
+    if (channel >= ANALOG_CHANNELS) return 0;
+    double dithered = analogLevels[channel] + (analogDither++ % 16 + 0.5) / 16;
+    return constrain(static_cast<int>(dithered), 0, 1023);
+}
+void randomSeed(unsigned long seed) { srand(seed); }
+
+char* dtostrf(double value, signed char width, unsigned char precision, char* buffer) {
+    sprintf(buffer, "%*.*f", width, precision, value);
+    return buffer;
+}
+
+// --- Serial ---
+HostSerial Serial;
+
+size_t HostSerial::print(const char* text) {
+    if (echo) {
+        fputs(text, stdout);
+    }
+    return strlen(text);
+}
+size_t HostSerial::print(char c) { if (echo) putchar(c); return 1; }
+size_t HostSerial::print(long value) { char b[24]; snprintf(b, sizeof(b), "%ld", value); return print(b); }
+size_t HostSerial::print(unsigned long value) { char b[24]; snprintf(b, sizeof(b), "%lu", value); return print(b); }
+
+static const int SERIAL_TX_BUFFER = 63;             // Usable bytes of the core's 64-byte ring
+static const unsigned long SERIAL_BYTE_US = 87;     // 10 bits at 115200 baud
+static std::string serialTransmitted;
+static unsigned long long serialIdleAt = 0;         // Virtual time the transmit buffer runs empty
+
+int HostSerial::availableForWrite() {
+    if (serialIdleAt <= virtualMicros) {
+        return SERIAL_TX_BUFFER;
+    }
+    unsigned long long queued = (serialIdleAt - virtualMicros + SERIAL_BYTE_US - 1) / SERIAL_BYTE_US;
+    return queued >= SERIAL_TX_BUFFER ? 0 : SERIAL_TX_BUFFER - static_cast<int>(queued);
+}
+
+size_t HostSerial::write(uint8_t byte) {
+    serialIdleAt = (serialIdleAt > virtualMicros ? serialIdleAt : virtualMicros) + SERIAL_BYTE_US;
+    serialTransmitted.push_back(static_cast<char>(byte));
+    if (echo) {
+        putchar(byte);
+    }
+    return 1;
+}
+
+static std::deque<uint8_t> serialReceived;
+
+int HostSerial::available() { return static_cast<int>(serialReceived.size()); }
+
+int HostSerial::read() {
+    if (serialReceived.empty()) {
+        return -1;
+    }
+    uint8_t byte = serialReceived.front();
+    serialReceived.pop_front();
+    return byte;
+}
+
+namespace hal {
+namespace serial {
+    const std::string& transmitted() { return serialTransmitted; }
+    void receive(const char* text) {
+        serialReceived.insert(serialReceived.end(), text, text + strlen(text));
+    }
+    void reset() {
+        serialTransmitted.clear();
+        serialReceived.clear();
+        serialIdleAt = 0;
+    }
+}
+}
+
+// --- Rotary encoder ---
+static std::deque<uint8_t> encoderDetents;
+
+uint8_t MD_REncoder::read() {
+    if (encoderDetents.empty()) {
+        return DIR_NONE;
+    }
+    uint8_t direction = encoderDetents.front();
+    encoderDetents.pop_front();
+    return direction;
+}
+
+namespace hal {
+namespace encoder {
+    void turn(int detents) {
+        for (int i = 0; i < abs(detents); ++i) {
+            encoderDetents.push_back(detents > 0 ? DIR_CW : DIR_CCW);
+        }
+    }
+    size_t pending() { return encoderDetents.size(); }
+    void clear() { encoderDetents.clear(); }
+}
+}
+
+// --- LCD ---
+static char lcdText[HOST_LCD_ROWS][HOST_LCD_COLS + 1];
+static uint8_t lcdCols = HOST_LCD_COLS;
+static uint8_t lcdRows = HOST_LCD_ROWS;
+static uint8_t lcdCursorCol = 0;
+static uint8_t lcdCursorRow = 0;
+static bool lcdBacklight = false;
+static unsigned long lcdWrites = 0;
+
+void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t rows) {
+    lcdCols = min(cols, HOST_LCD_COLS);
+    lcdRows = min(rows, HOST_LCD_ROWS);
+    clear();
+}
+void LiquidCrystal_I2C::backlight() { lcdBacklight = true; }
+void LiquidCrystal_I2C::noBacklight() { lcdBacklight = false; }
+void LiquidCrystal_I2C::clear() {
+    for (uint8_t row = 0; row < HOST_LCD_ROWS; ++row) {
+        memset(lcdText[row], ' ', HOST_LCD_COLS);
+        lcdText[row][HOST_LCD_COLS] = '\0';
+    }
+    lcdCursorCol = 0;
+    lcdCursorRow = 0;
+}
+void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row) {
+    lcdCursorCol = col;
+    lcdCursorRow = row;
+}
+size_t LiquidCrystal_I2C::write(uint8_t value) {
+    ++lcdWrites;
+    // Characters past the end of a row are lost, as on a 20x4 module
+    if (lcdCursorRow < lcdRows && lcdCursorCol < lcdCols) {
+        lcdText[lcdCursorRow][lcdCursorCol] = static_cast<char>(value);
+    }
+    ++lcdCursorCol;
+    return 1;
+}
+size_t LiquidCrystal_I2C::print(const char* text) {
+    size_t n = 0;
+    while (text[n] != '\0') {
+        write(static_cast<uint8_t>(text[n++]));
+    }
+    return n;
+}
+size_t LiquidCrystal_I2C::print(long value) {
+    char b[24];
+    snprintf(b, sizeof(b), "%ld", value);
+    return print(b);
+}
+
+namespace hal {
+namespace lcd {
+    void reset() {
+        LiquidCrystal_I2C(0, 0, 0, 0, 0, 0, 0, 0, 0, 0).clear();
+        lcdBacklight = false;
+        lcdWrites = 0;
+    }
+    const char* row(uint8_t row) { return row < HOST_LCD_ROWS ? lcdText[row] : ""; }
+    bool backlight() { return lcdBacklight; }
+    unsigned long writeCount() { return lcdWrites; }
+    void dump() {
+        printf("+--------------------+ %s\n", lcdBacklight ? "backlight" : "dark");
+        for (uint8_t row = 0; row < HOST_LCD_ROWS; ++row) {
+            putchar('|');
+            for (uint8_t col = 0; col < HOST_LCD_COLS; ++col) {
+                uint8_t c = static_cast<uint8_t>(lcdText[row][col]);
+                putchar(c == 0xFE ? ' ' : ((c < 8 || c == 0xFF) ? '#' : c));
+            }
+            puts("|");
+        }
+        puts("+--------------------+");
+    }
+}
+}
+
+// --- EEPROM ---
+EEPROMClass EEPROM;
+
+static uint8_t eepromCells[HOST_EEPROM_SIZE];
+static unsigned long eepromWear[HOST_EEPROM_SIZE];
+static unsigned long eepromEndurance[HOST_EEPROM_SIZE];
+static unsigned long eepromWrites = 0;
+static unsigned long eepromWritesLeft = 0;
+static bool eepromPowerCutArmed = false;
+static bool eepromTear = false;
+
+uint8_t EEPROMClass::read(int address) const {
+    return (address >= 0 && address < HOST_EEPROM_SIZE) ? eepromCells[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address < 0 || address >= HOST_EEPROM_SIZE) {
+        return;
+    }
+    if (eepromPowerCutArmed) {
+        if (eepromWritesLeft == 0) {
+            if (eepromTear) {
+                eepromCells[address] = 0xFF; // erase finished, program cycle lost
+                eepromTear = false;
+            }
+            return;
+        }
+        --eepromWritesLeft;
+    }
+    ++eepromWrites;
+    if (++eepromWear[address] > eepromEndurance[address]) {
+        return; // worn out: the cell no longer takes new values
+    }
+    eepromCells[address] = value;
+}
+
+namespace hal {
+namespace eeprom {
+    void reset(uint8_t value) {
+        memset(eepromCells, value, sizeof(eepromCells));
+        memset(eepromWear, 0, sizeof(eepromWear));
+        for (int i = 0; i < HOST_EEPROM_SIZE; ++i) {
+            eepromEndurance[i] = ~0UL;
+        }
+        eepromWrites = 0;
+        powerOn();
+    }
+    unsigned long writeCount() { return eepromWrites; }
+    void powerCutAfter(unsigned long writes, bool tear) {
+        eepromPowerCutArmed = true;
+        eepromWritesLeft = writes;
+        eepromTear = tear;
+    }
+    void powerOn() {
+        eepromPowerCutArmed = false;
+        eepromTear = false;
+    }
+    uint8_t* cells() { return eepromCells; }
+    void setEndurance(int address, unsigned long cycles) {
+        if (address >= 0 && address < HOST_EEPROM_SIZE) {
+            eepromEndurance[address] = cycles;
+        }
+    }
+    unsigned long wear(int address) {
+        return (address >= 0 && address < HOST_EEPROM_SIZE) ? eepromWear[address] : 0;
+    }
+}
+}
+
+// Blank display at power-on
+static struct LcdPowerOn {
+    LcdPowerOn() { hal::lcd::reset(); }
+} lcdPowerOn;
+
+// Start with an erased chip and unlimited endurance
+static struct EepromPowerOn {
+    EepromPowerOn() { hal::eeprom::reset(); }
+} eepromPowerOn;
+
+// --- ArduinoUnit ---
+Test* Test::first = nullptr;
+Test* Test::current = nullptr;
+bool Test::currentFailed = false;
+int Test::failures = 0;
+
+Test::Test(const char* name, Function function) : name(name), function(function), next(nullptr) {
+    // Keep declaration order within a file
+    Test** link = &first;
+    while (*link != nullptr) {
+        link = &(*link)->next;
+    }
+    *link = this;
+}
+
+void Test::fail(const char* file, int line, const char* expression) {
+    printf("  %s:%d: assertion failed: %s\n", file, line, expression);
+    currentFailed = true;
+}
+
+void Test::run() {
+    int count = 0;
+    for (Test* test = first; test != nullptr; test = test->next) {
+        current = test;
+        currentFailed = false;
+        test->function();
+        printf("Test %s %s.\n", test->name, currentFailed ? "failed" : "passed");
+        failures += currentFailed ? 1 : 0;
+        ++count;
+    }
+    printf("Test summary: %d passed, %d failed, out of %d test(s).\n", count - failures, failures, count);
+}
+
+int Test::failed() { return failures; }
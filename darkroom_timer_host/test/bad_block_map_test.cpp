@@ -0,0 +1,105 @@
+/*
+ * File: bad_block_map_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 9:29:39 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:29:39 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * Host tests of the bad-block bitmap of the EEPROM wear leveling ring
+ * (MemoryUtils.cpp): slots that fail write verification are retired and
+ * stay retired across a reboot, and a board upgraded from firmware that
+ * kept the ring where the bitmap is now starts with every slot usable.
+ *
+ * restoreEEPROMAddress() is the boot-time load; every test leaves a blank,
+ * healthy EEPROM behind for the sketch tests.
+ */
+
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include "../../src/constants.h"
+#include "../../src/MemoryUtils.h"
+
+namespace {
+    int slotAddress(int slot) {
+        return EEPROM_START_ADDRESS + slot * EEPROM_SLOT_SIZE;
+    }
+
+    int retiredSlots() {
+        int retired = 0;
+        for (int slot = 0; slot < EEPROM_SLOT_COUNT; ++slot) {
+            retired += isEEPROMSlotRetired(slot) ? 1 : 0;
+        }
+        return retired;
+    }
+
+    /** @brief Back to a blank chip, as the other tests expect it. */
+    void cleanUp() {
+        hal::eeprom::reset();
+        restoreEEPROMAddress();
+        EEPROM_FAILED = false;
+    }
+}
+
+test(BadBlockMap_blank_eeprom_has_every_slot_usable) {
+    hal::eeprom::reset();
+    restoreEEPROMAddress();
+    assertEqual(retiredSlots(), 0);
+    assertFalse(EEPROM_FAILED);
+    assertEqual(EEPROM.read(BAD_BLOCK_MAP_MARKER_ADDRESS), BAD_BLOCK_MAP_MARKER);
+    cleanUp();
+}
+
+test(BadBlockMap_failed_write_retires_the_slot_across_a_reboot) {
+    hal::eeprom::reset();
+    restoreEEPROMAddress();
+    const int slot = 5;
+    hal::eeprom::setEndurance(slotAddress(slot), 0);   // worn out: every write fails verification
+    assertFalse(writeEEPROMWithRetry(slotAddress(slot), 5000));
+    assertTrue(isEEPROMSlotRetired(slot));
+    assertEqual(retiredSlots(), 1);
+    assertFalse(EEPROM_FAILED);                         // one slot is far below the limit
+
+    restoreEEPROMAddress();                             // reboot
+    assertTrue(isEEPROMSlotRetired(slot));
+    assertEqual(retiredSlots(), 1);
+    for (int i = 0; i < EEPROM_SLOT_COUNT; ++i) {
+        assertNotEqual(getNextEEPROMAddress(), slotAddress(slot));
+    }
+    cleanUp();
+}
+
+test(BadBlockMap_upgraded_board_does_not_read_old_delays_as_retired_slots) {
+    hal::eeprom::reset();
+    // The old ring started at address 10, right where the bitmap is now
+    for (int address = BAD_BLOCK_MAP_ADDRESS; address + 4 <= EEPROM_START_ADDRESS; address += 4) {
+        EEPROM.put(address, static_cast<int32_t>(5000));   // 88 13 00 00
+    }
+    restoreEEPROMAddress();
+    assertEqual(retiredSlots(), 0);
+    assertFalse(EEPROM_FAILED);
+    for (int i = 0; i < BAD_BLOCK_MAP_SIZE; ++i) {
+        assertEqual(EEPROM.read(BAD_BLOCK_MAP_ADDRESS + i), 0xFF);
+    }
+    assertEqual(EEPROM.read(BAD_BLOCK_MAP_MARKER_ADDRESS), BAD_BLOCK_MAP_MARKER);
+    cleanUp();
+}
@@ -0,0 +1,123 @@
+/*
+ * File: clock_calibration_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:52:21 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:58:23 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+
+/*
+ * Tests of the oscillator calibration (ClockCalibration.cpp): the host board
+ * clock is made to drift against the virtual real time, a simulated 1 PPS
+ * reference drives the calibration input, and the relay is timed in real time.
+ */
+
+#include <string>
+#include <ArduinoUnit.h>
+#include "../../src/constants.h"
+#include "../../src/ClockCalibration.h"
+#include "../../src/LampControl.h"
+#include "../../src/PresetStore.h"
+#include "../../src/TimerStateMachine.h"
+#include "../bench.h"
+
+namespace {
+    constexpr long DRIFT_PPM = 4700;   // a typical ceramic resonator
+
+    /** @brief One period of the reference: a 100 ms pulse, edges in real time. */
+    void referencePeriod(unsigned long periodMs = 1000) {
+        hal::gpio::set(REFERENCE_PIN, HIGH);
+        runInterrupt(referenceEdgeInterrupt);
+        bench::run(100);
+        hal::gpio::set(REFERENCE_PIN, LOW);
+        runInterrupt(referenceEdgeInterrupt);
+        bench::run(periodMs - 100);
+    }
+
+    /** @brief Runs a 10 s exposure over serial and returns the real relay-on time. */
+    unsigned long exposeTenSeconds() {
+        bench::command("SET DELAY 10000");
+        bench::resetRelay();
+        bench::command("START", 10500);
+        return bench::relay().lastOnMicros;
+    }
+
+    void restoreClock() {
+        hal::clock::setDriftPpm(0);
+        bench::command("CAL SET 0");
+    }
+}
+
+test(ClockCalibration_measures_the_drift_against_a_reference_pulse) {
+    bench::boot();
+    hal::clock::setDriftPpm(DRIFT_PPM);
+    assertEqual(bench::command("CAL START 8"), "OK");
+    for (int i = 0; i < 9; ++i) {
+        referencePeriod();
+    }
+    assertEqual(bench::command("CAL"), "CAL 4700 DONE 9");
+    assertEqual(getStoredClockPpm(), DRIFT_PPM);
+    loadClockCalibration(); // power cycle: the correction comes back from EEPROM
+    assertEqual(getClockPpm(), DRIFT_PPM);
+    restoreClock();
+}
+
+test(ClockCalibration_corrects_exposures_on_a_drifting_board) {
+    bench::boot();
+    hal::clock::setDriftPpm(DRIFT_PPM);
+    assertEqual(bench::command("CAL SET 0"), "OK");
+    unsigned long uncorrected = exposeTenSeconds();
+    assertLess(uncorrected, bench::lampMicrosFor(10000) - 45000UL);   // 47 ms short on a fast resonator
+
+    assertEqual(bench::command("CAL SET 4700"), "OK");
+    unsigned long corrected = exposeTenSeconds();
+    assertMoreOrEqual(corrected, bench::lampMicrosFor(10000));
+    assertLess(corrected, bench::lampMicrosFor(10000) + bench::LOOP_PERIOD_US + 1);
+
+    // Burn-in time is corrected as well
+    bench::command("SET DELAY 5000");
+    bench::resetRelay();
+    bench::command("START", 1000);
+    extendExposure(5000);
+    bench::run(9500);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertMoreOrEqual(bench::relay().lastOnMicros, bench::lampMicrosFor(5000) + 5000000UL);
+    assertLess(bench::relay().lastOnMicros, bench::lampMicrosFor(5000) + 5000000UL + bench::LOOP_PERIOD_US + 1);
+    restoreClock();
+}
+
+test(ClockCalibration_rejects_a_missing_or_wrong_reference) {
+    bench::boot();
+    assertEqual(bench::command("CAL SET 120"), "OK");
+    assertEqual(bench::command("CAL START"), "OK");
+    bench::run(3500);
+    assertEqual(bench::command("CAL"), "CAL 120 FAILED 0");
+
+    assertEqual(bench::command("CAL START 4"), "OK");
+    referencePeriod();
+    referencePeriod(500); // a 2 Hz signal is not the reference
+    referencePeriod();
+    assertEqual(bench::command("CAL").compare(0, 15, "CAL 120 FAILED "), 0);
+    assertEqual(bench::command("CAL SET 30000"), "ERR syntax");
+    assertEqual(getClockPpm(), 120L);
+    restoreClock();
+}
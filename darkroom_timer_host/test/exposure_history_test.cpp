@@ -0,0 +1,167 @@
+/*
+ * File: exposure_history_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:43:52 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:58:23 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+
+/*
+ * End-to-end tests of the exposure history (ExposureHistory.cpp): exposures
+ * run on the host sketch are read back from RAM, from the EEPROM log after a
+ * simulated power cycle, over the serial HIST command and on the LCD.
+ *
+ * The history lives for the whole test binary, so the tests only look at
+ * the exposures they run themselves (the newest records).
+ */
+
+#include <string>
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include <LiquidCrystal_I2C.h>
+#include "../../src/constants.h"
+#include "../../src/ButtonHandler.h"
+#include "../../src/ExposureHistory.h"
+#include "../../src/LampControl.h"
+#include "../../src/OutputScheduler.h"
+#include "../../src/TimerStateMachine.h"
+#include "../bench.h"
+
+namespace {
+    /** @brief Runs one exposure of delayMillis started over serial; aborts it after abortAfterMs if non-zero. */
+    void expose(long delayMillis, unsigned long abortAfterMs = 0) {
+        std::string line = "SET DELAY " + std::to_string(delayMillis);
+        bench::sendLine(line.c_str());
+        bench::resetRelay();
+        bench::sendLine("START", 0);
+        if (abortAfterMs == 0) {
+            bench::run(SAFELIGHT_LEAD_MS + delayMillis + 100);
+        } else {
+            bench::run(abortAfterMs);
+            bench::press(ROTARY_ENCODER_BUTTON_PIN);
+        }
+        bench::run(100); // idle: the records go to EEPROM
+    }
+
+    bool sameRecord(const ExposureRecord& a, const ExposureRecord& b) {
+        return a.sequence == b.sequence && a.startMillis == b.startMillis && a.requestedMillis == b.requestedMillis
+            && a.lampMicros == b.lampMicros && a.flags == b.flags;
+    }
+}
+
+test(History_records_requested_and_measured_lamp_time) {
+    bench::boot();
+    uint8_t before = historyCount();
+    expose(2000);
+    unsigned long completeLamp = bench::relay().lastOnMicros;
+    expose(9000, 1000);
+    unsigned long abortedLamp = bench::relay().lastOnMicros;
+    assertTrue(getTimerState() == TimerState::IDLE);
+
+    ExposureRecord complete;
+    ExposureRecord aborted;
+    assertTrue(getHistoryRecord(1, complete));
+    assertTrue(getHistoryRecord(0, aborted));
+    assertEqual(static_cast<int>(aborted.sequence), complete.sequence + 1);
+    assertEqual(historyCount(), min(before + 2, HISTORY_RAM_RECORDS + HISTORY_LOG_RECORDS));
+
+    assertEqual(complete.requestedMillis, 2000UL);
+    assertEqual(complete.lampMicros, completeLamp); // the relay edges the bench timed
+    assertMoreOrEqual(completeLamp, 2000000UL);
+    assertEqual(complete.flags, static_cast<uint8_t>(ExposureMode::LINEAR));
+
+    assertEqual(aborted.requestedMillis, 9000UL);
+    assertEqual(aborted.lampMicros, abortedLamp);
+    assertLess(abortedLamp, 2000000UL);
+    assertTrue(aborted.flags & HISTORY_ABORTED);
+    assertMore(aborted.startMillis, complete.startMillis + 2000UL);
+}
+
+test(History_is_written_only_while_idle_and_survives_a_power_cycle) {
+    bench::boot();
+    bench::sendLine("SET DELAY 3000");
+    bench::sendLine("START", 500);
+    unsigned long writes = hal::eeprom::writeCount();
+    bench::run(2000);
+    assertTrue(getTimerState() == TimerState::EXPOSING);
+    assertEqual(hal::eeprom::writeCount(), writes); // nothing is written while the lamp is on
+    bench::run(1000);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    bench::run(100);
+    assertMore(hal::eeprom::writeCount(), writes);
+
+    ExposureRecord newest;
+    ExposureRecord older;
+    assertTrue(getHistoryRecord(0, newest));
+    assertTrue(getHistoryRecord(1, older));
+    loadHistory(); // power cycle: the RAM ring is gone, the log is scanned again
+    assertMoreOrEqual(historyCount(), 2);
+    ExposureRecord restored;
+    assertTrue(getHistoryRecord(0, restored));
+    assertTrue(sameRecord(restored, newest));
+    assertTrue(getHistoryRecord(1, restored));
+    assertTrue(sameRecord(restored, older));
+
+    expose(1000);
+    assertTrue(getHistoryRecord(0, restored));
+    assertEqual(static_cast<int>(restored.sequence), newest.sequence + 1); // numbering goes on
+}
+
+test(History_is_dumped_over_serial_and_shown_on_the_lcd) {
+    bench::boot();
+    expose(1500);
+    ExposureRecord newest;
+    assertTrue(getHistoryRecord(0, newest));
+
+    hal::serial::reset();
+    bench::sendLine("HIST", 200);
+    std::string sent = hal::serial::transmitted();
+    size_t lines = 0;
+    for (size_t at = 0; (at = sent.find("\r\n", at)) != std::string::npos; at += 2) {
+        ++lines;
+    }
+    assertEqual(lines, static_cast<size_t>(historyCount() + 1));
+    std::string last = "HIST " + std::to_string(newest.sequence) + " " + std::to_string(newest.startMillis)
+                     + " 1500 " + std::to_string(newest.lampMicros) + " LINEAR DONE\r\n";
+    assertNotEqual(sent.find(last + '\0' + "OK\r\n"), std::string::npos); // newest last, then OK
+
+    // Encoder long press clears the delay, the next one opens the history
+    bench::press(ROTARY_ENCODER_BUTTON_PIN, ENCODER_LONG_PRESS_DELAY + 100);
+    assertEqual(timerDelay, 0L);
+    bench::run(DOUBLE_PRESS_WINDOW);
+    bench::press(ROTARY_ENCODER_BUTTON_PIN, ENCODER_LONG_PRESS_DELAY + 100);
+    assertTrue(getTimerState() == TimerState::HISTORY);
+    std::string title = "Exposure #" + std::to_string(newest.sequence);
+    assertEqual(std::string(hal::lcd::row(0)).compare(0, title.size(), title), 0);
+    assertEqual(std::string(hal::lcd::row(1)).compare(0, 18, "Set    1.5s LINEAR"), 0);
+    bench::turn(-1); // counterclockwise: one exposure back
+    title = "Exposure #" + std::to_string(newest.sequence - 1);
+    assertEqual(std::string(hal::lcd::row(0)).compare(0, title.size(), title), 0);
+
+    bench::press(TIMER_BUTTON_PIN); // closes the view without starting an exposure
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(hal::gpio::level(RELAY_PIN), LOW);
+    bench::press(ROTARY_ENCODER_BUTTON_PIN, ENCODER_LONG_PRESS_DELAY + 100);
+    assertTrue(getTimerState() == TimerState::HISTORY);
+    bench::run(HISTORY_VIEW_TIMEOUT + 100);
+    assertTrue(getTimerState() == TimerState::IDLE);
+}
@@ -0,0 +1,83 @@
+/*
+ * File: lamp_model_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 9:10:23 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:58:23 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * Tests of the lamp warm-up and afterglow compensation (LampControl.cpp,
+ * src/LampModel.h): the curve is interpolated between its points, and an
+ * exposure keeps the relay on for the requested time plus the compensation
+ * while showing only the requested time counting down.
+ *
+ * The checks follow whatever curve tools/fit_lamp_model.py generated.
+ */
+
+#include <ArduinoUnit.h>
+#include "../../src/constants.h"
+#include "../../src/LampControl.h"
+#include "../../src/LampModel.h"
+#include "../../src/OutputScheduler.h"
+#include "../../src/TimerStateMachine.h"
+#include "../bench.h"
+
+namespace {
+    constexpr uint8_t POINTS = sizeof(LAMP_COMPENSATION) / sizeof(LAMP_COMPENSATION[0]);
+
+    long pointMicros(uint8_t i) {
+        return LAMP_COMPENSATION[i].correction * 1000L / LAMP_CORRECTION_SCALE;
+    }
+
+    unsigned long pointRequest(uint8_t i) {
+        return LAMP_COMPENSATION[i].requestedMillis * 1000UL;
+    }
+}
+
+test(LampModel_curve_is_interpolated_between_its_points) {
+    assertEqual(lampCompensationMicros(0), 0L);
+    for (uint8_t i = 0; i < POINTS; ++i) {
+        assertEqual(lampCompensationMicros(pointRequest(i)), pointMicros(i));
+    }
+    for (uint8_t i = 1; i < POINTS; ++i) {
+        long middle = lampCompensationMicros((pointRequest(i - 1) + pointRequest(i)) / 2);
+        long expected = (pointMicros(i - 1) + pointMicros(i)) / 2;
+        assertLessOrEqual(abs(middle - expected), 63L);   // one step of the 1/16 ms table
+    }
+    assertEqual(lampCompensationMicros(TimerConfig::MAX_DELAY * 1000UL), pointMicros(POINTS - 1));
+    assertEqual(lampRestartMicros(), pointMicros(POINTS - 1));
+}
+
+test(LampModel_short_exposure_is_lengthened_but_shown_as_set) {
+    bench::boot();
+    bench::sendLine("SET DELAY 300");
+    bench::resetRelay();
+    bench::sendLine("START", SAFELIGHT_LEAD_MS + 100);
+    assertTrue(getTimerState() == TimerState::EXPOSING);
+    unsigned long shown = remainingExposureMicros();
+    assertLessOrEqual(shown, 300000UL - 80000UL);   // counts down the requested time only
+    bench::run(400);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    unsigned long expected = 300000UL + lampCompensationMicros(300000UL);
+    assertMoreOrEqual(bench::relay().lastOnMicros, expected);
+    assertLess(bench::relay().lastOnMicros, expected + bench::LOOP_PERIOD_US);
+}
@@ -0,0 +1,197 @@
+/*
+ * File: light_meter_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:58:39 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:58:23 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * End-to-end tests of the easel light meter (LightMeter.cpp): a level set on
+ * the simulated A0 input is sampled by the free-running conversions, metered
+ * from the METER state and turned into a suggested exposure and grade, or
+ * integrated by a light-integrating exposure.
+ */
+
+#include <string>
+#include <ArduinoUnit.h>
+#include <LiquidCrystal_I2C.h>
+#include "../../src/constants.h"
+#include "../../src/ExposureHistory.h"
+#include "../../src/ButtonHandler.h"
+#include "../../src/LampControl.h"
+#include "../../src/LightMeter.h"
+#include "../../src/OutputScheduler.h"
+#include "../../src/TimerStateMachine.h"
+#include "../bench.h"
+
+namespace {
+    /** @brief Timer button long press into manual focus, then an encoder press into the meter. */
+    void openMeter() {
+        bench::press(TIMER_BUTTON_PIN, TimerConfig::TURN_ENLARGER_LAMP_ON_DELAY + 100);
+        assertTrue(getTimerState() == TimerState::MANUAL_FOCUS);
+        bench::press(ROTARY_ENCODER_BUTTON_PIN);
+        bench::run(DOUBLE_PRESS_WINDOW);
+        assertTrue(getTimerState() == TimerState::METER);
+    }
+
+    /** @brief Puts a level on the sensor, waits for a fresh reading and takes it with a single press. */
+    void meter(double level) {
+        hal::analog::set(METER_ADC_CHANNEL, level);
+        bench::run(2 * METER_SAMPLES * METER_SAMPLE_US / 1000 + 1);
+        bench::press(ROTARY_ENCODER_BUTTON_PIN);
+        bench::run(DOUBLE_PRESS_WINDOW);
+    }
+
+    bool rowStartsWith(uint8_t row, const std::string& text) {
+        return std::string(hal::lcd::row(row)).compare(0, text.size(), text) == 0;
+    }
+}
+
+test(Meter_oversampling_resolves_a_fraction_of_an_ADC_step) {
+    bench::boot();
+    openMeter();
+    assertEqual(hal::gpio::level(RELAY_PIN), HIGH); // the meter reads the projected image
+    hal::analog::set(METER_ADC_CHANNEL, 300.25);
+    bench::run(2 * METER_SAMPLES * METER_SAMPLE_US / 1000 + 1);
+    assertEqual(lightReading(), static_cast<uint16_t>(4804)); // 300.25 x 16
+    bench::run(METER_VIEW_REFRESH_MS);
+    assertTrue(rowStartsWith(0, "Light       4804"));
+    assertTrue(rowStartsWith(3, "Press to read"));
+
+    bench::press(TIMER_BUTTON_PIN); // no readings: the delay stays
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(hal::gpio::level(RELAY_PIN), LOW);
+}
+
+test(Meter_suggests_the_exposure_and_grade_and_sets_the_timer) {
+    bench::boot();
+    openMeter();
+    meter(100.5);                     // highlight 1608: 10000000 / 1608 = 6219 ms
+    assertTrue(rowStartsWith(1, "Highlight   1608"));
+    assertTrue(rowStartsWith(2, "Shadow         -"));
+    assertTrue(rowStartsWith(3, "Set   6.2s"));
+    meter(800);                       // shadow 12800: ratio 7.96, grade 3
+    assertTrue(rowStartsWith(2, "Shadow     12800"));
+    assertTrue(rowStartsWith(3, "Set   6.2s grade 3"));
+    long delayMillis;
+    uint8_t grade;
+    assertTrue(meterSuggestion(delayMillis, grade));
+    assertEqual(delayMillis, 6200L);
+    assertEqual(grade, 3);
+
+    bench::turn(5); // the encoder does not touch the delay while metering
+    bench::press(TIMER_BUTTON_PIN);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(timerDelay, 6200L);
+    assertEqual(hal::gpio::level(RELAY_PIN), LOW);
+}
+
+test(Meter_long_press_leaves_without_setting_the_timer) {
+    bench::boot();
+    timerDelay = 4000;
+    openMeter();
+    meter(50);
+    bench::press(ROTARY_ENCODER_BUTTON_PIN, ENCODER_LONG_PRESS_DELAY + 100);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(timerDelay, 4000L);
+    assertEqual(hal::gpio::level(RELAY_PIN), LOW);
+    bench::run(DOUBLE_PRESS_WINDOW);
+}
+
+test(Dose_exposure_integrates_the_light_and_follows_a_sagging_lamp) {
+    bench::boot();
+    openMeter();
+    hal::analog::set(METER_ADC_CHANNEL, 200);
+    bench::run(2 * METER_SAMPLES * METER_SAMPLE_US / 1000 + 1);
+    hal::serial::reset();
+    bench::sendLine("DOSE REF");                 // the reference is the open meter's reading
+    assertNotEqual(hal::serial::transmitted().find("DOSE REF 3200\r\n"), std::string::npos);
+    bench::press(ROTARY_ENCODER_BUTTON_PIN, ENCODER_LONG_PRESS_DELAY + 100);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    bench::run(DOUBLE_PRESS_WINDOW);
+
+    bench::sendLine("DOSE ON");
+    bench::sendLine("SET DELAY 2000");
+    bench::resetRelay();
+    bench::sendLine("START", SAFELIGHT_LEAD_MS + 1000); // 1 s at the reference intensity...
+    hal::analog::set(METER_ADC_CHANNEL, 100);
+    bench::run(1500);                 // ...then the lamp sags to half: the second half takes 2 s
+    assertEqual(hal::gpio::level(RELAY_PIN), HIGH);
+    bench::run(1000);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(bench::relay().switchOns, 1UL);
+    assertMoreOrEqual(bench::relay().lastOnMicros, 2999000UL);
+    assertLessOrEqual(bench::relay().lastOnMicros, 3002000UL);
+    assertEqual(timerDelay, 2000L);
+
+    ExposureRecord record;
+    assertTrue(getHistoryRecord(0, record));
+    assertEqual(record.requestedMillis, 2000UL);
+    assertTrue(record.flags & HISTORY_DOSE);
+    assertFalse(record.flags & HISTORY_ABORTED);
+    bench::sendLine("DOSE OFF");
+}
+
+test(Dose_exposure_follows_burn_in_changes_while_running) {
+    bench::boot();
+    bench::sendLine("DOSE REF 3200");
+    bench::sendLine("DOSE ON");
+    bench::sendLine("SET DELAY 2000");
+    hal::analog::set(METER_ADC_CHANNEL, 200); // the reference intensity
+    bench::resetRelay();
+    bench::sendLine("START", SAFELIGHT_LEAD_MS + 500);
+    extendExposure(1000);
+    bench::run(2600);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertMoreOrEqual(bench::relay().lastOnMicros, 2999000UL);
+    assertLessOrEqual(bench::relay().lastOnMicros, 3002000UL);
+
+    bench::resetRelay();
+    bench::sendLine("START", SAFELIGHT_LEAD_MS + 500);
+    extendExposure(-5000);            // more than is left: ends at the next conversion
+    bench::run(10);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(bench::relay().switchOns, 1UL);
+    assertLessOrEqual(bench::relay().lastOnMicros, 522000UL);
+    bench::sendLine("DOSE OFF");
+}
+
+test(Dose_exposure_without_light_stops_at_the_safety_limit) {
+    bench::boot();
+    bench::sendLine("DOSE REF 3200");
+    bench::sendLine("DOSE ON");
+    bench::sendLine("SET DELAY 1000");
+    hal::analog::set(METER_ADC_CHANNEL, 0);   // sensor unplugged
+    bench::resetRelay();
+    bench::sendLine("START", SAFELIGHT_LEAD_MS + DOSE_TIME_LIMIT * 1000 - 100);
+    assertEqual(hal::gpio::level(RELAY_PIN), HIGH);
+    bench::run(200);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(hal::gpio::level(RELAY_PIN), LOW);
+    assertEqual(timerDelay, 1000L);
+
+    ExposureRecord record;
+    assertTrue(getHistoryRecord(0, record));
+    assertTrue(record.flags & HISTORY_DOSE);
+    assertTrue(record.flags & HISTORY_ABORTED);
+    bench::sendLine("DOSE OFF");
+}
@@ -0,0 +1,128 @@
+/*
+ * File: output_scheduler_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 9:17:19 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:58:23 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * Tests of the output channel scheduler (OutputScheduler.cpp): timed
+ * switches are applied in due-time order, switches due together land in the
+ * same loop() pass, and an exposure takes the safelight off before the lamp
+ * comes on, beeps at the end and brings the safelight back afterwards.
+ */
+
+#include <ArduinoUnit.h>
+#include "../../src/constants.h"
+#include "../../src/ButtonHandler.h"
+#include "../../src/LampControl.h"
+#include "../../src/OutputScheduler.h"
+#include "../../src/TimerStateMachine.h"
+#include "../bench.h"
+
+namespace {
+    bool on(uint8_t pin) {
+        return hal::gpio::level(pin) == HIGH;
+    }
+}
+
+test(Outputs_are_switched_in_due_order_and_together) {
+    bench::boot();
+    bench::run(SAFELIGHT_LAG_MS);   // nothing pending from earlier exposures
+    assertTrue(on(SAFELIGHT_PIN));
+    assertFalse(on(BUZZER_PIN));
+
+    assertTrue(scheduleOutputs(300, BUZZER_OUTPUT, SAFELIGHT_OUTPUT));
+    assertTrue(scheduleOutputs(100, BUZZER_OUTPUT, 0));
+    assertTrue(scheduleOutputs(200, 0, BUZZER_OUTPUT));
+    bench::run(150);
+    assertTrue(on(BUZZER_PIN));
+    assertTrue(on(SAFELIGHT_PIN));
+    bench::run(100);
+    assertFalse(on(BUZZER_PIN));
+    unsigned long buzzerEdges = hal::gpio::transitions(BUZZER_PIN);
+    unsigned long safelightEdges = hal::gpio::transitions(SAFELIGHT_PIN);
+    while (!on(BUZZER_PIN)) {
+        bench::run(1);
+    }
+    assertFalse(on(SAFELIGHT_PIN));   // the same pass
+    assertEqual(hal::gpio::transitions(BUZZER_PIN), buzzerEdges + 1);
+    assertEqual(hal::gpio::transitions(SAFELIGHT_PIN), safelightEdges + 1);
+
+    // Switching a channel now drops its pending switches, and only those
+    assertTrue(scheduleOutputs(100, SAFELIGHT_OUTPUT, BUZZER_OUTPUT));
+    switchOutputs(0, BUZZER_OUTPUT);
+    buzzerEdges = hal::gpio::transitions(BUZZER_PIN);
+    bench::run(200);
+    assertTrue(on(SAFELIGHT_PIN));
+    assertEqual(hal::gpio::transitions(BUZZER_PIN), buzzerEdges);
+
+    // The list is bounded
+    for (uint8_t i = 0; i < OUTPUT_EVENT_QUEUE_SIZE; ++i) {
+        assertTrue(scheduleOutputs(100 + i, BUZZER_OUTPUT, 0));
+    }
+    assertFalse(scheduleOutputs(50, BUZZER_OUTPUT, 0));
+    assertTrue(scheduleOutputs(100, 0, BUZZER_OUTPUT));   // joins a pending event
+    switchOutputs(0, BUZZER_OUTPUT);
+    bench::run(200);
+    assertFalse(on(BUZZER_PIN));
+}
+
+test(Outputs_exposure_dims_the_safelight_first_and_beeps_at_the_end) {
+    bench::boot();
+    bench::run(SAFELIGHT_LAG_MS);
+    bench::sendLine("SET DELAY 1000");
+    bench::resetRelay();
+    bench::sendLine("START");
+    assertTrue(getTimerState() == TimerState::ARMED);
+    assertFalse(on(SAFELIGHT_PIN));
+    assertFalse(on(RELAY_PIN));
+    bench::run(SAFELIGHT_LEAD_MS);
+    assertTrue(getTimerState() == TimerState::EXPOSING);
+    assertTrue(on(RELAY_PIN));
+
+    bench::run(bench::lampMicrosFor(1000) / 1000 + 50);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(bench::relay().switchOns, 1UL);
+    assertTrue(on(BUZZER_PIN));
+    assertFalse(on(SAFELIGHT_PIN));   // the paper goes into the developer first
+    bench::run(BUZZER_BEEP_MS);
+    assertFalse(on(BUZZER_PIN));
+    assertFalse(on(SAFELIGHT_PIN));
+    bench::run(SAFELIGHT_LAG_MS);
+    assertTrue(on(SAFELIGHT_PIN));
+}
+
+test(Outputs_aborted_exposure_does_not_beep) {
+    bench::boot();
+    bench::run(SAFELIGHT_LAG_MS);
+    bench::sendLine("SET DELAY 5000");
+    unsigned long beeps = hal::gpio::transitions(BUZZER_PIN);
+    bench::sendLine("START", SAFELIGHT_LEAD_MS + 500);
+    assertTrue(getTimerState() == TimerState::EXPOSING);
+    bench::sendLine("ABORT");
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertFalse(on(RELAY_PIN));
+    bench::run(SAFELIGHT_LAG_MS);
+    assertTrue(on(SAFELIGHT_PIN));
+    assertEqual(hal::gpio::transitions(BUZZER_PIN), beeps);
+}
@@ -0,0 +1,123 @@
+/*
+ * File: serial_command_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:31:09 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:58:23 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * End-to-end tests of the serial command interface (SerialCommands.cpp):
+ * command lines are fed to the emulated UART of the running sketch and the
+ * reply lines are read back from what it transmitted.
+ */
+
+#include <string>
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include "../../src/constants.h"
+#include "../../src/LampControl.h"
+#include "../../src/SerialCommands.h"
+#include "../../src/TimerStateMachine.h"
+#include "../bench.h"
+
+test(SerialCommand_sets_and_reads_the_delay) {
+    bench::boot();
+    assertEqual(bench::command("SET DELAY 3200"), "OK");
+    assertEqual(timerDelay, 3200L);
+    assertEqual(bench::command("get delay"), "DELAY 3200");
+    assertEqual(bench::command("SET DELAY 700000"), "ERR syntax");   // above TimerConfig::MAX_DELAY
+    assertEqual(bench::command("SET DELAY 12x"), "ERR syntax");
+    assertEqual(bench::command("SET DELAY"), "ERR syntax");
+    assertEqual(bench::command("FOCUS"), "ERR unknown command");
+    assertEqual(timerDelay, 3200L);
+}
+
+test(SerialCommand_remote_exposure_is_timed_like_the_button) {
+    bench::boot();
+    assertEqual(bench::command("SET DELAY 2000"), "OK");
+    bench::resetRelay();
+    assertEqual(bench::command("START"), "OK");
+    assertEqual(bench::command("SET DELAY 5000"), "ERR busy");
+    bench::run(2500);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(bench::relay().switchOns, 1UL);
+    unsigned long measured = bench::relay().lastOnMicros;
+    assertMoreOrEqual(measured, bench::lampMicrosFor(2000));
+    assertLess(measured, bench::lampMicrosFor(2000) + bench::LOOP_PERIOD_US);
+}
+
+test(SerialCommand_abort_stops_the_lamp) {
+    bench::boot();
+    assertEqual(bench::command("SET DELAY 9000"), "OK");
+    assertEqual(bench::command("START", 1000), "OK");
+    assertTrue(getTimerState() == TimerState::EXPOSING);
+    assertEqual(bench::command("ABORT"), "OK");
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(hal::gpio::level(RELAY_PIN), LOW);
+    assertEqual(timerDelay, 0L);      // as the encoder button leaves it
+    assertEqual(bench::command("GET DELAY"), "DELAY 0");
+    assertEqual(bench::command("ABORT"), "ERR state");
+}
+
+test(SerialCommand_preset_batch_is_stored_in_one_commit) {
+    bench::boot();
+    std::string original4 = bench::command("GET PRESET 4");
+    std::string original3 = bench::command("GET PRESET 3");
+    assertEqual(original4.compare(0, 9, "PRESET 4 "), 0);
+
+    unsigned long writes = hal::eeprom::writeCount();
+    assertEqual(bench::command("BEGIN"), "OK");
+    assertEqual(bench::command("PRESET 4 TEST 12300 FSTOP 50 60"), "OK");
+    assertEqual(bench::command("PROGRAM 3 10 20 30"), "OK");
+    assertEqual(bench::command("PRESET 4 TOOLONG 100 LINEAR"), "ERR syntax");
+    assertEqual(bench::command("PROGRAM 3 1 2 3 4 5"), "ERR syntax");   // more than PRESET_MAX_STEPS
+    assertEqual(hal::eeprom::writeCount(), writes);             // staged in RAM only
+    assertEqual(bench::command("GET PRESET 4"), "PRESET 4 TEST 12300 FSTOP 50 60");
+
+    assertEqual(bench::command("CANCEL"), "OK");
+    assertEqual(bench::command("GET PRESET 4"), original4);
+    assertEqual(bench::command("GET PRESET 3"), original3);
+    assertEqual(bench::command("COMMIT"), "ERR no batch");
+
+    assertEqual(bench::command("BEGIN"), "OK");
+    assertEqual(bench::command("PRESET 4 TEST 12300 FSTOP 50 60"), "OK");
+    assertEqual(bench::command("PROGRAM 3 10 20 30"), "OK");
+    assertEqual(bench::command("COMMIT"), "OK");
+    assertMore(hal::eeprom::writeCount(), writes);
+    assertEqual(bench::command("GET PRESET 4"), "PRESET 4 TEST 12300 FSTOP 50 60");
+    std::string program = bench::command("GET PRESET 3");
+    assertEqual(program.compare(program.size() - 9, 9, " 10 20 30"), 0);
+
+    // Put both presets back: a GET PRESET reply is a valid PRESET command
+    assertEqual(bench::command("BEGIN"), "OK");
+    assertEqual(bench::command(original4.c_str()), "OK");
+    assertEqual(bench::command(original3.c_str()), "OK");
+    assertEqual(bench::command("COMMIT"), "OK");
+    assertEqual(bench::command("GET PRESET 4"), original4);
+}
+
+test(SerialCommand_overlong_line_is_rejected_and_parsing_recovers) {
+    bench::boot();
+    std::string junk(COMMAND_LINE_SIZE + 20, 'X');
+    assertEqual(bench::command(junk.c_str()), "ERR line too long");
+    assertEqual(bench::command("DIAG").compare(0, 13, "DIAG state=0 "), 0);
+}
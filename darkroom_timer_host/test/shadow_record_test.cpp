@@ -0,0 +1,206 @@
+/*
+ * File: shadow_record_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:47:26 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:55:40 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/*
+ * Host-side fault-injection tests for the two-phase shadow record commit in
+ * MemoryUtils.cpp. The emulated EEPROM cuts the power after every possible
+ * number of byte writes; after each "reboot" the recovered record must be
+ * exactly the old or exactly the new one.
+ */
+
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include "../../src/constants.h"
+#include "../../src/MemoryUtils.h"
+
+namespace {
+    /** @brief A multi-field settings record, as the profile store would persist it. */
+    struct TestSettings {
+        int32_t delay;
+        uint16_t steps[3];
+        char name[5];
+        uint8_t preset;
+        uint8_t mode;
+    };
+
+    constexpr int TEST_RECORD_ADDRESS = 100;
+
+    TestSettings makeSettings(uint8_t seed) {
+        TestSettings settings;
+        memset(&settings, seed, sizeof(settings));
+        settings.delay = 1000L * seed;
+        settings.preset = seed;
+        return settings;
+    }
+
+    bool sameSettings(const TestSettings& a, const TestSettings& b) {
+        return memcmp(&a, &b, sizeof(TestSettings)) == 0;
+    }
+
+    ShadowRecord freshRecord() {
+        ShadowRecord record = {TEST_RECORD_ADDRESS, sizeof(TestSettings), SHADOW_SLOT_NONE, 0, 0};
+        return record;
+    }
+}
+
+test(ShadowRecord_blank_eeprom_has_no_record) {
+    hal::eeprom::reset();
+    ShadowRecord record = freshRecord();
+    TestSettings settings;
+    assertFalse(recoverShadowRecord(record, &settings));
+    assertEqual(record.activeSlot, SHADOW_SLOT_NONE);
+}
+
+test(ShadowRecord_recovers_latest_commit) {
+    hal::eeprom::reset();
+    ShadowRecord record = freshRecord();
+    for (uint8_t seed = 1; seed <= 5; ++seed) {
+        TestSettings settings = makeSettings(seed);
+        assertTrue(commitShadowRecord(record, &settings));
+    }
+    ShadowRecord rebooted = freshRecord();
+    TestSettings recovered;
+    assertTrue(recoverShadowRecord(rebooted, &recovered));
+    assertTrue(sameSettings(recovered, makeSettings(5)));
+    assertEqual(rebooted.activeSlot, record.activeSlot);
+}
+
+test(ShadowRecord_sequence_wraps_around) {
+    hal::eeprom::reset();
+    ShadowRecord record = freshRecord();
+    for (int i = 0; i < 600; ++i) {
+        TestSettings settings = makeSettings(i & 0x7F);
+        assertTrue(commitShadowRecord(record, &settings));
+        ShadowRecord rebooted = freshRecord();
+        TestSettings recovered;
+        assertTrue(recoverShadowRecord(rebooted, &recovered));
+        assertTrue(sameSettings(recovered, settings));
+    }
+}
+
+test(ShadowRecord_unchanged_commit_writes_nothing) {
+    hal::eeprom::reset();
+    ShadowRecord record = freshRecord();
+    TestSettings settings = makeSettings(7);
+    assertTrue(commitShadowRecord(record, &settings));
+    unsigned long writes = hal::eeprom::writeCount();
+    assertTrue(commitShadowRecord(record, &settings));
+    assertEqual(hal::eeprom::writeCount(), writes);
+}
+
+test(ShadowRecord_commit_writes_only_changed_cells) {
+    hal::eeprom::reset();
+    ShadowRecord record = freshRecord();
+    TestSettings first = makeSettings(1);
+    TestSettings second = makeSettings(2);
+    assertTrue(commitShadowRecord(record, &first));
+    assertTrue(commitShadowRecord(record, &second));
+
+    // The inactive slot still holds `first`; change a single field of it.
+    TestSettings third = first;
+    third.preset = 42;
+    unsigned long writes = hal::eeprom::writeCount();
+    assertTrue(commitShadowRecord(record, &third));
+    // invalidate marker + 1 payload byte + checksum + commit marker
+    assertLessOrEqual(hal::eeprom::writeCount() - writes, 4UL);
+}
+
+test(ShadowRecord_stepped_commit_writes_one_cell_per_call) {
+    hal::eeprom::reset();
+    ShadowRecord record = freshRecord();
+    TestSettings first = makeSettings(1);
+    assertTrue(commitShadowRecord(record, &first));
+
+    TestSettings second = makeSettings(2);
+    unsigned long calls = 0;
+    unsigned long writes = hal::eeprom::writeCount();
+    while (stepShadowCommit(record, &second)) {
+        assertLessOrEqual(hal::eeprom::writeCount() - writes, 1UL);
+        writes = hal::eeprom::writeCount();
+        ++calls;
+        ShadowRecord rebooted = freshRecord(); // a power cut between calls keeps the old record
+        TestSettings recovered;
+        assertTrue(recoverShadowRecord(rebooted, &recovered));
+        assertTrue(sameSettings(recovered, first));
+    }
+    assertMoreOrEqual(calls, 2UL);
+    assertEqual(record.commitStep, 0);
+
+    ShadowRecord rebooted = freshRecord();
+    TestSettings recovered;
+    assertTrue(recoverShadowRecord(rebooted, &recovered));
+    assertTrue(sameSettings(recovered, second));
+    assertFalse(stepShadowCommit(record, &second)); // unchanged: nothing to do
+}
+
+test(ShadowRecord_power_cut_at_every_byte_boundary) {
+    for (int tear = 0; tear <= 1; ++tear) {
+        const TestSettings oldSettings = makeSettings(0x11);
+        const TestSettings newSettings = makeSettings(0x22);
+
+        // Both slots committed, old settings active.
+        hal::eeprom::reset();
+        ShadowRecord record = freshRecord();
+        TestSettings older = makeSettings(0x33);
+        assertTrue(commitShadowRecord(record, &older));
+        assertTrue(commitShadowRecord(record, &oldSettings));
+        uint8_t snapshot[HOST_EEPROM_SIZE];
+        memcpy(snapshot, hal::eeprom::cells(), sizeof(snapshot));
+
+        // How many byte writes does an uninterrupted commit take?
+        unsigned long before = hal::eeprom::writeCount();
+        assertTrue(commitShadowRecord(record, &newSettings));
+        unsigned long totalWrites = hal::eeprom::writeCount() - before;
+        assertMore(totalWrites, sizeof(TestSettings));
+
+        for (unsigned long cut = 0; cut <= totalWrites; ++cut) {
+            memcpy(hal::eeprom::cells(), snapshot, sizeof(snapshot));
+            ShadowRecord running = freshRecord();
+            TestSettings ignored;
+            assertTrue(recoverShadowRecord(running, &ignored));
+
+            hal::eeprom::powerCutAfter(cut, tear != 0);
+            commitShadowRecord(running, &newSettings);
+            hal::eeprom::powerOn();
+
+            // Reboot
+            ShadowRecord rebooted = freshRecord();
+            TestSettings recovered;
+            assertTrue(recoverShadowRecord(rebooted, &recovered));
+            if (cut < totalWrites) {
+                assertTrue(sameSettings(recovered, oldSettings));
+            } else {
+                assertTrue(sameSettings(recovered, newSettings));
+            }
+
+            // The store must stay usable after recovery.
+            TestSettings next = makeSettings(0x44);
+            assertTrue(commitShadowRecord(rebooted, &next));
+            ShadowRecord again = freshRecord();
+            assertTrue(recoverShadowRecord(again, &recovered));
+            assertTrue(sameSettings(recovered, next));
+        }
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ * File: shared_value_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:08:29 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:08:29 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * Host-side concurrency stress tests for SharedValue. The simulated interrupt
+ * handler runs on a second thread through runInterrupt(), so the main thread
+ * and the "ISR" genuinely race. The payload is wider than a machine word (as
+ * a long is on the AVR) and every word carries the same number, so any torn
+ * copy is visible as a mix of two numbers.
+ */
+
+#include <atomic>
+#include <thread>
+#include <ArduinoUnit.h>
+#include "../../src/constants.h"
+#include "../../src/SharedValue.h"
+
+namespace {
+    constexpr int PAYLOAD_WORDS = 256;
+    constexpr uint32_t STRESS_WRITES = 200000;
+
+    struct Payload {
+        uint32_t words[PAYLOAD_WORDS];
+    };
+
+    Payload makePayload(uint32_t number) {
+        Payload payload;
+        for (int i = 0; i < PAYLOAD_WORDS; ++i) {
+            payload.words[i] = number;
+        }
+        return payload;
+    }
+
+    bool consistent(const Payload& payload) {
+        for (int i = 1; i < PAYLOAD_WORDS; ++i) {
+            if (payload.words[i] != payload.words[0]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    SharedValue<Payload> shared;
+    uint32_t isrNumber;
+    uint32_t isrTornReads;
+    uint32_t isrLastSeen;
+
+    void isrWriter() {
+        shared.writeFromISR(makePayload(++isrNumber));
+    }
+
+    void isrReader() {
+        Payload seen = shared.read();
+        if (!consistent(seen) || seen.words[0] < isrLastSeen) {
+            ++isrTornReads;
+        }
+        isrLastSeen = seen.words[0];
+    }
+}
+
+test(SharedValue_assignment_and_read) {
+    SharedValue<long> value(1500);
+    assertEqual(value.read(), 1500L);
+    value = -250;
+    assertEqual(static_cast<long>(value), -250L);
+    value.writeFromISR(86400000L);
+    assertEqual(value.read(), 86400000L);
+}
+
+test(SharedValue_main_loop_reads_during_isr_writes) {
+    shared.write(makePayload(0));
+    isrNumber = 0;
+    std::atomic<bool> done(false);
+    std::thread isr([&done]() {
+        for (uint32_t i = 0; i < STRESS_WRITES; ++i) {
+            runInterrupt(isrWriter);
+        }
+        done = true;
+    });
+
+    uint32_t reads = 0;
+    uint32_t tornReads = 0;
+    uint32_t lastSeen = 0;
+    while (!done) {
+        Payload seen = shared.read();
+        if (!consistent(seen) || seen.words[0] < lastSeen) {
+            ++tornReads;
+        }
+        lastSeen = seen.words[0];
+        ++reads;
+    }
+    isr.join();
+
+    assertEqual(tornReads, 0U);
+    assertMore(reads, 0U);
+    assertEqual(shared.read().words[0], STRESS_WRITES);
+}
+
+test(SharedValue_isr_reads_during_main_loop_writes) {
+    shared.write(makePayload(0));
+    isrTornReads = 0;
+    isrLastSeen = 0;
+    std::atomic<bool> done(false);
+    std::thread isr([&done]() {
+        while (!done) {
+            runInterrupt(isrReader);
+        }
+    });
+
+    for (uint32_t number = 1; number <= STRESS_WRITES; ++number) {
+        shared.write(makePayload(number));
+    }
+    done = true;
+    isr.join();
+
+    assertEqual(isrTornReads, 0U);
+    assertEqual(shared.read().words[0], STRESS_WRITES);
+}
@@ -0,0 +1,170 @@
+/*
+ * File: sketch_session_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:12:51 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:57:09 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * End-to-end tests of the complete sketch on the host: setup() and loop() of
+ * darkroom_timer.ino run against the virtual-time HAL, driven by the bench
+ * (buttons, encoder) while the relay edges are timed on the virtual clock.
+ */
+
+#include <chrono>
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include <LiquidCrystal_I2C.h>
+#include "../../src/constants.h"
+#include "../../src/ButtonHandler.h"
+#include "../../src/LampControl.h"
+#include "../../src/OutputScheduler.h"
+#include "../../src/PresetStore.h"
+#include "../../src/TimerStateMachine.h"
+#include "../bench.h"
+
+namespace {
+    /** @brief Clears the delay (encoder long press) and dials it in with slow, fine detents. */
+    void dialDelay(long delayMillis) {
+        if (timerDelay != 0 || getActivePresetIndex() != NO_PRESET) {
+            bench::press(ROTARY_ENCODER_BUTTON_PIN, ENCODER_LONG_PRESS_DELAY + 100); // at zero it opens the history
+        }
+        bench::turn(static_cast<int>(delayMillis / TimerConfig::INCREMENT));
+    }
+
+    bool exposedFor(long delayMillis) {
+        unsigned long expected = bench::lampMicrosFor(delayMillis);
+        unsigned long measured = bench::relay().lastOnMicros;
+        // The relay goes off on the first loop() pass at or after the deadline
+        return measured >= expected && measured < expected + bench::LOOP_PERIOD_US;
+    }
+}
+
+test(Sketch_boots_to_idle_screen) {
+    bench::boot();
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(hal::gpio::level(RELAY_PIN), LOW);
+    assertTrue(hal::lcd::backlight());
+    assertTrue(strstr(hal::lcd::row(3), "SEC") != nullptr);
+}
+
+test(Sketch_encoder_sets_delay_in_fine_steps) {
+    bench::boot();
+    dialDelay(2500);
+    assertEqual(timerDelay, 2500L);
+    bench::turn(-5);
+    assertEqual(timerDelay, 2000L);
+}
+
+test(Sketch_exposure_keeps_relay_on_for_the_set_time) {
+    bench::boot();
+    dialDelay(2000);
+    bench::resetRelay();
+    hal::gpio::set(TIMER_BUTTON_PIN, LOW);
+    bench::run(100);
+    hal::gpio::set(TIMER_BUTTON_PIN, HIGH);
+    bench::run(1000);
+    assertTrue(getTimerState() == TimerState::EXPOSING);
+    assertFalse(hal::lcd::backlight()); // no light leaks while the paper is exposed
+    bench::run(2000);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(bench::relay().switchOns, 1UL);
+    assertTrue(exposedFor(2000));
+    assertTrue(hal::lcd::backlight());
+    assertEqual(timerDelay, 2000L); // ready to repeat the exposure
+}
+
+test(Sketch_paused_exposure_adds_up_to_the_set_time) {
+    bench::boot();
+    dialDelay(4000);
+    bench::resetRelay();
+    bench::press(TIMER_BUTTON_PIN);
+    bench::run(1000);
+    bench::press(TIMER_BUTTON_PIN); // pause
+    assertTrue(getTimerState() == TimerState::PAUSED);
+    bench::run(3000);
+    bench::press(TIMER_BUTTON_PIN); // resume
+    bench::run(5000);
+    assertTrue(getTimerState() == TimerState::IDLE);
+    assertEqual(bench::relay().switchOns, 2UL);
+    unsigned long long expected = bench::lampMicrosFor(4000, 2); // the lamp warms up twice
+    assertMoreOrEqual(bench::relay().onMicros, expected);
+    assertLess(bench::relay().onMicros, expected + bench::LOOP_PERIOD_US);
+}
+
+test(Sketch_preset_delay_is_committed_once_idle) {
+    bench::boot();
+    selectPreset(0);
+    long delayMillis = getPreset(0).delay + 1500;
+    bench::turn(15);
+    assertEqual(timerDelay, delayMillis);
+    bench::press(TIMER_BUTTON_PIN);
+    assertEqual(getPreset(0).delay, delayMillis);
+    bench::run(SAFELIGHT_LEAD_MS + delayMillis + 1000);
+    assertTrue(getTimerState() == TimerState::IDLE);
+
+    unsigned long writes = hal::eeprom::writeCount(); // the history record is in the log by now
+    bench::run(PRESET_COMMIT_DELAY - SAFELIGHT_LEAD_MS - delayMillis - 2000);
+    assertEqual(hal::eeprom::writeCount(), writes);
+    bench::run(2000);
+    assertMore(hal::eeprom::writeCount(), writes);
+    loadPresets(); // as at the next boot
+    assertEqual(getPreset(0).delay, delayMillis);
+    selectPreset(NO_PRESET);
+}
+
+test(Sketch_simulated_darkroom_hour) {
+    bench::boot();
+    const unsigned long long start = hal::clock::now();
+    const unsigned long long startLoops = bench::loops();
+    const auto wallStart = std::chrono::steady_clock::now();
+    unsigned long prints = 0;
+    unsigned long inaccurate = 0;
+
+    while (hal::clock::now() - start < 3600ULL * 1000000) {
+        // Focus and compose under the enlarger lamp
+        bench::press(TIMER_BUTTON_PIN, TimerConfig::TURN_ENLARGER_LAMP_ON_DELAY + 100);
+        assertTrue(getTimerState() == TimerState::MANUAL_FOCUS);
+        bench::run(20000);
+        bench::press(TIMER_BUTTON_PIN);
+        assertTrue(getTimerState() == TimerState::IDLE);
+
+        // A test strip: five exposures, then the print itself
+        long delayMillis = 2000 + 700 * (prints % 9);
+        dialDelay(delayMillis);
+        for (int strip = 0; strip < 6; ++strip) {
+            bench::press(TIMER_BUTTON_PIN);
+            bench::run(SAFELIGHT_LEAD_MS + delayMillis + 200);
+            inaccurate += exposedFor(delayMillis) ? 0 : 1;
+            bench::run(3000); // move the card
+        }
+        ++prints;
+        bench::run(90000); // develop, stop, fix
+    }
+
+    const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    printf("  simulated hour: %lu prints, %llu loop() passes, %.0f ms wall clock\n",
+           prints, bench::loops() - startLoops, wallMs);
+    assertMore(prints, 10UL);
+    assertEqual(inaccurate, 0UL);
+    assertTrue(getTimerState() == TimerState::IDLE);
+}
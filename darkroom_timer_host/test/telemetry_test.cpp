@@ -0,0 +1,162 @@
+/*
+ * File: telemetry_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:33:38 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 10:03:11 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * Host tests for the telemetry stream (Telemetry.cpp), switched on with the
+ * TELEM command in the running sketch and decoded from the emulated UART.
+ */
+
+#include <vector>
+#include <ArduinoUnit.h>
+#include "../../src/constants.h"
+#include "../../src/SerialOutput.h"
+#include "../../src/Telemetry.h"
+#include "../../src/TimerStateMachine.h"
+#include "../bench.h"
+
+namespace {
+    /** @brief A decoded telemetry sample (field layout in Telemetry.h). */
+    struct Sample {
+        uint16_t sequence;
+        uint32_t millis;
+        uint8_t state;
+        uint8_t flags;
+        uint32_t remainingMicros;
+        int32_t delayMillis;
+        uint16_t loopMax;
+        uint16_t loops;
+    };
+
+    uint32_t field(const std::vector<uint8_t>& payload, size_t at, size_t size) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < size; ++i) {
+            value |= static_cast<uint32_t>(payload[at + i]) << (8 * i);
+        }
+        return value;
+    }
+
+    std::vector<Sample> sentSamples() {
+        std::vector<Sample> samples;
+        for (const bench::Frame& frame : bench::sentFrames()) {
+            if (frame.type != static_cast<uint8_t>(FrameType::TELEMETRY) || frame.payload.size() != 25) {
+                continue;
+            }
+            const std::vector<uint8_t>& p = frame.payload;
+            Sample sample = {
+                static_cast<uint16_t>(field(p, 0, 2)), field(p, 2, 4), p[6], p[7], field(p, 8, 4),
+                static_cast<int32_t>(field(p, 12, 4)), static_cast<uint16_t>(field(p, 16, 2)),
+                static_cast<uint16_t>(field(p, 18, 2))
+            };
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+}
+
+test(Telemetry_streams_at_the_configured_rate) {
+    bench::boot();
+    hal::serial::reset();
+    bench::sendLine("TELEM 100", 5);
+    bench::run(1000);
+    bench::sendLine("TELEM 0", 5);
+
+    std::vector<Sample> samples = sentSamples();
+    assertMoreOrEqual(samples.size(), 10u);
+    assertLessOrEqual(samples.size(), 11u);
+    for (size_t i = 1; i < samples.size(); ++i) {
+        assertEqual(samples[i].sequence, static_cast<uint16_t>(samples[i - 1].sequence + 1));
+        assertEqual(samples[i].millis - samples[i - 1].millis, 100u);
+        assertEqual(samples[i].loops, 100000u / bench::LOOP_PERIOD_US);
+        assertEqual(samples[i].loopMax, bench::LOOP_PERIOD_US);
+        assertEqual(samples[i].state, static_cast<uint8_t>(TimerState::IDLE));
+    }
+
+    size_t sent = hal::serial::transmitted().size();
+    bench::run(500);
+    assertEqual(hal::serial::transmitted().size(), sent);   // stopped
+}
+
+test(Telemetry_reports_the_running_exposure) {
+    bench::boot();
+    bench::sendLine("SET DELAY 3000", 5);
+    hal::serial::reset();
+    bench::sendLine("TELEM 250", 5);
+    bench::sendLine("START", 5);
+    bench::run(2000);
+    bench::sendLine("TELEM 0", 5);
+    bench::run(1500);
+
+    std::vector<Sample> samples = sentSamples();
+    assertMoreOrEqual(samples.size(), 6u);
+    uint32_t lastRemaining = 0xFFFFFFFF;
+    unsigned exposing = 0;
+    for (const Sample& sample : samples) {
+        if (sample.state != static_cast<uint8_t>(TimerState::EXPOSING)) {
+            continue;
+        }
+        ++exposing;
+        assertEqual(sample.flags & 0x01, 1);   // relay on
+        assertLess(sample.remainingMicros, lastRemaining);
+        assertLessOrEqual(sample.remainingMicros, 3000000u);
+        lastRemaining = sample.remainingMicros;
+    }
+    assertMoreOrEqual(exposing, 6u);
+}
+
+test(Telemetry_reports_a_slow_pass_after_the_pass_count_saturates) {
+    bench::boot();
+    hal::serial::reset();
+    setTelemetryPeriod(60000);
+    bench::run(40000);                  // 80000 passes, the count is stuck at 0xFFFF
+    hal::clock::advance(5000);          // one slow pass late in the period
+    bench::run(20100);
+    setTelemetryPeriod(0);
+    bench::run(100);
+
+    std::vector<Sample> samples = sentSamples();
+    assertEqual(samples.size(), 1u);
+    assertEqual(samples[0].loops, 0xFFFFu);
+    assertMoreOrEqual(samples[0].loopMax, 5000u);
+}
+
+test(Telemetry_skips_samples_instead_of_dropping_other_output) {
+    bench::boot();
+    setTelemetryPeriod(TELEMETRY_MIN_PERIOD_MS);
+    // Fill the transmit ring without letting loop() drain it
+    const uint8_t filler[SERIAL_FRAME_MAX_PAYLOAD] = {1};
+    while (queueSerialFrame(FrameType::LOG, filler, sizeof(filler))) {
+    }
+    uint16_t dropped = droppedSerialFrames();
+    for (int i = 0; i < 100; ++i) {
+        hal::clock::advance(1000);
+        tickTelemetry();
+    }
+    assertEqual(droppedSerialFrames(), dropped);   // only the probe frame that found the ring full
+    setTelemetryPeriod(0);
+    bench::run(100);
+    queueSerialFrame(FrameType::LOG, filler, 1);   // sends the pending drop report, later tests start clean
+    bench::run(100);
+}
@@ -0,0 +1,127 @@
+/*
+ * File: token_log_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:26:40 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:35:28 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * Host tests for the tokenized debug log (TokenLog.h) and the non-blocking
+ * serial transmit ring it writes to (SerialOutput.cpp). The bytes the firmware
+ * hands to the emulated UART are decoded by the bench the way
+ * tools/log_decoder.py does it.
+ */
+
+#include <vector>
+#include <ArduinoUnit.h>
+#include "../../src/TokenLog.h"
+#include "../bench.h"
+
+namespace {
+    /** @brief Lets the UART send everything still queued, as loop() would. */
+    void drain() {
+        size_t sent;
+        do {
+            sent = hal::serial::transmitted().size();
+            hal::clock::advance(10000);
+            flushSerialOutput();
+        } while (hal::serial::transmitted().size() != sent);
+    }
+
+    uint32_t readLong(const std::vector<uint8_t>& payload, size_t at) {
+        return payload[at] | (payload[at + 1] << 8) | (static_cast<uint32_t>(payload[at + 2]) << 16) |
+               (static_cast<uint32_t>(payload[at + 3]) << 24);
+    }
+}
+
+test(TokenLog_record_carries_id_timestamp_and_raw_arguments) {
+    drain();
+    hal::serial::reset();
+    const char* format = PSTR("delay %ld ms, %s, x%u, %c, gain %f");
+    unsigned long loggedAt = micros();
+    logRecord(format, -1500L, "CW", 256u, 'k', 2.5);
+    drain();
+
+    std::vector<bench::Frame> frames = bench::sentFrames();
+    assertEqual(frames.size(), 1u);
+    const std::vector<uint8_t>& payload = frames[0].payload;
+    assertEqual(frames[0].type, static_cast<uint8_t>(FrameType::LOG));
+    assertEqual(payload.size(), 2u + 4u + 4u + 3u + 4u + 4u + 4u);
+    assertEqual(payload[0] | (payload[1] << 8), static_cast<uint16_t>(reinterpret_cast<uintptr_t>(format)));
+    assertEqual(readLong(payload, 2), static_cast<uint32_t>(loggedAt));
+    assertEqual(static_cast<int32_t>(readLong(payload, 6)), -1500);
+    assertTrue(memcmp(&payload[10], "CW", 3) == 0);
+    assertEqual(readLong(payload, 13), 256u);   // zero bytes survive the COBS stuffing
+    assertEqual(readLong(payload, 17), static_cast<uint32_t>('k'));
+    float gain;
+    uint32_t bits = readLong(payload, 21);
+    memcpy(&gain, &bits, sizeof(gain));
+    assertTrue(gain == 2.5f);
+}
+
+test(TokenLog_long_string_argument_is_truncated) {
+    drain();
+    hal::serial::reset();
+    logRecord(PSTR("%s"), "a string much longer than the limit");
+    drain();
+
+    std::vector<bench::Frame> frames = bench::sentFrames();
+    assertEqual(frames.size(), 1u);
+    assertEqual(frames[0].payload.size(), 6u + LOG_STRING_ARG_MAX + 1u);
+    assertEqual(frames[0].payload.back(), 0);
+}
+
+test(SerialOutput_never_blocks_and_reports_dropped_frames) {
+    drain();
+    hal::serial::reset();
+    uint16_t droppedBefore = droppedSerialFrames();
+
+    // A burst far larger than the ring and the UART buffer, with no time passing
+    const int burst = 40;
+    for (int i = 0; i < burst; ++i) {
+        logRecord(PSTR("burst %d"), i);
+    }
+    flushSerialOutput();
+    assertEqual(hal::serial::transmitted().size(), 63u);  // only what the UART buffer takes
+    uint16_t dropped = droppedSerialFrames() - droppedBefore;
+    assertMore(dropped, 0);
+
+    // The flush made room: the drop report goes out ahead of the next record
+    logRecord(PSTR("after the burst"));
+    drain();
+
+    std::vector<bench::Frame> frames = bench::sentFrames();
+    assertEqual(frames.size(), static_cast<size_t>(burst - dropped + 2));
+    for (size_t i = 0; i < frames.size(); ++i) {
+        assertNotEqual(frames[i].type, 0);  // every frame that went out is intact
+    }
+    // Records arrive in order: the ones that fit, the drop count, the next record
+    int32_t expected = 0;
+    for (size_t i = 0; i < frames.size() - 2; ++i) {
+        assertEqual(frames[i].type, static_cast<uint8_t>(FrameType::LOG));
+        assertEqual(static_cast<int32_t>(readLong(frames[i].payload, 6)), expected++);
+    }
+    const bench::Frame& report = frames[frames.size() - 2];
+    assertEqual(report.type, static_cast<uint8_t>(FrameType::DROPPED));
+    assertEqual(report.payload[0] | (report.payload[1] << 8), dropped);
+    assertEqual(frames.back().type, static_cast<uint8_t>(FrameType::LOG));
+}
@@ -0,0 +1,106 @@
+/*
+ * File: wear_leveling_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 9:36:38 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:47:58 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+/*
+ * Host tests of the EEPROM wear leveling ring (MemoryUtils.cpp): every store
+ * goes to the next slot with the next sequence number, and after a reboot
+ * restoreEEPROMAddress() restores the newest delay and goes on after it,
+ * lap after lap.
+ *
+ * The tests save and restore the globals they touch and leave a blank
+ * EEPROM behind for the sketch tests.
+ */
+
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include "../../src/constants.h"
+#include "../../src/MemoryUtils.h"
+
+namespace {
+    int slotAddress(int slot) {
+        return EEPROM_START_ADDRESS + slot * EEPROM_SLOT_SIZE;
+    }
+
+    /** @brief Stores a new delay as an exposure start would, past the write throttle. */
+    void store(long delayMillis) {
+        timerDelay = delayMillis;
+        storeTimerDelay(lastEEPROMWrite + TimerConfig::EEPROM_WRITE_DELAY);
+    }
+
+    /** @brief The firmware globals these tests change. */
+    struct Saved {
+        long timerDelay = ::timerDelay;
+        long storedTimerDelay = ::storedTimerDelay;
+        unsigned long lastEEPROMWrite = ::lastEEPROMWrite;
+        int eeAddress = ::eeAddress;
+
+        void restore() {
+            hal::eeprom::reset();
+            restoreEEPROMAddress();
+            ::timerDelay = timerDelay;
+            ::storedTimerDelay = storedTimerDelay;
+            ::lastEEPROMWrite = lastEEPROMWrite;
+            ::eeAddress = eeAddress;
+        }
+    };
+}
+
+test(WearLeveling_reboot_resumes_after_the_newest_slot) {
+    Saved saved;
+    hal::eeprom::reset();
+    restoreEEPROMAddress();
+    assertEqual(eeAddress, EEPROM_START_ADDRESS);
+    store(1000);
+    store(2000);
+    store(3000);
+    assertEqual(eeAddress, slotAddress(2));
+
+    timerDelay = 0;
+    restoreEEPROMAddress();                        // reboot
+    assertEqual(timerDelay, 3000L);
+    assertEqual(storedTimerDelay, 3000L);
+    assertEqual(eeAddress, slotAddress(2));
+    store(4000);
+    assertEqual(eeAddress, slotAddress(3));        // not back at the start of the ring
+    saved.restore();
+}
+
+test(WearLeveling_reboot_finds_the_newest_slot_after_a_lap) {
+    Saved saved;
+    hal::eeprom::reset();
+    restoreEEPROMAddress();
+    for (int i = 0; i < EEPROM_SLOT_COUNT + 3; ++i) {
+        store(1000 + 100 * (i % 2));
+    }
+    store(5000);                                   // slot 3 of the second lap
+    restoreEEPROMAddress();
+    assertEqual(timerDelay, 5000L);
+    assertEqual(eeAddress, slotAddress(3));
+    // The sequence byte changes on every store: two laps over the first slots, one over the last
+    assertEqual(hal::eeprom::wear(slotAddress(0) + 3), 2UL);
+    assertEqual(hal::eeprom::wear(slotAddress(EEPROM_SLOT_COUNT - 1) + 3), 1UL);
+    saved.restore();
+}
@@ -0,0 +1,307 @@
+/*
+ * File: eeprom_wear_sim.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:49:17 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:55:40 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/*
+ * Host-side EEPROM wear simulator.
+ *
+ * Links the firmware sources against the emulated EEPROM in hal/ with a
+ * finite, randomly distributed endurance per cell, then replays years of
+ * darkroom sessions through the same calls the firmware makes:
+ *
+ *   boot:      restoreEEPROMAddress(), loadPresets(), loadHistory() (as setup())
+ *   exposure:  storeTimerDelay() and updateActivePresetDelay() (as the timer
+ *              state machine entering ARMED), then idle loop passes until the
+ *              next exposure: tickHistory() copies the record to the log, and
+ *              tickPresets() commits a changed preset delay once it is due.
+ *
+ * Nothing is modelled: the ring, the preset store layout and the write
+ * throttle are the firmware's own, so the projection follows any change to them.
+ *
+ * It reports a per-cell wear histogram per EEPROM region, the time to the first
+ * retired slot, the time to EEPROM_FAILED and a projected lifetime.
+ *
+ * Usage: eeprom_wear_sim [--years N] [--exposures-per-day N]
+ *                        [--change-rate P] [--preset-rate P] [--reboots-per-day N] [--mean-gap S]
+ *                        [--endurance N] [--sigma N] [--min-endurance N]
+ *                        [--early-failure P] [--seed N]
+ */
+
+#include <random> // before Arduino.h, which defines min()/max() as macros
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "../../src/constants.h"
+#include "../../src/ExposureHistory.h"
+#include "../../src/MemoryUtils.h"
+#include "../../src/PresetStore.h"
+
+namespace {
+
+struct Options {
+    double years = 100;               // simulation horizon
+    double exposuresPerDay = 40;      // mean number of exposures started per day
+    double changeRate = 0.5;          // probability that the delay changed since the last exposure
+    double presetRate = 0.5;          // probability that a preset is active (its delay follows the timer)
+    double rebootsPerDay = 1;         // power cycles per day (0 = never switched off)
+    double meanGapSeconds = 90;       // mean time between two exposures
+    double endurance = 300000;        // mean endurance of a cell (program cycles)
+    double sigma = 50000;             // standard deviation of the endurance
+    double minEndurance = 100000;     // datasheet minimum, lower tail is clipped here
+    double earlyFailure = 0.001;      // probability that a cell fails early (uniform below the minimum)
+    unsigned long seed = 73;
+};
+
+struct Region {
+    const char* name;
+    int start;
+    int end;
+};
+
+const Region REGIONS[] = {
+    {"header", 0, BAD_BLOCK_MAP_ADDRESS},
+    {"bad-block map", BAD_BLOCK_MAP_ADDRESS, EEPROM_START_ADDRESS},
+    {"wear leveling ring", EEPROM_START_ADDRESS, EEPROM_END_ADDRESS},
+    {"exposure history", HISTORY_LOG_ADDRESS, PRESET_STORE_ADDRESS},
+    {"preset store", PRESET_STORE_ADDRESS, EEPROM_SIZE},
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* name = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", name);
+            return false;
+        }
+        const char* value = argv[++i];
+        double number = atof(value);
+        if (!strcmp(name, "--years")) { options.years = number;
+        } else if (!strcmp(name, "--exposures-per-day")) { options.exposuresPerDay = number;
+        } else if (!strcmp(name, "--change-rate")) { options.changeRate = number;
+        } else if (!strcmp(name, "--preset-rate")) { options.presetRate = number;
+        } else if (!strcmp(name, "--reboots-per-day")) { options.rebootsPerDay = number;
+        } else if (!strcmp(name, "--mean-gap")) { options.meanGapSeconds = number;
+        } else if (!strcmp(name, "--endurance")) { options.endurance = number;
+        } else if (!strcmp(name, "--sigma")) { options.sigma = number;
+        } else if (!strcmp(name, "--min-endurance")) { options.minEndurance = number;
+        } else if (!strcmp(name, "--early-failure")) { options.earlyFailure = number;
+        } else if (!strcmp(name, "--seed")) { options.seed = strtoul(value, nullptr, 10);
+        } else {
+            fprintf(stderr, "Unknown option %s\n", name);
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Gives every cell its own endurance: normal around the mean, plus rare early failures. */
+void assignEndurance(const Options& options, std::mt19937& rng, unsigned long* endurance) {
+    std::normal_distribution<double> normal(options.endurance, options.sigma);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int address = 0; address < EEPROM_SIZE; ++address) {
+        double cycles = normal(rng);
+        if (cycles < options.minEndurance) {
+            cycles = options.minEndurance;
+        }
+        if (unit(rng) < options.earlyFailure) {
+            cycles = unit(rng) * options.minEndurance;
+        }
+        endurance[address] = static_cast<unsigned long>(cycles);
+        hal::eeprom::setEndurance(address, endurance[address]);
+    }
+}
+
+void printRegionReport(const Region& region, double years, const unsigned long* endurance) {
+    unsigned long maxWear = 0;
+    unsigned long long totalWear = 0;
+    double firstFailureYears = -1;
+    for (int address = region.start; address < region.end; ++address) {
+        unsigned long wear = hal::eeprom::wear(address);
+        maxWear = max(maxWear, wear);
+        totalWear += wear;
+        if (wear > 0) {
+            double projected = years * endurance[address] / wear;
+            if (firstFailureYears < 0 || projected < firstFailureYears) {
+                firstFailureYears = projected;
+            }
+        }
+    }
+    int cells = region.end - region.start;
+    printf("\n%s (%d..%d, %d cells): max %lu, mean %.1f writes per cell",
+           region.name, region.start, region.end - 1, cells, maxWear, static_cast<double>(totalWear) / cells);
+    if (firstFailureYears >= 0) {
+        printf(", first cell projected to wear out after %.1f years", firstFailureYears);
+    }
+    printf("\n");
+    if (maxWear == 0) {
+        return;
+    }
+
+    // Histogram of per-cell wear in ten equal buckets
+    constexpr int BUCKETS = 10;
+    int counts[BUCKETS] = {0};
+    int peak = 1;
+    for (int address = region.start; address < region.end; ++address) {
+        int bucket = static_cast<int>(hal::eeprom::wear(address) * BUCKETS / (maxWear + 1));
+        ++counts[bucket];
+        peak = max(peak, counts[bucket]);
+    }
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        unsigned long from = maxWear * bucket / BUCKETS;
+        unsigned long to = maxWear * (bucket + 1) / BUCKETS;
+        printf("  %9lu - %9lu | %4d ", from, to, counts[bucket]);
+        for (int i = 0; i < counts[bucket] * 50 / peak; ++i) {
+            putchar('#');
+        }
+        printf("\n");
+    }
+}
+
+/** @brief Moves the virtual clock, which millis() follows, to the given time. */
+void advanceTo(unsigned long long ms) {
+    hal::clock::advance(static_cast<unsigned long>(ms * 1000ULL - hal::clock::now()));
+}
+
+bool presetChanged = false; // since the last idle time long enough to commit it
+
+/**
+ * @brief Idles from nowMillis to untilMillis. Runs the loop passes that have
+ * work: the history flush right away, the preset commit once it is due.
+ */
+void idleUntil(unsigned long long nowMillis, unsigned long long untilMillis) {
+    for (uint8_t pass = 0; pass <= HISTORY_RECORD_SIZE; ++pass) {
+        tickHistory();
+    }
+    if (presetChanged && untilMillis - nowMillis >= PRESET_COMMIT_DELAY) {
+        advanceTo(nowMillis + PRESET_COMMIT_DELAY);
+        for (int pass = 0; pass <= PRESET_STORE_SIZE; ++pass) {
+            tickPresets(); // one byte per pass
+        }
+        presetChanged = false;
+    }
+    advanceTo(untilMillis);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::poisson_distribution<int> exposuresPerDay(options.exposuresPerDay);
+    std::exponential_distribution<double> gapSeconds(1.0 / options.meanGapSeconds);
+    std::uniform_int_distribution<long> newDelay(1, TimerConfig::MAX_DELAY / TimerConfig::INCREMENT);
+
+    hal::eeprom::reset();
+    hal::clock::reset();
+    static unsigned long endurance[EEPROM_SIZE];
+    assignEndurance(options, rng, endurance);
+
+    const long days = static_cast<long>(options.years * 365);
+    double rebootCredit = 1; // boot once at the start
+    unsigned long long nowMillis = 0;
+    unsigned long long exposures = 0;
+    unsigned long long ringWrites = 0;
+    unsigned long long presetChanges = 0;
+    double firstRetiredDay = -1;
+    double failedDay = -1;
+    long day = 0;
+
+    for (; day < days && failedDay < 0; ++day) {
+        unsigned long long dayStart = max(static_cast<unsigned long long>(day) * 86400000ULL, nowMillis);
+        idleUntil(nowMillis, dayStart);
+        nowMillis = dayStart;
+        rebootCredit += options.rebootsPerDay;
+        while (rebootCredit >= 1) {
+            rebootCredit -= 1;
+            restoreEEPROMAddress();
+            loadPresets();
+            loadHistory();
+        }
+
+        int count = exposuresPerDay(rng);
+        for (int i = 0; i < count; ++i, ++exposures) {
+            unsigned long long startMillis = nowMillis + static_cast<unsigned long long>(gapSeconds(rng) * 1000);
+            idleUntil(nowMillis, startMillis);
+            nowMillis = startMillis;
+            bool preset = unit(rng) < options.presetRate;
+            long previousDelay = timerDelay;
+            selectPreset(preset ? 0 : NO_PRESET);
+            if (!preset) {
+                timerDelay = previousDelay; // leaving a preset clears the delay; a user dials one
+            }
+            if (unit(rng) < options.changeRate || timerDelay < 0) {
+                timerDelay = newDelay(rng) * TimerConfig::INCREMENT;
+            }
+
+            // As the timer state machine does when an exposure is started
+            int lastAddress = eeAddress;
+            storeTimerDelay(millis());
+            if (eeAddress != lastAddress) {
+                ++ringWrites; // a store moves to the next slot
+            }
+            if (preset && getPreset(0).delay != timerDelay) {
+                ++presetChanges; // committed by tickPresets() once idle long enough
+                presetChanged = true;
+            }
+            updateActivePresetDelay(timerDelay);
+
+            recordExposureStart(timerDelay, ExposureMode::LINEAR, false);
+            recordExposureEnd(static_cast<unsigned long>(timerDelay) * 1000UL, false);
+
+            if (firstRetiredDay < 0 && badBlocksCount > 0) {
+                firstRetiredDay = day;
+            }
+            if (EEPROM_FAILED) {
+                failedDay = day;
+                break;
+            }
+        }
+    }
+
+    double years = max(day, 1L) / 365.0;
+    printf("EEPROM wear simulation: %.1f years simulated, seed %lu\n", years, options.seed);
+    printf("  %llu exposures, %llu delay writes, %llu preset delay changes, %lu bytes programmed\n",
+           exposures, ringWrites, presetChanges, hal::eeprom::writeCount());
+    printf("  %d wear leveling slots, %d retired (%d%% fails the EEPROM)\n",
+           EEPROM_SLOT_COUNT, badBlocksCount, MAX_BAD_BLOCK_PERCENT);
+    if (firstRetiredDay >= 0) {
+        printf("  first slot retired after %.2f years\n", firstRetiredDay / 365.0);
+    } else {
+        printf("  no slot retired\n");
+    }
+    if (failedDay >= 0) {
+        printf("  EEPROM_FAILED after %.2f years\n", failedDay / 365.0);
+    } else {
+        printf("  EEPROM_FAILED not reached within %.1f years\n", years);
+    }
+
+    for (const Region& region : REGIONS) {
+        printRegionReport(region, years, endurance);
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * File: firmware_layout.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 11:02:37 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 11:02:37 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+/*
+ * Prints the firmware layout the AVR simulator harness needs (pins, LCD bus
+ * address, EEPROM map and the wear leveling slot encoding) as a C header.
+ *
+ * The values come from the firmware headers themselves, so the harness in
+ * darkroom_timer_sim cannot drift from the sketch it drives:
+ *
+ *   firmware_layout > firmware_layout.h
+ */
+
+#include <Arduino.h>
+#include "../../src/constants.h"
+#include "../../src/ButtonHandler.h"
+#include "../../src/EncoderAcceleration.h"
+#include "../../src/LampControl.h"
+#include "../../src/MemoryUtils.h"
+#include "../../src/encoderHandler.h"
+
+namespace {
+
+// Arduino Nano (ATmega328P): D0-D7 are PORTD, D8-D13 PORTB, A0-A5 (D14-D19) PORTC
+void printPin(const char* name, uint8_t pin) {
+    char port = pin < 8 ? 'D' : pin < 14 ? 'B' : 'C';
+    int bit = pin < 8 ? pin : pin < 14 ? pin - 8 : pin - 14;
+    printf("#define %s_PORT '%c'\n", name, port);
+    printf("#define %s_BIT %d\n", name, bit);
+}
+
+} // namespace
+
+int main() {
+    printf("/* Generated by darkroom_timer_host/tools/firmware_layout from the firmware headers, do not edit. */\n");
+    printf("#ifndef FIRMWARE_LAYOUT_H\n#define FIRMWARE_LAYOUT_H\n\n");
+
+    printPin("RELAY", RELAY_PIN);
+    printPin("MANUAL_LIGHT", MANUAL_LIGHT_PIN);
+    printPin("TIMER_BUTTON", TIMER_BUTTON_PIN);
+    printPin("ENCODER_BUTTON", ROTARY_ENCODER_BUTTON_PIN);
+    printPin("ENCODER_A", ROTARY_ENCODER_PIN_A);
+    printPin("ENCODER_B", ROTARY_ENCODER_PIN_B);
+    printf("#define LCD_I2C_ADDRESS 0x%02X\n\n", I2C_ADDRESS);
+
+    printf("#define EEPROM_SIZE %d\n", EEPROM_SIZE);
+    printf("#define EEPROM_START_ADDRESS %d\n", EEPROM_START_ADDRESS);
+    printf("#define RING_SEQUENCE_SHIFT %d\n", RING_SEQUENCE_SHIFT);
+    printf("#define RING_VALUE_MASK 0x%08lXUL\n", static_cast<unsigned long>(RING_VALUE_MASK));
+    // ringSlotValue() of MemoryUtils.h
+    printf("#define RING_SLOT_VALUE(delay, sequence) "
+           "((((uint32_t)(delay)) & RING_VALUE_MASK) | ((uint32_t)(sequence) << RING_SEQUENCE_SHIFT))\n\n");
+
+    printf("#define DETENT_MS %ld\n", static_cast<long>(LINEAR_ACCELERATION[0].step));
+    printf("#define MAX_DELAY_MS %ld\n", TimerConfig::MAX_DELAY);
+    printf("\n#endif\n");
+    return 0;
+}
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+
+# File: compare_bench.py
+# Project: Darkroom Enlarger Timer
+# File Created: Sunday, 18th October 2026 8:19:40 pm
+# Author: Andrei Grichine (andrei.grichine@gmail.com)
+# -----
+# Last Modified: Sunday, 18th October 2026 8:19:40 pm
+# Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+# -----
+# Copyright: 2019 - 2025. Prime73 Inc.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+# -----
+# HISTORY:
+
+
+"""Compares two benchmark CSV files written by `make bench`.
+
+Prints the mean cycles per call of every benchmark case in both runs and the
+change. Exits with status 1 if any case got slower than the threshold, so a
+regression can fail a build.
+
+    compare_bench.py [--threshold PERCENT] BASELINE.csv CURRENT.csv
+"""
+
+import argparse
+import csv
+import sys
+
+
+def load(path):
+    with open(path, newline="") as handle:
+        rows = (line for line in handle if not line.startswith("#"))
+        return {(row["function"], row["case"]): row for row in csv.DictReader(rows)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="allowed slowdown of the mean in percent (default 5)")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+
+    print(f"{'function':<24} {'case':<16} {'before':>9} {'after':>9} {'change':>8}")
+    for key in sorted(baseline.keys() | current.keys()):
+        before = baseline.get(key)
+        after = current.get(key)
+        if before is None or after is None:
+            print(f"{key[0]:<24} {key[1]:<16} {'only in ' + ('current' if before is None else 'baseline'):>28}")
+            continue
+        old = int(before["mean_cycles"])
+        new = int(after["mean_cycles"])
+        change = (new - old) * 100.0 / old if old else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  <-- slower"
+            regressions += 1
+        print(f"{key[0]:<24} {key[1]:<16} {old:>9} {new:>9} {change:>+7.1f}%{flag}")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
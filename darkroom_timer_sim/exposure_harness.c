@@ -0,0 +1,327 @@
+/*
+ * File: exposure_harness.c
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:19:01 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 10:02:13 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/*
+ * End-to-end exposure accuracy of the unmodified darkroom_timer.ino image.
+ *
+ * For every requested delay the harness boots a fresh simulated ATmega328P
+ * with the delay preloaded in EEPROM, presses the timer button through the
+ * GPIO pins and timestamps the RELAY_PIN edges to the CPU cycle. It prints one
+ * CSV line per delay and a summary of the error:
+ *
+ *   requested_ms,actual_us,error_us,lcd_bytes,load
+ *   # runs 11, mean error 48 us, jitter 12 us, worst 97 us
+ *
+ * A PCF8574 stub acknowledges the LCD backpack on the I2C bus, so display
+ * updates take their real bus time. With --load the delay is preloaded one
+ * encoder detent short and dialled up with a detent before the press, so the
+ * start also writes the new delay to EEPROM.
+ *
+ *   exposure_harness [--delays 0.1,1,10,...] [--load] [--vcd-dir DIR] firmware.elf
+ *
+ * Experimental: not yet built against simavr or run on a real firmware image.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+#include <simavr/sim_vcd_file.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_eeprom.h>
+#include <simavr/avr_twi.h>
+// Pins, LCD address, EEPROM map and ring slot encoding of the firmware,
+// generated from its headers by darkroom_timer_host/tools/firmware_layout
+#include "firmware_layout.h"
+
+#define MCU "atmega328p"
+#define F_CPU 16000000UL
+#define CYCLES_PER_MS (F_CPU / 1000)
+
+#define BOOT_MS 10000               // setup(): LCD test, splash screen and lamp test take about 7.5 s
+#define PRESS_MS 100
+
+static const double DEFAULT_DELAYS[] = {0.1, 0.5, 1, 2, 5, 10, 30, 60, 120, 300, 599};
+
+typedef struct {
+    avr_t* avr;
+    avr_cycle_count_t relayOn;
+    avr_cycle_count_t relayOff;
+    int relayEdges;
+    int lcdSelected;
+    unsigned long lcdBytes;
+    avr_irq_t* lcdIrq;
+} Bench;
+
+static void relayChanged(struct avr_irq_t* irq, uint32_t value, void* param) {
+    Bench* bench = (Bench*)param;
+    if (value) {
+        bench->relayOn = bench->avr->cycle;
+    } else {
+        bench->relayOff = bench->avr->cycle;
+    }
+    ++bench->relayEdges;
+}
+
+/**
+ * @brief PCF8574 I2C backpack stub: acknowledges its address and every byte written.
+ */
+static void lcdBusMessage(struct avr_irq_t* irq, uint32_t value, void* param) {
+    Bench* bench = (Bench*)param;
+    avr_twi_msg_irq_t message;
+    message.u.v = value;
+    if (message.u.twi.msg & TWI_COND_STOP) {
+        bench->lcdSelected = 0;
+    }
+    if (message.u.twi.msg & TWI_COND_START) {
+        bench->lcdSelected = 0;
+    }
+    if (message.u.twi.msg & TWI_COND_ADDR) {
+        bench->lcdSelected = (message.u.twi.addr >> 1) == LCD_I2C_ADDRESS;
+        if (bench->lcdSelected) {
+            avr_raise_irq(bench->lcdIrq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, message.u.twi.addr, 1));
+        }
+    }
+    if (bench->lcdSelected && (message.u.twi.msg & TWI_COND_WRITE)) {
+        ++bench->lcdBytes;
+        avr_raise_irq(bench->lcdIrq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, message.u.twi.addr, 1));
+    }
+}
+
+static void attachLcd(Bench* bench) {
+    static const char* names[2] = {[TWI_IRQ_INPUT] = "8>pcf8574.out", [TWI_IRQ_OUTPUT] = "32<pcf8574.in"};
+    bench->lcdIrq = avr_alloc_irq(&bench->avr->irq_pool, 0, 2, names);
+    avr_irq_register_notify(bench->lcdIrq + TWI_IRQ_OUTPUT, lcdBusMessage, bench);
+    avr_connect_irq(bench->lcdIrq + TWI_IRQ_INPUT, avr_io_getirq(bench->avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+    avr_connect_irq(avr_io_getirq(bench->avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), bench->lcdIrq + TWI_IRQ_OUTPUT);
+}
+
+static avr_irq_t* pinIrq(Bench* bench, char port, int bit) {
+    return avr_io_getirq(bench->avr, AVR_IOCTL_IOPORT_GETIRQ(port), bit);
+}
+
+/** @brief Runs the simulation up to the given time since reset. Returns 0 if the CPU crashed or stopped. */
+static int runUntil(Bench* bench, avr_cycle_count_t cycle) {
+    while (bench->avr->cycle < cycle) {
+        int state = avr_run(bench->avr);
+        if (state == cpu_Done || state == cpu_Crashed) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int runFor(Bench* bench, unsigned long ms) {
+    return runUntil(bench, bench->avr->cycle + (avr_cycle_count_t)ms * CYCLES_PER_MS);
+}
+
+/**
+ * @brief One clockwise detent: the full-step Gray sequence MD_REncoder decodes as DIR_CW.
+ */
+static int turnClockwise(Bench* bench) {
+    static const uint8_t sequence[4][2] = {{1, 0}, {0, 0}, {0, 1}, {1, 1}}; // {A, B}
+    for (int step = 0; step < 4; ++step) {
+        avr_raise_irq(pinIrq(bench, ENCODER_A_PORT, ENCODER_A_BIT), sequence[step][0]);
+        avr_raise_irq(pinIrq(bench, ENCODER_B_PORT, ENCODER_B_BIT), sequence[step][1]);
+        if (!runFor(bench, 20)) { // slow enough for loop() to see every state
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int loadFirmware(const char* path, elf_firmware_t* firmware) {
+    memset(firmware, 0, sizeof(*firmware));
+    if (elf_read_firmware(path, firmware) != 0) {
+        return 0;
+    }
+    strcpy(firmware->mmcu, MCU);
+    firmware->frequency = F_CPU;
+    return 1;
+}
+
+/**
+ * @brief Boots a fresh MCU, runs one exposure and measures it.
+ *
+ * @return Relay on-time in cycles, or 0 if no complete exposure was seen.
+ */
+static avr_cycle_count_t measureExposure(elf_firmware_t* firmware, long delayMs, int load,
+                                         const char* vcdPath, unsigned long* lcdBytes) {
+    Bench bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.avr = avr_make_mcu_by_name(MCU);
+    if (bench.avr == NULL) {
+        fprintf(stderr, "exposure_harness: simavr has no %s core\n", MCU);
+        exit(2);
+    }
+    avr_init(bench.avr);
+    avr_load_firmware(bench.avr, firmware);
+
+    // Erased chip with the delay in the first wear leveling slot (little endian,
+    // sequence number 1 so the ring reads it as the newest slot)
+    uint8_t eeprom[EEPROM_SIZE];
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    uint32_t stored = RING_SLOT_VALUE(load ? delayMs - DETENT_MS : delayMs, 1);
+    for (int i = 0; i < 4; ++i) {
+        eeprom[EEPROM_START_ADDRESS + i] = (uint8_t)(stored >> (8 * i));
+    }
+    avr_eeprom_desc_t eepromDescriptor = {.ee = eeprom, .offset = 0, .size = sizeof(eeprom)};
+    avr_ioctl(bench.avr, AVR_IOCTL_EEPROM_SET, &eepromDescriptor);
+
+    // Buttons released and encoder at rest (all inputs pulled high)
+    avr_raise_irq(pinIrq(&bench, TIMER_BUTTON_PORT, TIMER_BUTTON_BIT), 1);
+    avr_raise_irq(pinIrq(&bench, ENCODER_BUTTON_PORT, ENCODER_BUTTON_BIT), 1);
+    avr_raise_irq(pinIrq(&bench, ENCODER_A_PORT, ENCODER_A_BIT), 1);
+    avr_raise_irq(pinIrq(&bench, ENCODER_B_PORT, ENCODER_B_BIT), 1);
+    attachLcd(&bench);
+    avr_irq_register_notify(pinIrq(&bench, RELAY_PORT, RELAY_BIT), relayChanged, &bench);
+
+    avr_vcd_t vcd;
+    if (vcdPath != NULL) {
+        avr_vcd_init(bench.avr, vcdPath, &vcd, 1000);
+        avr_vcd_add_signal(&vcd, pinIrq(&bench, RELAY_PORT, RELAY_BIT), 1, "RELAY");
+        avr_vcd_add_signal(&vcd, pinIrq(&bench, TIMER_BUTTON_PORT, TIMER_BUTTON_BIT), 1, "TIMER_BUTTON");
+        avr_vcd_add_signal(&vcd, pinIrq(&bench, MANUAL_LIGHT_PORT, MANUAL_LIGHT_BIT), 1, "MANUAL_LIGHT");
+        avr_vcd_start(&vcd);
+    }
+
+    avr_cycle_count_t onTime = 0;
+    int ok = runFor(&bench, BOOT_MS);
+    if (ok && load) {
+        ok = turnClockwise(&bench) && runFor(&bench, 200);
+    }
+    if (ok) {
+        bench.relayEdges = 0; // the lamp test in setup() is not an exposure
+        bench.lcdBytes = 0;
+        avr_raise_irq(pinIrq(&bench, TIMER_BUTTON_PORT, TIMER_BUTTON_BIT), 0);
+        ok = runFor(&bench, PRESS_MS);
+        avr_raise_irq(pinIrq(&bench, TIMER_BUTTON_PORT, TIMER_BUTTON_BIT), 1);
+    }
+    // Generous margin after the expected end; stop early once the relay is off again
+    avr_cycle_count_t limit = bench.avr->cycle + (avr_cycle_count_t)(delayMs + 2000) * CYCLES_PER_MS;
+    while (ok && bench.relayEdges < 2 && bench.avr->cycle < limit) {
+        ok = runFor(&bench, 10);
+    }
+    if (bench.relayEdges >= 2 && bench.relayOff > bench.relayOn) {
+        onTime = bench.relayOff - bench.relayOn;
+    }
+    *lcdBytes = bench.lcdBytes;
+
+    if (vcdPath != NULL) {
+        avr_vcd_stop(&vcd);
+        avr_vcd_close(&vcd);
+    }
+    avr_terminate(bench.avr);
+    free(bench.avr);
+    return onTime;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: exposure_harness [--delays S,S,...] [--load] [--vcd-dir DIR] firmware.elf\n");
+    exit(2);
+}
+
+int main(int argc, char* argv[]) {
+    double delays[64];
+    int delayCount = 0;
+    int load = 0;
+    const char* vcdDir = NULL;
+    const char* firmwarePath = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--delays") == 0 && i + 1 < argc) {
+            for (char* token = strtok(argv[++i], ","); token != NULL && delayCount < 64; token = strtok(NULL, ",")) {
+                delays[delayCount++] = atof(token);
+            }
+        } else if (strcmp(argv[i], "--load") == 0) {
+            load = 1;
+        } else if (strcmp(argv[i], "--vcd-dir") == 0 && i + 1 < argc) {
+            vcdDir = argv[++i];
+        } else if (argv[i][0] == '-') {
+            usage();
+        } else {
+            firmwarePath = argv[i];
+        }
+    }
+    if (firmwarePath == NULL) {
+        usage();
+    }
+    if (delayCount == 0) {
+        delayCount = sizeof(DEFAULT_DELAYS) / sizeof(DEFAULT_DELAYS[0]);
+        memcpy(delays, DEFAULT_DELAYS, sizeof(DEFAULT_DELAYS));
+    }
+
+    elf_firmware_t firmware;
+    if (!loadFirmware(firmwarePath, &firmware)) {
+        fprintf(stderr, "exposure_harness: cannot read %s\n", firmwarePath);
+        return 2;
+    }
+
+    printf("requested_ms,actual_us,error_us,lcd_bytes,load\n");
+    int runs = 0;
+    int failures = 0;
+    double sum = 0, sumSquares = 0, worst = 0;
+    for (int i = 0; i < delayCount; ++i) {
+        // The timer counts in 0.1 s steps up to TimerConfig::MAX_DELAY
+        long delayMs = lround(delays[i] * 10) * 100;
+        if (delayMs < DETENT_MS || delayMs > MAX_DELAY_MS) {
+            fprintf(stderr, "exposure_harness: skipping %.1f s (outside 0.1 .. 599 s)\n", delays[i]);
+            continue;
+        }
+        char vcdPath[512];
+        if (vcdDir != NULL) {
+            snprintf(vcdPath, sizeof(vcdPath), "%s/exposure_%ldms%s.vcd", vcdDir, delayMs, load ? "_load" : "");
+        }
+        unsigned long lcdBytes = 0;
+        avr_cycle_count_t onCycles = measureExposure(&firmware, delayMs, load, vcdDir ? vcdPath : NULL, &lcdBytes);
+        if (onCycles == 0) {
+            printf("%ld,,,%lu,%d\n", delayMs, lcdBytes, load);
+            fprintf(stderr, "exposure_harness: no exposure seen for %ld ms\n", delayMs);
+            ++failures;
+            continue;
+        }
+        double actualUs = onCycles * 1e6 / F_CPU;
+        double errorUs = actualUs - delayMs * 1000.0;
+        printf("%ld,%.2f,%.2f,%lu,%d\n", delayMs, actualUs, errorUs, lcdBytes, load);
+        fflush(stdout);
+        ++runs;
+        sum += errorUs;
+        sumSquares += errorUs * errorUs;
+        if (fabs(errorUs) > fabs(worst)) {
+            worst = errorUs;
+        }
+    }
+
+    if (runs > 0) {
+        double mean = sum / runs;
+        double jitter = sqrt(fmax(0.0, sumSquares / runs - mean * mean));
+        printf("# runs %d, mean error %.1f us, jitter %.1f us, worst %.1f us\n", runs, mean, jitter, worst);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * File: sim_runner.c
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:16:55 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 10:02:13 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+/*
+ * Runs a firmware image on a simulated ATmega328P (simavr) at 16 MHz.
+ *
+ * Bytes the firmware sends on UART0 go to stdout. The run ends when the
+ * firmware sleeps with interrupts disabled (the benchmark sketch does this
+ * when it is done) or when the simulated time limit is reached.
+ *
+ *   sim_runner [--timeout SECONDS] firmware.elf
+ *
+ * Exit status: 0 when the firmware finished, 1 on a crash or timeout,
+ * 2 on a usage or load error.
+ *
+ * Experimental: not yet built against simavr or run on a real firmware image.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+#include <simavr/avr_uart.h>
+
+#define MCU "atmega328p"
+#define F_CPU 16000000UL
+
+static void uartOutput(struct avr_irq_t* irq, uint32_t value, void* param) {
+    putchar((int)value);
+    if (value == '\n') {
+        fflush(stdout);
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: sim_runner [--timeout SECONDS] firmware.elf\n");
+    exit(2);
+}
+
+int main(int argc, char* argv[]) {
+    double timeoutSeconds = 600.0;
+    const char* firmwarePath = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            timeoutSeconds = atof(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            usage();
+        } else {
+            firmwarePath = argv[i];
+        }
+    }
+    if (firmwarePath == NULL) {
+        usage();
+    }
+
+    elf_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(firmwarePath, &firmware) != 0) {
+        fprintf(stderr, "sim_runner: cannot read %s\n", firmwarePath);
+        return 2;
+    }
+    strcpy(firmware.mmcu, MCU);
+    firmware.frequency = F_CPU;
+
+    avr_t* avr = avr_make_mcu_by_name(MCU);
+    if (avr == NULL) {
+        fprintf(stderr, "sim_runner: simavr has no %s core\n", MCU);
+        return 2;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+
+    // Take the UART output ourselves instead of simavr's line-buffered console echo
+    uint32_t flags = 0;
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+    flags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), uartOutput, NULL);
+
+    const avr_cycle_count_t cycleLimit = (avr_cycle_count_t)(timeoutSeconds * F_CPU);
+    int state = cpu_Running;
+    while (state != cpu_Done && state != cpu_Crashed) {
+        state = avr_run(avr);
+        if (avr->cycle >= cycleLimit) {
+            fprintf(stderr, "sim_runner: timeout after %.1f simulated seconds\n", timeoutSeconds);
+            return 1;
+        }
+    }
+    fflush(stdout);
+    if (state == cpu_Crashed) {
+        fprintf(stderr, "sim_runner: firmware crashed at cycle %llu\n", (unsigned long long)avr->cycle);
+        return 1;
+    }
+    return 0;
+}
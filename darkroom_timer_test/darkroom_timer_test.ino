@@ -4,7 +4,7 @@
 * File Created: Tuesday, 31st December 2024 12:35:55 pm
 * Author: Andrei Grichine (andrei.grichine@gmail.com)
 * -----
-* Last Modified: Wednesday, 26th February 2025 9:58:28 pm
+* Last Modified: Sunday, 18th October 2026 7:59:49 pm
 * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
 * -----
 * Copyright 2019 - 2024, Prime73 Inc. MIT License
@@ -38,6 +38,9 @@
 
 #ifdef ENABLE_TESTS
 #include "test/encoderHandler_test.cpp"
+#include "test/encoderAcceleration_test.cpp"
+#include "test/verticalDebounce_test.cpp"
+#include "test/gestureRecognizer_test.cpp"
 #endif
 
 void setup() {
@@ -0,0 +1,128 @@
+/*
+ * File: encoderAcceleration_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:54:45 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 7:54:45 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#include <ArduinoUnit.h>
+#include "../src/EncoderAcceleration.h"
+#include "../src/constants.h"
+
+#ifdef ENABLE_TESTS
+
+// A recorded rotation: time since the previous detent and its direction.
+struct Detent {
+    uint16_t interval;  // ms
+    bool increase;
+};
+
+// Replays a rotation trace through the acceleration tables, starting from delay.
+long replayTrace(const Detent trace[], size_t len, ExposureMode mode, long delay, EncoderAccelerator& accelerator) {
+    unsigned long time = 10000;
+    for (size_t i = 0; i < len; ++i) {
+        time += trace[i].interval;
+        uint16_t step = accelerationStep(accelerator, mode, trace[i].increase, time);
+        delay = applyEncoderStep(delay, mode, trace[i].increase, step);
+    }
+    return delay;
+}
+
+    // Encoder Acceleration Tests
+    test(EncoderAcceleration_slow_turns_stay_fine) {
+        const Detent trace[] = {{300, true}, {200, true}, {200, true}, {150, true}, {250, true}};
+        EncoderAccelerator accelerator;
+        assertEqual(replayTrace(trace, 5, ExposureMode::LINEAR, 5000, accelerator), (long)5500);
+    }
+
+    test(EncoderAcceleration_fast_sweep_climbs_one_tier_per_detent) {
+        // 0.1 s, 0.5 s, 1 s, then 5 s steps at 50 detents per second
+        const Detent trace[] = {{20, true}, {20, true}, {20, true}, {20, true}, {20, true}};
+        EncoderAccelerator accelerator;
+        assertEqual(replayTrace(trace, 5, ExposureMode::LINEAR, 5000, accelerator), (long)16600);
+    }
+
+    test(EncoderAcceleration_sweep_5s_to_300s_in_under_65_detents) {
+        const Detent detent = {20, true};
+        EncoderAccelerator accelerator;
+        long delay = 5000;
+        int detents = 0;
+        while (delay < 300000 && detents < 100) {
+            delay = replayTrace(&detent, 1, ExposureMode::LINEAR, delay, accelerator);
+            detents++;
+        }
+        assertLess(detents, 65);
+    }
+
+    test(EncoderAcceleration_slow_down_returns_to_fine_steps) {
+        const Detent trace[] = {{20, true}, {20, true}, {20, true}, {20, true}, {400, true}};
+        EncoderAccelerator accelerator;
+        // 5 s + 0.1 + 0.5 + 1 + 5, then a single slow detent adds 0.1 s again
+        assertEqual(replayTrace(trace, 5, ExposureMode::LINEAR, 5000, accelerator), (long)11700);
+        assertEqual((int)accelerator.tier, 0);
+    }
+
+    test(EncoderAcceleration_direction_change_returns_to_fine_steps) {
+        const Detent trace[] = {{20, true}, {20, true}, {20, true}, {20, false}};
+        EncoderAccelerator accelerator;
+        assertEqual(replayTrace(trace, 4, ExposureMode::LINEAR, 5000, accelerator), (long)6500);
+    }
+
+    test(EncoderAcceleration_linear_limits) {
+        const Detent up[] = {{20, true}, {20, true}, {20, true}, {20, true}};
+        const Detent down[] = {{20, false}, {20, false}};
+        EncoderAccelerator accelerator;
+        assertEqual(replayTrace(up, 4, ExposureMode::LINEAR, TimerConfig::MAX_DELAY - 1000, accelerator), TimerConfig::MAX_DELAY);
+        EncoderAccelerator other;
+        assertEqual(replayTrace(down, 2, ExposureMode::LINEAR, 300, other), (long)0);
+    }
+
+    test(EncoderAcceleration_fstop_twelve_fine_detents_double_the_time) {
+        Detent trace[12];
+        for (int i = 0; i < 12; ++i) trace[i] = {300, true};
+        EncoderAccelerator accelerator;
+        // Each step is rounded to 0.1 s, so a full stop may land one increment short
+        long doubled = replayTrace(trace, 12, ExposureMode::FSTOP, 10000, accelerator);
+        assertMoreOrEqual(doubled, (long)19900);
+        assertLessOrEqual(doubled, (long)20100);
+        for (int i = 0; i < 12; ++i) trace[i] = {300, false};
+        assertEqual(replayTrace(trace, 12, ExposureMode::FSTOP, doubled, accelerator), (long)10000);
+    }
+
+    test(EncoderAcceleration_fstop_fast_sweep_uses_whole_stops) {
+        // 1/12, 1/6, 1/3 stop, then whole stops: 5 s becomes about 2^(7/12 + 2) * 5 s = 29.97 s
+        const Detent trace[] = {{20, true}, {20, true}, {20, true}, {20, true}, {20, true}};
+        EncoderAccelerator accelerator;
+        long delay = replayTrace(trace, 5, ExposureMode::FSTOP, 5000, accelerator);
+        assertMoreOrEqual(delay, (long)29500);
+        assertLessOrEqual(delay, (long)30000);
+    }
+
+    test(EncoderAcceleration_fstop_short_delays_still_move) {
+        const Detent up = {300, true};
+        const Detent down = {300, false};
+        EncoderAccelerator accelerator;
+        assertEqual(replayTrace(&up, 1, ExposureMode::FSTOP, 0, accelerator), TimerConfig::INCREMENT);
+        assertEqual(replayTrace(&up, 1, ExposureMode::FSTOP, 500, accelerator), (long)600);
+        assertEqual(replayTrace(&down, 1, ExposureMode::FSTOP, 100, accelerator), (long)0);
+    }
+
+#endif
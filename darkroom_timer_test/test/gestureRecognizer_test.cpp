@@ -0,0 +1,106 @@
+/*
+ * File: gestureRecognizer_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:59:38 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:40:32 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#include <ArduinoUnit.h>
+#include "../src/GestureRecognizer.h"
+#include "../src/constants.h"
+
+#ifdef ENABLE_TESTS
+
+const GestureConfig timerGestures = {2000, 0};
+const GestureConfig encoderGestures = {1000, 300};
+
+// Polls the recognizer at the given time; returns the due gesture.
+Gesture pollAt(GestureState& state, const GestureConfig& config, unsigned long now) {
+    return gesturePoll(state, config, now);
+}
+
+    // Gesture Recognizer Tests
+    test(Gesture_short_press_without_double_window_reports_on_release) {
+        GestureState state;
+        assertTrue(gestureEdge(state, timerGestures, true, 1000) == Gesture::NONE);
+        assertTrue(pollAt(state, timerGestures, 2500) == Gesture::NONE);
+        assertTrue(gestureEdge(state, timerGestures, false, 2999) == Gesture::SINGLE_PRESS);
+    }
+
+    test(Gesture_long_press_reports_at_threshold_while_held) {
+        GestureState state;
+        gestureEdge(state, timerGestures, true, 1000);
+        assertTrue(pollAt(state, timerGestures, 2999) == Gesture::NONE);
+        assertTrue(pollAt(state, timerGestures, 3000) == Gesture::LONG_PRESS);
+        assertTrue(pollAt(state, timerGestures, 4000) == Gesture::NONE); // reported once
+        assertTrue(gestureEdge(state, timerGestures, false, 5000) == Gesture::HOLD_RELEASE);
+    }
+
+    test(Gesture_late_poll_is_decided_by_edge_time) {
+        // loop() was busy: the release is handled 1.5 s after the threshold was crossed
+        GestureState state;
+        gestureEdge(state, timerGestures, true, 1000);
+        assertTrue(pollAt(state, timerGestures, 4500) == Gesture::LONG_PRESS);
+        assertTrue(gestureEdge(state, timerGestures, false, 4500) == Gesture::HOLD_RELEASE);
+
+        // A release 1 ms before the threshold, handled just as late, is a short press
+        gestureEdge(state, timerGestures, true, 10000);
+        assertTrue(pollAt(state, timerGestures, 11999) == Gesture::NONE); // polled with the edge time
+        assertTrue(gestureEdge(state, timerGestures, false, 11999) == Gesture::SINGLE_PRESS);
+    }
+
+    test(Gesture_single_press_waits_for_double_window) {
+        GestureState state;
+        gestureEdge(state, encoderGestures, true, 100);
+        assertTrue(gestureEdge(state, encoderGestures, false, 200) == Gesture::NONE);
+        assertTrue(pollAt(state, encoderGestures, 499) == Gesture::NONE);
+        assertTrue(pollAt(state, encoderGestures, 650) == Gesture::SINGLE_PRESS);
+    }
+
+    test(Gesture_double_press_reports_on_second_press) {
+        GestureState state;
+        gestureEdge(state, encoderGestures, true, 100);
+        gestureEdge(state, encoderGestures, false, 200);
+        assertTrue(pollAt(state, encoderGestures, 350) == Gesture::NONE);
+        assertTrue(gestureEdge(state, encoderGestures, true, 350) == Gesture::DOUBLE_PRESS);
+        assertTrue(pollAt(state, encoderGestures, 2000) == Gesture::NONE); // no long press on the second press
+        assertTrue(gestureEdge(state, encoderGestures, false, 2100) == Gesture::NONE);
+        assertTrue(pollAt(state, encoderGestures, 5000) == Gesture::NONE);
+    }
+
+    test(Gesture_poll_before_edge_time_does_not_fire) {
+        // An edge queued after loop() read millis() may be newer than the poll time
+        GestureState state;
+        gestureEdge(state, timerGestures, true, 1000);
+        assertTrue(pollAt(state, timerGestures, 999) == Gesture::NONE);
+    }
+
+    test(Gesture_cancel_swallows_the_rest_of_the_press) {
+        GestureState state;
+        gestureEdge(state, timerGestures, true, 1000);
+        gestureCancel(state);
+        assertTrue(pollAt(state, timerGestures, 5000) == Gesture::NONE);
+        assertTrue(gestureEdge(state, timerGestures, false, 5100) == Gesture::NONE);
+        gestureEdge(state, timerGestures, true, 6000);
+        assertTrue(gestureEdge(state, timerGestures, false, 6100) == Gesture::SINGLE_PRESS);
+    }
+
+#endif
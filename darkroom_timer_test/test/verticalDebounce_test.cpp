@@ -0,0 +1,75 @@
+/*
+ * File: verticalDebounce_test.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:57:19 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 7:57:19 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#include <ArduinoUnit.h>
+#include "../src/VerticalDebounce.h"
+#include "../src/constants.h"
+
+#ifdef ENABLE_TESTS
+
+    // Vertical Counter Debounce Tests
+    test(VerticalDebounce_press_needs_four_stable_samples) {
+        VerticalDebouncer debouncer;
+        assertEqual((int)debounceSample(debouncer, 0x01), 0);
+        assertEqual((int)debounceSample(debouncer, 0x01), 0);
+        assertEqual((int)debounceSample(debouncer, 0x01), 0);
+        assertEqual((int)debounceSample(debouncer, 0x01), 0x01);
+        assertEqual((int)debouncer.state, 0x01);
+        assertEqual((int)debounceSample(debouncer, 0x01), 0);
+    }
+
+    test(VerticalDebounce_bounce_restarts_the_count) {
+        VerticalDebouncer debouncer;
+        const uint8_t bouncing[] = {0x01, 0x00, 0x01, 0x01, 0x00, 0x01, 0x01, 0x01};
+        for (uint8_t sample : bouncing) {
+            assertEqual((int)debounceSample(debouncer, sample), 0);
+        }
+        assertEqual((int)debounceSample(debouncer, 0x01), 0x01);
+    }
+
+    test(VerticalDebounce_release_is_debounced_too) {
+        VerticalDebouncer debouncer;
+        for (int i = 0; i < 4; ++i) debounceSample(debouncer, 0x80);
+        assertEqual((int)debouncer.state, 0x80);
+        assertEqual((int)debounceSample(debouncer, 0x00), 0);
+        assertEqual((int)debounceSample(debouncer, 0x80), 0); // glitch back resets the release
+        for (int i = 0; i < 3; ++i) assertEqual((int)debounceSample(debouncer, 0x00), 0);
+        uint8_t changed = debounceSample(debouncer, 0x00);
+        assertEqual((int)changed, 0x80);
+        assertEqual((int)(changed & ~debouncer.state), 0x80); // reported as a release
+    }
+
+    test(VerticalDebounce_inputs_are_independent) {
+        VerticalDebouncer debouncer;
+        // Input 0 pressed from the start, input 3 two samples later, input 5 keeps bouncing
+        const uint8_t samples[] = {0x01, 0x21, 0x09, 0x29, 0x09, 0x29};
+        const uint8_t expected[] = {0, 0, 0, 0x01, 0, 0x08};
+        for (int i = 0; i < 6; ++i) {
+            assertEqual((int)debounceSample(debouncer, samples[i]), (int)expected[i]);
+        }
+        assertEqual((int)debouncer.state, 0x09);
+    }
+
+#endif
@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 11:11:12 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Wednesday, 26th February 2025 8:53:49 pm
+ * Last Modified: Sunday, 18th October 2026 9:57:09 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -26,186 +26,305 @@
 #include "MemoryUtils.h"
 #include "ButtonHandler.h"
 #include "constants.h"
-#include "LampControl.h"
+#include "TimerStateMachine.h"
+#include "PresetStore.h"
+#include "LightMeter.h"
+#include "VerticalDebounce.h"
+#include "FastPin.h"
 
-ButtonState encoderButtonState;
-ButtonState timerButtonState;
+// The timer button never waits for a double press, so a short press starts the exposure on release.
+static const GestureConfig timerButtonGestures = {TimerConfig::TURN_ENLARGER_LAMP_ON_DELAY, 0};
+static const GestureConfig encoderButtonGestures = {ENCODER_LONG_PRESS_DELAY, DOUBLE_PRESS_WINDOW};
+static GestureState timerButtonGesture;
+static GestureState encoderButtonGesture;
+
+static_assert((BUTTON_EVENT_QUEUE_SIZE & (BUTTON_EVENT_QUEUE_SIZE - 1)) == 0, "BUTTON_EVENT_QUEUE_SIZE must be a power of two");
+
+// Single-producer (sampling tick) / single-consumer (loop) ring buffer.
+// Head and tail are single bytes, so each side updates its index atomically.
+static volatile ButtonEvent buttonEvents[BUTTON_EVENT_QUEUE_SIZE];
+static volatile uint8_t buttonEventHead = 0;       // Written by the producer only
+static volatile uint8_t buttonEventTail = 0;       // Written by the consumer only
+static volatile bool buttonEventOverflow = false;  // Set by the producer when an edge was dropped
+
+static VerticalDebouncer buttonDebouncer;   // Producer: debounced state of all buttons
+static uint8_t handledButtons = 0;          // Consumer: pressed mask as seen by the handlers
+#if !defined(__AVR__)
+static unsigned long nextSampleTime = 0;    // Consumer-driven sampling without the tick interrupt
+#endif
 
 /**
- * Initializes button pins and restores the stored timer delay from EEPROM.
- *
- * Configures the timer and rotary encoder button pins as input with pull-up
- * resistors. Retrieves the previously stored timer delay value from EEPROM
- * and assigns it to the timerDelay variable.
+ * @brief Reads all button pins in one go (bit set = pressed).
  */
- void initializeButtons() {
-    pinMode(TIMER_BUTTON_PIN, INPUT_PULLUP);
-    pinMode(ROTARY_ENCODER_BUTTON_PIN, INPUT_PULLUP);
-    // Restore stored timer delay from EEPROM
-    
-    storedTimerDelay = readEEPROMWithRetry(EEPROM_START_ADDRESS); // reading from start address
-
-    timerDelay = storedTimerDelay;
+static uint8_t readPressedButtons() {
+#if defined(__AVR__)
+    return ~PIND & BUTTON_PIN_MASK; // active low
+#else
+    return (FastPin<TIMER_BUTTON_PIN>::read() ? 0 : TIMER_BUTTON_MASK)
+         | (FastPin<ROTARY_ENCODER_BUTTON_PIN>::read() ? 0 : ENCODER_BUTTON_MASK);
+#endif
 }
+
 /**
- * @brief Debounces the button input to prevent false triggering due to noise.
- * 
- * This function reads the current state of a button and determines if the 
- * state has changed after a specified debounce delay. It updates the button 
- * state and returns whether the state has changed.
- * 
- * @param buttonPin The pin number connected to the button.
- * @param state A reference to the ButtonState structure holding the button's 
- *              current and last states, as well as the last debounce time.
- * @return true if the button state has changed, false otherwise.
+ * @brief Producer side: debounces one sample of the port and queues its edges.
+ *
+ * Runs in interrupt context. If the queue is full the edges are dropped and
+ * the consumer resynchronizes from the debounced state.
  */
-bool debounceButton(uint8_t buttonPin, ButtonState& state) {
-    // Check if the button pin is valid
-    if (buttonPin >= NUM_DIGITAL_PINS) {
-        return false; // Invalid pin number
+static void sampleButtons(unsigned long time) {
+    uint8_t changed = debounceSample(buttonDebouncer, readPressedButtons());
+    if (!changed) {
+        return;
     }
-    // Read the current time once for consistent time checks
-    unsigned long currentMillis = millis();
-    // Read the current state of the button
-    int newReading = digitalRead(buttonPin);
-    bool stateChanged = false;
-
-    // If the button state has changed, reset the debouncing timer
-    if (newReading != state.lastButtonState) {
-        state.lastDebounceTime = currentMillis;
+    uint8_t head = buttonEventHead;
+    uint8_t next = (head + 1) & (BUTTON_EVENT_QUEUE_SIZE - 1);
+    if (next == buttonEventTail) {
+        buttonEventOverflow = true;
+        return;
     }
+    buttonEvents[head].time = time;
+    buttonEvents[head].pressed = changed & buttonDebouncer.state;
+    buttonEvents[head].released = changed & ~buttonDebouncer.state;
+    buttonEventHead = next; // publish only after the slot is written
+}
 
-    // Check if the button state is stable for longer than the debounce delay
-    if ((currentMillis - state.lastDebounceTime) > state.debounceDelay && newReading != state.currentButtonState) {
-        // Update the current button state and mark state as changed
-        state.currentButtonState = newReading;
-        stateChanged = true;
+/**
+ * @brief Consumer side: takes the oldest edge event from the queue.
+ *
+ * @param event Receives the event.
+ * @return True if an event was available.
+ */
+static bool popButtonEvent(ButtonEvent& event) {
+    uint8_t tail = buttonEventTail;
+    if (tail == buttonEventHead) {
+        return false;
     }
-
-    // Save the current reading as the last button state
-    state.lastButtonState = newReading;
-    return stateChanged;
+    event.time = buttonEvents[tail].time;
+    event.pressed = buttonEvents[tail].pressed;
+    event.released = buttonEvents[tail].released;
+    buttonEventTail = (tail + 1) & (BUTTON_EVENT_QUEUE_SIZE - 1);
+    return true;
 }
 
+#if defined(__AVR__)
 /**
- * @brief Processes input from the rotary encoder and timer button to control the enlarger lamp.
- * 
- * This function checks the states of the rotary encoder button and the timer button.
- * It debounces the button inputs and manages the logic for turning the enlarger lamp on or off.
- * The function also handles storing the timer delay in EEPROM and manages manual lamp control.
+ * @brief Timer0 compare A interrupt, once per millisecond alongside millis().
+ *
+ * Samples the button port every DEBOUNCE_SAMPLE_MS ticks.
  */
-void handleEncoderButton() {
-    if (debounceButton(ROTARY_ENCODER_BUTTON_PIN, encoderButtonState) && encoderButtonState.currentButtonState == LOW) {
-        timerDelay = 0;
-        timerButtonState.buttonIsPressed = false;
-        turnEnlargerLampOff();
+ISR(TIMER0_COMPA_vect) {
+    static uint8_t ticks = 0;
+    if (++ticks >= DEBOUNCE_SAMPLE_MS) {
+        ticks = 0;
+        sampleButtons(millis());
     }
 }
+#endif
 
 /**
- * @brief Manages the lamp's lifecycle based on the desired action.
+ * Initializes button pins.
  *
- * For a short press (lampState true), the lamp is turned on (start exposure).
- * For a long press (lampState false), the manual lamp state is toggled and applied.
+ * Configures the timer and rotary encoder button pins as input with pull-up
+ * resistors and starts the debounce sampling tick. The stored timer delay is
+ * restored later, by restoreEEPROMAddress().
+ */
+ void initializeButtons() {
+    FastPin<TIMER_BUTTON_PIN>::inputPullup();
+    FastPin<ROTARY_ENCODER_BUTTON_PIN>::inputPullup();
+#if defined(__AVR__)
+    // Timer0 already runs millis(); its compare A match adds a 1 kHz tick.
+    // OC0A (D6) is the timer button input, so OCR0A is free for this.
+    OCR0A = 0x80;
+    TIMSK0 |= _BV(OCIE0A);
+#else
+    nextSampleTime = millis();
+#endif
+}
+
+/**
+ * @brief Stops an exposure, manual focus or the light meter, as the encoder push button does.
  *
- * @param lampPin The pin controlling the lamp.
- * @param lampState If true, the lamp is turned on; if false, the manual lamp state is toggled.
+ * The timer is reset to zero, except when leaving the light meter, whose
+ * readings are cleared instead. Gestures in progress on both buttons are
+ * dropped, so releasing a button that is still held does nothing more.
+ * Also used by the ABORT serial command.
  */
- void manageLampLifeCycle(int lampPin, bool lampState) {
-    startExposure = lampState;
-    if (!lampState) {
-        // For a long press, toggle the manual lamp state and use that.
-        turnManuallyOnEnlargerLamp = !turnManuallyOnEnlargerLamp;
-        lampState = turnManuallyOnEnlargerLamp;
-    }
-    digitalWrite(lampPin, lampState);
+void abortLampUse() {
+    gestureCancel(encoderButtonGesture);
+    gestureCancel(timerButtonGesture);
+    if (getTimerState() == TimerState::METER) {
+        clearMeterReadings();
+    } else {
+        timerDelay = 0;
+    }
+    dispatchTimerEvent(TimerEvent::ABORT);
 }
 
 /**
- * @brief Processes the button release event, handling both short and long presses.
+ * @brief Processes gestures of the rotary encoder push button.
+ *
+ * - Single press: switch to the next preset, recalled from the RAM cache of the profile store.
+ * - Double press: reset the timer to zero, keeping the preset.
+ * - Long press (held ENCODER_LONG_PRESS_DELAY): back to no preset, timer at zero.
+ *   Once there, another long press opens the exposure history.
+ *
+ * While the exposure history is shown, any gesture closes it.
+ *
+ * In manual focus a single press opens the light meter and a long press ends
+ * focus. In the light meter a single press takes a reading (highlight, then
+ * shadow), a double press clears them and a long press leaves without using
+ * them (the timer button leaves and sets the suggested exposure).
+ *
+ * Aborting an exposure is handled on the press itself, see dispatchButtonEvent().
  */
-void processButtonRelease() {
-    unsigned long currentMillis = millis();
-    // Update stored timer delay and prepare the enlarger lamp.
-    // Check if enough time has passed since the last EEPROM write
-    if (currentMillis - lastEEPROMWrite >= TimerConfig::EEPROM_WRITE_DELAY) {
-        // Check if the timerDelay has changed since the last EEPROM write
-        if (timerDelay != storedTimerDelay) {
-            int nextAddress = getNextEEPROMAddress();
-            if (writeEEPROMWithRetry(nextAddress, timerDelay)) {
-                DEBUG_PRINTF("EEPROM updated at %d address. Stored delay is %d ms.", nextAddress, timerDelay);
-                eeAddress = nextAddress; // Update current EEPROM address
-                storedTimerDelay = timerDelay; // Update stored delay
-                lastEEPROMWrite = currentMillis; // Update last write time
-                
+void handleEncoderButton(Gesture gesture) {
+    switch (getTimerState()) {
+        case TimerState::HISTORY:
+            if (gesture == Gesture::SINGLE_PRESS || gesture == Gesture::DOUBLE_PRESS || gesture == Gesture::LONG_PRESS) {
+                dispatchTimerEvent(TimerEvent::BROWSE); // not HOLD_RELEASE: the long press that opened it ends
+            }
+            return;
+        case TimerState::MANUAL_FOCUS:
+            if (gesture == Gesture::SINGLE_PRESS) {
+                dispatchTimerEvent(TimerEvent::METER);
+            } else if (gesture == Gesture::LONG_PRESS) {
+                abortLampUse();
+            }
+            return;
+        case TimerState::METER:
+            if (gesture == Gesture::SINGLE_PRESS) {
+                takeMeterReading();
+            } else if (gesture == Gesture::DOUBLE_PRESS) {
+                clearMeterReadings();
+            } else if (gesture == Gesture::LONG_PRESS) {
+                abortLampUse();
+            }
+            return;
+        default:
+            break;
+    }
+    switch (gesture) {
+        case Gesture::SINGLE_PRESS:
+            selectNextPreset();
+            break;
+        case Gesture::DOUBLE_PRESS:
+            timerDelay = 0;
+            break;
+        case Gesture::LONG_PRESS:
+            if (getActivePresetIndex() == NO_PRESET && timerDelay == 0) {
+                dispatchTimerEvent(TimerEvent::BROWSE);
             } else {
-                DEBUG_PRINT("EEPROM write failed, skipping address.");
+                selectPreset(NO_PRESET);
             }
-        } else {
-             DEBUG_PRINT("EEPROM not updated: value unchanged");
-        }
-    } else {
-        DEBUG_PRINT("EEPROM not updated: too soon");
+            break;
+        default:
+            break;
     }
-    storedTimerDelay = timerDelay;
-    turnOnEnlargerLamp = true;
-    globalTime = micros();
+}
 
-    unsigned long elapsedTime = currentMillis - timerButtonState.pressStartTime;
-    timerButtonState.buttonIsPressed = false;
+/**
+ * @brief Processes gestures of the timer button to control the enlarger lamp.
+ *
+ * A short press starts an exposure when the button is released, pauses and
+ * resumes a running one, or ends manual focus and the light meter. A long press toggles manual
+ * focus the moment the hold threshold is crossed, so the manual light
+ * indicator lights up while the button is still held. What each gesture does
+ * in each state is decided by the timer state machine.
+ *
+ * @param gesture The recognized gesture.
+ */
+ void handleTimerButton(Gesture gesture) {
+    if (gesture == Gesture::SINGLE_PRESS) {
+        dispatchTimerEvent(TimerEvent::START);
+    } else if (gesture == Gesture::LONG_PRESS) {
+        dispatchTimerEvent(TimerEvent::HOLD);
+    }
+}
 
-    // Execute actions based on press duration.
-    if (elapsedTime < TimerConfig::TURN_ENLARGER_LAMP_ON_DELAY) {
-        // Short press: start exposure.
-        manageLampLifeCycle(MANUAL_LIGHT_PIN, true);
-    } else {
-        // Long press: toggle manual lamp control.
-        manageLampLifeCycle(MANUAL_LIGHT_PIN, false);
-    }
-
-    // 4. (Optional) Handle the case: user is STILL holding the button
-    //    for immediate feedback, like your original code setting
-    //    "Timer Button is Pressed longer than a manual delay."
-    // if (timerButtonState.buttonIsPressed) {
-    //     unsigned long now = millis();
-    //     if ((now - timerButtonState.pressStartTime) > TimerConfig::TURN_ENLARGER_LAMP_ON_DELAY) {
-    //         DEBUG_PRINT("Timer Button Held > 2s → Lamp ON or Manual Indication");
-    //         digitalWrite(MANUAL_LIGHT_PIN, HIGH);
-    //     }
-    // }
+/**
+ * @brief Reports the gestures of both buttons that became due by the given time.
+ */
+static void pollGestures(unsigned long time) {
+    Gesture gesture;
+    while ((gesture = gesturePoll(encoderButtonGesture, encoderButtonGestures, time)) != Gesture::NONE) {
+        handleEncoderButton(gesture);
+    }
+    while ((gesture = gesturePoll(timerButtonGesture, timerButtonGestures, time)) != Gesture::NONE) {
+        handleTimerButton(gesture);
+    }
 }
 
 /**
- * @brief Processes input from the timer button to control the enlarger lamp.
+ * @brief Hands the debounced edges of one sample to the gesture recognizers.
  *
- * This function debounces the timer button and handles the start and release events.
- * It distinguishes between short and long presses to either start an exposure or toggle
- * the manual lamp mode. Minimal error handling is included given production Arduino constraints.
+ * Gestures that became due before the edges are reported first, so queued
+ * events are classified by their own time, not by when loop() gets to them.
  */
- void handleTimerButtonPress() {
-    // Check for a stable state change using debounce.
-    if (!debounceButton(TIMER_BUTTON_PIN, timerButtonState))
-        return;
+static void dispatchButtonEvent(const ButtonEvent& event) {
+    handledButtons = (handledButtons | event.pressed) & ~event.released;
+    pollGestures(event.time);
+
+    if (event.pressed && getTimerState() == TimerState::FAULT) {
+        // Any press acknowledges the fault; the rest of that press is ignored.
+        if (event.pressed & ENCODER_BUTTON_MASK) gestureEdge(encoderButtonGesture, encoderButtonGestures, true, event.time);
+        if (event.pressed & TIMER_BUTTON_MASK) gestureEdge(timerButtonGesture, timerButtonGestures, true, event.time);
+        gestureCancel(encoderButtonGesture);
+        gestureCancel(timerButtonGesture);
+        dispatchTimerEvent(TimerEvent::ACKNOWLEDGE);
+    }
 
-    // Handle button press start.
-    if (timerButtonState.currentButtonState == LOW && !timerButtonState.buttonIsPressed) {
-        timerButtonState.buttonIsPressed = true;
-        timerButtonState.pressStartTime = millis();
-        // (Optional) Debug: Serial.print("Button pressed at "); Serial.println(timerButtonState.pressStartTime);
+    if (event.pressed & ENCODER_BUTTON_MASK) {
+        if (isExposureActive()) {
+            // The push button aborts at once, without waiting for a gesture.
+            gestureEdge(encoderButtonGesture, encoderButtonGestures, true, event.time);
+            abortLampUse();
+        } else {
+            handleEncoderButton(gestureEdge(encoderButtonGesture, encoderButtonGestures, true, event.time));
+        }
+    }
+    if (event.released & ENCODER_BUTTON_MASK) {
+        handleEncoderButton(gestureEdge(encoderButtonGesture, encoderButtonGestures, false, event.time));
     }
-    // Handle button release.
-    else if (timerButtonState.currentButtonState == HIGH && timerButtonState.buttonIsPressed) {
-        processButtonRelease();
+    if (event.pressed & TIMER_BUTTON_MASK) {
+        handleTimerButton(gestureEdge(timerButtonGesture, timerButtonGestures, true, event.time));
+    }
+    if (event.released & TIMER_BUTTON_MASK) {
+        handleTimerButton(gestureEdge(timerButtonGesture, timerButtonGestures, false, event.time));
     }
 }
+
 /**
  * @brief Handles the input from the rotary encoder and timer button.
  * 
- * This function processes the input from the rotary encoder and timer button
- * by calling the corresponding handler functions. It also manages the long
- * press action for the timer button.
+ * This function drains the debounced edges queued by the sampling tick, feeds
+ * them to the gesture recognizers and calls the corresponding handler
+ * functions for every recognized gesture, including time-based ones such as
+ * a long press crossing its threshold while the button is still held.
  */
 void inputHandler() {
-    handleEncoderButton();
-    handleTimerButtonPress();
+    unsigned long now = millis(); // read first: every queued edge is at or before it
+#if !defined(__AVR__)
+    // No sampling interrupt: catch up on the samples due since the last call
+    if (static_cast<long>(now - nextSampleTime) > static_cast<long>(DEBOUNCE_SAMPLE_MS) * VERTICAL_DEBOUNCE_SAMPLES) {
+        nextSampleTime = now - DEBOUNCE_SAMPLE_MS * VERTICAL_DEBOUNCE_SAMPLES; // older samples would read the same pins
+    }
+    while (static_cast<long>(now - nextSampleTime) >= 0) {
+        sampleButtons(nextSampleTime);
+        nextSampleTime += DEBOUNCE_SAMPLE_MS;
+    }
+#endif
+    ButtonEvent event;
+    while (popButtonEvent(event)) {
+        dispatchButtonEvent(event);
+    }
+    if (buttonEventOverflow) {
+        // Edges were dropped: resynchronize from the debounced state
+        buttonEventOverflow = false;
+        uint8_t debounced = buttonDebouncer.state; // single byte, read atomically
+        event.time = now;
+        event.pressed = debounced & ~handledButtons;
+        event.released = handledButtons & ~debounced;
+        dispatchButtonEvent(event);
+    }
+    pollGestures(now);
 }
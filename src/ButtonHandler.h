@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Tuesday, 18th February 2025 12:26:00 am
+ * Last Modified: Sunday, 18th October 2026 9:57:09 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -28,36 +28,42 @@
 #define ButtonHandler_h
 
 #include <Arduino.h>
+#include "GestureRecognizer.h"
 
 // --- Buttons Configuration ---
 constexpr uint8_t TIMER_BUTTON_PIN = 6;           // Timer start button
 constexpr uint8_t ROTARY_ENCODER_BUTTON_PIN = 4;  // Rotary encoder's push button (resets timer to 0)
  
+// All debounced inputs sit on PORTD and are sampled together in one port read.
+static_assert(TIMER_BUTTON_PIN < 8 && ROTARY_ENCODER_BUTTON_PIN < 8, "Button pins must be on PORTD");
+constexpr uint8_t TIMER_BUTTON_MASK = 1 << TIMER_BUTTON_PIN;
+constexpr uint8_t ENCODER_BUTTON_MASK = 1 << ROTARY_ENCODER_BUTTON_PIN;
+constexpr uint8_t BUTTON_PIN_MASK = TIMER_BUTTON_MASK | ENCODER_BUTTON_MASK; // add footswitch/extra buttons here
+
+constexpr uint8_t DEBOUNCE_SAMPLE_MS = 5; // Sampling period; an edge is accepted after 4 stable samples (20 ms)
+
 /**
- * @brief Represents the state of a button with debouncing logic.
- * 
- * This structure is used to manage the state of a button, including
- * debouncing to prevent false triggers due to noise. It keeps track
- * of the last debounce time, the debounce delay, and the button's
- * last and current states.
- * 
- * @var pressStartTime The last time the button state was toggled.
- * @var debounceDelay The delay in milliseconds to debounce the button.
- * @var lastDebounceTime The last time the button was toggled.
- * @var lastButtonState The previous state of the button.
- * @var currentButtonState The current state of the button.
+ * @brief Debounced edges of all buttons, detected in one sample of the port.
+ *
+ * @var time millis() of the sample that accepted the edges.
+ * @var pressed Mask of buttons pressed in this sample.
+ * @var released Mask of buttons released in this sample.
  */
- struct ButtonState {
-    unsigned long pressStartTime = 0;  // Stores the last time the button was pressed
-    const unsigned long debounceDelay = 50;  // Debounce delay in milliseconds
-    unsigned long lastDebounceTime = 0;  // The last time the output pin was toggled
-    bool lastButtonState = HIGH;  // The previous reading from the input pin
-    bool currentButtonState = HIGH;  // Current state of the button
-    bool buttonIsPressed = false;       // Tracks the button state
-
+struct ButtonEvent {
+    unsigned long time;
+    uint8_t pressed;
+    uint8_t released;
 };
+
+/** @brief Capacity of the edge event queue (power of two, one slot stays free). */
+constexpr uint8_t BUTTON_EVENT_QUEUE_SIZE = 8;
+
+// --- Gesture Timing ---
+constexpr uint16_t ENCODER_LONG_PRESS_DELAY = 1000;  // Encoder button hold: back to no preset, then exposure history (ms)
+constexpr uint16_t DOUBLE_PRESS_WINDOW = 300;        // Encoder button double press: reset timer to zero (ms)
+
 void initializeButtons();
-bool checkButtonState(uint8_t buttonPin, ButtonState& state);
 void inputHandler();
+void abortLampUse();
 
 #endif
@@ -0,0 +1,250 @@
+/*
+ * File: ClockCalibration.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:50:01 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:32:20 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+
+#include "ClockCalibration.h"
+#include "constants.h"
+#include "FastPin.h"
+#include "MemoryUtils.h"
+#include "PresetStore.h"
+#include "SharedValue.h"
+#include "TimerStateMachine.h"
+
+namespace {
+    typedef FastPin<REFERENCE_PIN> ReferencePin;
+
+    constexpr unsigned long PERIOD_TOLERANCE_US = CALIBRATION_REFERENCE_PERIOD_US / 50;   // 2 %, far beyond any resonator
+
+    /** @brief Edges seen by referenceEdgeInterrupt(), written by the interrupt only while armed. */
+    struct ReferenceCapture {
+        unsigned long firstEdge;
+        unsigned long lastEdge;
+        uint8_t edges;
+        bool failed;           // A period was out of tolerance
+    };
+
+    // Written by referenceEdgeInterrupt(); the main loop only resets it while
+    // the interrupt is disarmed (see beginClockCalibration()).
+    SharedValue<ReferenceCapture> capture;
+    volatile bool captureArmed = false;
+    uint8_t targetPulses = 0;
+    unsigned long startedAt = 0;
+
+    CalibrationState state = CalibrationState::IDLE;
+    bool resultPending = false;        // Measured, waiting for an idle timer to be stored
+    long measuredPpm = 0;
+
+    long clockPpm = 0;
+    int32_t toClockFactor = 0;         // ppm * 2^32 / 10^6
+    int32_t toTrueFactor = 0;          // -ppm * 2^32 / (10^6 + ppm)
+
+    /** @brief value * factor / 2^32, rounded (factor is a fraction well below one). */
+    long scale(unsigned long value, int32_t factor) {
+        if (factor == 0) {
+            return 0;   // uncalibrated: skip the 64-bit multiply
+        }
+        return static_cast<long>((static_cast<int64_t>(value) * factor + (1LL << 31)) >> 32);
+    }
+
+    void applyPpm(long ppm) {
+        clockPpm = ppm;
+        toClockFactor = static_cast<int32_t>(static_cast<int64_t>(ppm) * 4294967296LL / 1000000L);
+        toTrueFactor = static_cast<int32_t>(-static_cast<int64_t>(ppm) * 4294967296LL / (1000000L + ppm));
+    }
+
+    void enableReferenceInterrupt(bool enable) {
+#if defined(__AVR__)
+        if (enable) {
+            PCIFR = _BV(PCIF0);           // forget edges from before the measurement
+            PCMSK0 |= _BV(PCINT4);
+            PCICR |= _BV(PCIE0);
+        } else {
+            PCMSK0 &= ~_BV(PCINT4);
+        }
+#endif
+        captureArmed = enable;
+    }
+
+    void finish(CalibrationState result) {
+        enableReferenceInterrupt(false);
+        state = result;
+        DEBUG_PRINTF("Clock calibration finished: state %d, %ld ppm", static_cast<int>(result), measuredPpm);
+    }
+}
+
+#if defined(__AVR__)
+ISR(PCINT0_vect) {
+    referenceEdgeInterrupt();
+}
+#endif
+
+/**
+ * @brief Timestamps a rising edge of the reference pulse. Interrupt context.
+ *
+ * Called by the pin-change interrupt of REFERENCE_PIN; host tests call it
+ * through runInterrupt() after driving the pin.
+ */
+void referenceEdgeInterrupt() {
+    if (!captureArmed || !ReferencePin::read()) {
+        return;   // not measuring, or a falling edge
+    }
+    unsigned long now = micros();
+    ReferenceCapture edge = capture.read();
+    if (edge.edges == 0) {
+        edge.firstEdge = now;
+    } else {
+        unsigned long period = now - edge.lastEdge;
+        if (period < CALIBRATION_REFERENCE_PERIOD_US - PERIOD_TOLERANCE_US
+            || period > CALIBRATION_REFERENCE_PERIOD_US + PERIOD_TOLERANCE_US) {
+            edge.failed = true;   // a glitch or a missed pulse
+        }
+    }
+    edge.lastEdge = now;
+    ++edge.edges;
+    if (edge.failed || edge.edges > targetPulses) {
+        captureArmed = false;     // the main loop masks the interrupt
+    }
+    capture.writeFromISR(edge);
+}
+
+/**
+ * @brief Applies the correction stored with the profile store. Call from setup() after loadPresets().
+ */
+void loadClockCalibration() {
+    long ppm = getStoredClockPpm();
+    applyPpm((ppm >= -CALIBRATION_MAX_PPM && ppm <= CALIBRATION_MAX_PPM) ? ppm : 0);
+    pinMode(REFERENCE_PIN, INPUT);
+}
+
+/**
+ * @brief Starts measuring the oscillator against the reference pulse.
+ *
+ * Returns at once; tickClockCalibration() follows the measurement and stores
+ * the result.
+ *
+ * @param pulses Reference periods to measure (at least one).
+ */
+void beginClockCalibration(uint8_t pulses) {
+    enableReferenceInterrupt(false);   // the handler is disarmed: the loop may write capture
+    ReferenceCapture empty = {0, 0, 0, false};
+    capture.write(empty);
+    targetPulses = max(pulses, static_cast<uint8_t>(1));
+    startedAt = micros();
+    resultPending = false;
+    state = CalibrationState::RUNNING;
+    enableReferenceInterrupt(true);
+}
+
+/**
+ * @brief Follows a running calibration. Call once per loop() pass.
+ *
+ * Fails when the reference stops for two periods (or never starts), and
+ * stores the result once the timer is idle, so the EEPROM commit never
+ * delays an exposure.
+ */
+void tickClockCalibration() {
+    if (resultPending && !isLampInUse()) {
+        resultPending = false;
+        finish(setClockPpm(measuredPpm) ? CalibrationState::DONE : CalibrationState::FAILED);
+        return;
+    }
+    if (state != CalibrationState::RUNNING || resultPending) {
+        return;
+    }
+    ReferenceCapture edge = capture.read();
+    if (edge.failed) {
+        finish(CalibrationState::FAILED);
+        return;
+    }
+    if (edge.edges > targetPulses) {
+        // Positive: micros() counted more than the reference, the board clock runs fast
+        long error = static_cast<long>(edge.lastEdge - edge.firstEdge)
+                   - static_cast<long>(targetPulses * CALIBRATION_REFERENCE_PERIOD_US);
+        long scaled = error * static_cast<long>(1000000UL / CALIBRATION_REFERENCE_PERIOD_US);
+        measuredPpm = (scaled + (scaled >= 0 ? targetPulses / 2 : -(targetPulses / 2))) / targetPulses;
+        if (measuredPpm < -CALIBRATION_MAX_PPM || measuredPpm > CALIBRATION_MAX_PPM) {
+            finish(CalibrationState::FAILED);
+        } else {
+            enableReferenceInterrupt(false);
+            resultPending = true;
+        }
+        return;
+    }
+    unsigned long since = micros() - (edge.edges == 0 ? startedAt : edge.lastEdge);
+    if (since > (edge.edges == 0 ? 3 : 2) * CALIBRATION_REFERENCE_PERIOD_US) {
+        finish(CalibrationState::FAILED);   // no reference signal
+    }
+}
+
+/**
+ * @brief Progress of the last calibration.
+ */
+CalibrationState getCalibrationState() {
+    return state;
+}
+
+/**
+ * @brief Reference edges counted by the running (or last) calibration.
+ */
+uint8_t calibrationPulsesSeen() {
+    return capture.read().edges;
+}
+
+/**
+ * @brief The oscillator correction in use, in parts per million.
+ */
+long getClockPpm() {
+    return clockPpm;
+}
+
+/**
+ * @brief Sets and stores the oscillator correction.
+ *
+ * @param ppm Parts per million the board clock runs fast (negative: slow),
+ *        within +-CALIBRATION_MAX_PPM.
+ * @return False if out of range or the EEPROM commit failed.
+ */
+bool setClockPpm(long ppm) {
+    if (ppm < -CALIBRATION_MAX_PPM || ppm > CALIBRATION_MAX_PPM) {
+        return false;
+    }
+    applyPpm(ppm);
+    return storeClockPpm(ppm);
+}
+
+/**
+ * @brief Converts a duration in real microseconds to micros() counts of this board.
+ */
+unsigned long toClockMicros(unsigned long trueMicros) {
+    return trueMicros + scale(trueMicros, toClockFactor);
+}
+
+/**
+ * @brief Converts micros() counts of this board to real microseconds.
+ */
+unsigned long toTrueMicros(unsigned long clockMicros) {
+    return clockMicros + scale(clockMicros, toTrueFactor);
+}
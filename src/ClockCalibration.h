@@ -0,0 +1,79 @@
+/*
+ * File: ClockCalibration.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:50:01 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:53:24 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+
+#ifndef CLOCK_CALIBRATION_H
+#define CLOCK_CALIBRATION_H
+
+#include <Arduino.h>
+
+/*
+ * Oscillator calibration.
+ *
+ * Many Nano clones run from a ceramic resonator that is off by up to 0.5 %,
+ * which is 3 s on a 599 s exposure however carefully the deadline is kept.
+ * The error is measured against a reference pulse on REFERENCE_PIN, such as
+ * the 1 PPS output of a GPS module: the time between the first and the last
+ * of `pulses` + 1 rising edges, as counted by micros(), is compared with the
+ * nominal CALIBRATION_REFERENCE_PERIOD_US per pulse. The result is stored in
+ * parts per million (positive: the board clock runs fast) with the profile
+ * store, and every exposure deadline is scaled with it in fixed point.
+ *
+ * Each edge is timestamped with micros() in a pin-change interrupt, which is
+ * only enabled while a measurement runs. Interrupt latency adds a few
+ * microseconds of jitter to single edges, but only the first and the last
+ * edge count, so 16 pulses resolve well under 1 ppm.
+ */
+
+constexpr uint8_t REFERENCE_PIN = 12;                              // Reference pulse input (PB4, PCINT4)
+constexpr unsigned long CALIBRATION_REFERENCE_PERIOD_US = 1000000; // Nominal period of the reference (1 PPS)
+constexpr uint8_t CALIBRATION_DEFAULT_PULSES = 16;                 // Reference periods measured by default
+constexpr long CALIBRATION_MAX_PPM = 20000;                        // Larger errors mean a wrong reference signal (fits int16_t)
+
+static_assert(1000000UL % CALIBRATION_REFERENCE_PERIOD_US == 0, "The reference period must divide one second");
+
+/**
+ * @brief Progress of the last calibration.
+ */
+enum class CalibrationState : uint8_t {
+    IDLE,      // No measurement since boot
+    RUNNING,   // Counting reference pulses
+    DONE,      // Measured and stored
+    FAILED     // No reference, a period out of tolerance, or an implausible result
+};
+
+void loadClockCalibration();
+void beginClockCalibration(uint8_t pulses);
+void tickClockCalibration();
+CalibrationState getCalibrationState();
+uint8_t calibrationPulsesSeen();
+long getClockPpm();
+bool setClockPpm(long ppm);
+unsigned long toClockMicros(unsigned long trueMicros);
+unsigned long toTrueMicros(unsigned long clockMicros);
+void referenceEdgeInterrupt();
+
+#endif // CLOCK_CALIBRATION_H
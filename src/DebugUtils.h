@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Monday, 24th February 2025 2:53:23 pm
+ * Last Modified: Sunday, 18th October 2026 8:27:56 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -28,34 +28,31 @@
  * This header provides two macros for debug logging:
  *
  * 1. DEBUG_PRINT:
- *    - Prints a single string along with a detailed debug header.
- *    - The header includes:
- *         - Elapsed time in milliseconds (millis())
- *         - Compile time (__TIME__)
- *         - Function name (__PRETTY_FUNCTION__)
- *         - Source file and line number (__FILE__ and __LINE__)
+ *    - Logs a fixed message. The argument must be a string literal.
  *
  * 2. DEBUG_PRINTF:
  *    - A printf-style macro that supports multiple parameters.
- *    - It formats a message using printf-style formatting into a temporary buffer,
- *      then prints the debug header (as above) followed by the formatted message.
- *    - If the formatted message does not include a newline ('\n'), one is appended automatically.
+ *    - The format must be a string literal; the conversions are applied on the host.
  *
- * Detailed behavior of DEBUG_PRINTF:
- *    - A temporary character buffer of 128 bytes (__dbg_buf) is created.
- *    - The message is formatted into __dbg_buf using snprintf, with the format string and any
- *      additional parameters passed to the macro.
- *    - The macro then prints the following to the Serial interface:
- *         - The current millis() value, followed by "ms : "
- *         - The compile time (__TIME__), followed by a space.
- *         - The function name (__PRETTY_FUNCTION__), followed by a space.
- *         - The file name (__FILE__), a colon, and the line number (__LINE__), followed by a space.
- *         - The formatted message stored in __dbg_buf.
- *    - Finally, the macro checks if the formatted message contains a newline character.
- *      If it does not, it appends a newline by calling Serial.println().
+ * Both macros are tokenized (see TokenLog.h): the message text is placed in flash
+ * with PSTR and never formatted on the board. Each call queues a compact binary
+ * record holding the flash address of the message, the micros() timestamp and
+ * the raw arguments, and flushSerialOutput() sends queued records from loop()
+ * only as fast as the UART accepts them without blocking. Nothing is copied
+ * into SRAM but the arguments, and a call takes microseconds rather than the
+ * milliseconds a formatted line takes at 115200 baud.
+ *
+ * The serial stream is binary. Decode it with the firmware ELF of the same build:
+ * @code
+ *   python3 tools/log_decoder.py --elf darkroom_timer.ino.elf --port /dev/ttyUSB0
+ * @endcode
+ * which prints one line per record:
+ * @code
+ *   1234.567 ms  Timer state 1 -> 2
+ * @endcode
  *
  * @note The macros are only active when the DEBUG flag is defined. If DEBUG is not defined,
- *       both macros will resolve to no-operations.
+ *       both macros will resolve to no-operations. Do not use them from an ISR.
  *
  * @param fmt The format string (as used in printf-style formatting).
  * @param ... Additional arguments matching the format specifiers in fmt.
@@ -64,10 +61,10 @@
  * @code
  *   // Example usage in an Arduino sketch:
  *   #define DEBUG
- *   #include "debugutils.h"
+ *   #include "DebugUtils.h"
  *
  *   void setup() {
- *       Serial.begin(9600);
+ *       Serial.begin(115200);
  *
  *       // Using DEBUG_PRINT to log a simple message.
  *       DEBUG_PRINT("System initializing...");
@@ -75,61 +72,26 @@
  *       // Using DEBUG_PRINTF to log a formatted message.
  *       int temperature = 25;
  *       int humidity = 60;
- *       DEBUG_PRINTF("Temperature: %d°C, Humidity: %d%%", temperature, humidity);
+ *       DEBUG_PRINTF("Temperature: %d C, Humidity: %d%%", temperature, humidity);
  *   }
  *
  *   void loop() {
- *       // Main loop code.
+ *       flushSerialOutput();
  *   }
  * @endcode
- *
- * @see DEBUG_PRINT for logging a simple string with the same debug header.
  */
 
 #ifndef DEBUGUTILS_H
 #define DEBUGUTILS_H
 
 #include <Arduino.h>
-#include <stdio.h>
-#include <string.h>
 
 #ifdef DEBUG
 
-#define DEBUG_PRINT(str)     \
-   Serial.print(millis());     \
-   Serial.print("ms : ");     \
-   Serial.print(__TIME__);     \
-   Serial.print(" ");     \
-   Serial.print(__PRETTY_FUNCTION__);     \
-   Serial.print(' ');     \
-   Serial.print(__FILE__);     \
-   Serial.print(':');     \
-   Serial.print(__LINE__);     \
-   Serial.print(' ');     \
-   Serial.println(str);
+#include "TokenLog.h"
 
-#define DEBUG_PRINTF(fmt, ...) do {                             \
-    char __dbg_buf[128];                                        \
-    /* Format the string into our temporary buffer */         \
-    snprintf(__dbg_buf, sizeof(__dbg_buf), (fmt), ##__VA_ARGS__); \
-    /* Print debug header */                                    \
-    Serial.print(millis());                                     \
-    Serial.print("ms : ");                                      \
-    Serial.print(__TIME__);                                     \
-    Serial.print(" ");                                          \
-    Serial.print(__PRETTY_FUNCTION__);                          \
-    Serial.print(' ');                                          \
-    Serial.print(__FILE__);                                     \
-    Serial.print(':');                                          \
-    Serial.print(__LINE__);                                     \
-    Serial.print(' ');                                          \
-    /* Print the formatted message */                           \
-    Serial.print(__dbg_buf);                                    \
-    /* If no newline is found in the message, add one */        \
-    if (strchr(__dbg_buf, '\n') == NULL) {                      \
-        Serial.println();                                       \
-    }                                                           \
-} while (0)
+#define DEBUG_PRINT(str) logRecord(PSTR(str))
+#define DEBUG_PRINTF(fmt, ...) logRecord(PSTR(fmt), ##__VA_ARGS__)
 
 #else
 
@@ -139,4 +101,3 @@
 #endif
 
 #endif // DEBUGUTILS_H
-
@@ -0,0 +1,114 @@
+/*
+ * File: EncoderAcceleration.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:53:51 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 7:53:51 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#include "EncoderAcceleration.h"
+
+namespace {
+    /** @brief 2^(k/12) for k = 0..11 in Q15 fixed point, for fractional f-stops. */
+    const uint16_t FSTOP_FACTORS[FSTOP_DIVISIONS] PROGMEM = {
+        32768, 34716, 36781, 38968, 41285, 43740,
+        46341, 49097, 52016, 55109, 58386, 61858,
+    };
+
+    const AccelerationStep* accelerationTable(ExposureMode mode) {
+        return (mode == ExposureMode::FSTOP) ? FSTOP_ACCELERATION : LINEAR_ACCELERATION;
+    }
+
+    uint16_t tierMinRate(const AccelerationStep* table, uint8_t tier) {
+        return pgm_read_word(&table[tier].minRate);
+    }
+}
+
+/**
+ * @brief Picks the adjustment for one encoder detent from the mode's acceleration table.
+ *
+ * The detent rate is derived from the time since the previous detent. The
+ * tier climbs by at most one per detent while the rate reaches the next tier,
+ * so a single quick flick does not jump to the coarsest step. A detent slower
+ * than the current tier requires, or a change of direction, returns to the
+ * first (fine) tier immediately.
+ *
+ * @param state Acceleration state, updated for this detent.
+ * @param mode Exposure mode selecting the table.
+ * @param increase True for a detent that increases the delay.
+ * @param time millis() of the detent.
+ * @return The step from the table (ms in LINEAR mode, 1/12 stops in FSTOP mode).
+ */
+uint16_t accelerationStep(EncoderAccelerator& state, ExposureMode mode, bool increase, unsigned long time) {
+    const AccelerationStep* table = accelerationTable(mode);
+    int8_t direction = increase ? 1 : -1;
+    unsigned long interval = time - state.lastDetentTime;
+    uint16_t rate = (state.lastDirection == 0 || interval >= 1000) ? 0 : (interval == 0 ? 1000 : 1000 / interval);
+
+    if (direction != state.lastDirection || rate < tierMinRate(table, state.tier)) {
+        state.tier = 0;
+    } else if (state.tier + 1 < ACCELERATION_TIERS && rate >= tierMinRate(table, state.tier + 1)) {
+        state.tier++;
+    }
+    state.lastDetentTime = time;
+    state.lastDirection = direction;
+    return pgm_read_word(&table[state.tier].step);
+}
+
+/**
+ * @brief Applies one encoder step to a timer delay, within 0..TimerConfig::MAX_DELAY.
+ *
+ * In LINEAR mode the step is added or subtracted in milliseconds. In FSTOP mode
+ * the delay is scaled by 2^(step/12) in fixed point on 0.1 s resolution; a
+ * change too small to show still moves the delay by one increment, and a zero
+ * delay starts from TimerConfig::INCREMENT.
+ *
+ * @param delay Current delay in milliseconds.
+ * @param mode Exposure mode.
+ * @param increase True to lengthen the exposure.
+ * @param step Step returned by accelerationStep().
+ * @return The new delay in milliseconds.
+ */
+long applyEncoderStep(long delay, ExposureMode mode, bool increase, uint16_t step) {
+    if (mode != ExposureMode::FSTOP) {
+        if (increase) {
+            return (delay + step < TimerConfig::MAX_DELAY) ? (delay + step) : TimerConfig::MAX_DELAY;
+        }
+        return (delay > step) ? (delay - step) : 0;
+    }
+
+    // Deciseconds keep the Q15 products within 32 bits (5990 * 2^16 < 2^32).
+    uint32_t tenths = (delay + TimerConfig::INCREMENT / 2) / TimerConfig::INCREMENT;
+    uint32_t scaled = tenths;
+    uint16_t factor = pgm_read_word(&FSTOP_FACTORS[step % FSTOP_DIVISIONS]);
+    for (uint16_t stop = step / FSTOP_DIVISIONS; stop > 0 && scaled > 0; stop--) {
+        scaled = increase ? (scaled << 1) : ((scaled + 1) >> 1);
+        if (scaled > static_cast<uint32_t>(TimerConfig::MAX_DELAY / TimerConfig::INCREMENT)) break;
+    }
+    if (increase) {
+        scaled = (scaled * factor + 16384) >> 15;
+        if (scaled <= tenths) scaled = tenths + 1; // always make progress on short delays
+    } else {
+        scaled = ((scaled << 15) + factor / 2) / factor;
+        if (scaled >= tenths) scaled = (tenths > 0) ? tenths - 1 : 0;
+    }
+    long result = static_cast<long>(scaled) * TimerConfig::INCREMENT;
+    return (result < TimerConfig::MAX_DELAY) ? result : TimerConfig::MAX_DELAY;
+}
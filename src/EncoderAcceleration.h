@@ -0,0 +1,84 @@
+/*
+ * File: EncoderAcceleration.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:53:32 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 7:53:32 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#ifndef ENCODER_ACCELERATION_H
+#define ENCODER_ACCELERATION_H
+
+#include <Arduino.h>
+#include "constants.h"
+
+/**
+ * @brief One tier of an encoder acceleration curve.
+ *
+ * @var minRate Detent rate (detents per second) needed to reach this tier.
+ * @var step Adjustment per detent: milliseconds in LINEAR mode,
+ *           twelfths of a stop in FSTOP mode.
+ */
+struct AccelerationStep {
+    uint16_t minRate;
+    uint16_t step;
+};
+
+// --- Acceleration Curves ---
+// Tiers are sorted by rate. The encoder climbs at most one tier per detent
+// while it turns fast enough, and falls straight back to the first tier as
+// soon as a detent comes slower than the current tier requires.
+constexpr uint8_t ACCELERATION_TIERS = 4;
+constexpr uint16_t FSTOP_DIVISIONS = 12;  // FSTOP steps are 1/12 stop
+
+constexpr AccelerationStep LINEAR_ACCELERATION[ACCELERATION_TIERS] PROGMEM = {
+    {0, 100},    // 0.1 s fine adjustment
+    {8, 500},    // 0.5 s
+    {15, 1000},  // 1 s
+    {25, 5000},  // 5 s for long sweeps
+};
+
+constexpr AccelerationStep FSTOP_ACCELERATION[ACCELERATION_TIERS] PROGMEM = {
+    {0, 1},   // 1/12 stop
+    {8, 2},   // 1/6 stop
+    {15, 4},  // 1/3 stop
+    {25, 12}, // 1 stop
+};
+
+static_assert(LINEAR_ACCELERATION[0].minRate == 0 && FSTOP_ACCELERATION[0].minRate == 0,
+              "The first acceleration tier must accept any rate");
+
+/**
+ * @brief Acceleration state carried between detents.
+ *
+ * @var lastDetentTime millis() of the previous detent.
+ * @var tier Current tier of the acceleration table.
+ * @var lastDirection Direction of the previous detent (+1 up, -1 down, 0 none yet).
+ */
+struct EncoderAccelerator {
+    unsigned long lastDetentTime = 0;
+    uint8_t tier = 0;
+    int8_t lastDirection = 0;
+};
+
+uint16_t accelerationStep(EncoderAccelerator& state, ExposureMode mode, bool increase, unsigned long time);
+long applyEncoderStep(long delay, ExposureMode mode, bool increase, uint16_t step);
+
+#endif // ENCODER_ACCELERATION_H
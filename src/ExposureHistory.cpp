@@ -0,0 +1,283 @@
+/*
+ * File: ExposureHistory.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:37:23 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:55:40 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#include <EEPROM.h>
+#include "ExposureHistory.h"
+#include "LCDHandler.h"
+#include "MemoryUtils.h"
+#include "TimerStateMachine.h"
+
+/*
+ * Exposure history.
+ *
+ * Every finished exposure goes into a small RAM ring first. While the timer
+ * is idle, tickHistory() copies the records that are not in EEPROM yet into
+ * the history log at HISTORY_LOG_ADDRESS, one byte per loop() pass and only
+ * when the EEPROM is not busy, so the copy never blocks the main loop.
+ *
+ * The log is a ring of HISTORY_LOG_RECORDS records of HISTORY_RECORD_SIZE bytes:
+ *   [sequence:2][start ms:4][requested ms:4][lamp us:4][flags:1][crc8:1]
+ * little endian. A record always goes to slot (sequence % HISTORY_LOG_RECORDS),
+ * so the writes rotate over the whole log (wear leveling comes for free), and
+ * any record can be found from its sequence number alone. The CRC is written
+ * last: a record torn by a power cut fails its CRC and is ignored. At boot the
+ * valid record with the highest sequence number is the newest one, and the
+ * history reaches back as long as the sequence numbers are consecutive.
+ *
+ * Records still in RAM when the power goes are lost; an idle timer has them in
+ * EEPROM well within a second.
+ */
+
+namespace {
+    constexpr uint8_t PACKED_SIZE = HISTORY_RECORD_SIZE - 1;   // Without the CRC
+
+    ExposureRecord ramRecords[HISTORY_RAM_RECORDS];
+    uint8_t ramNewest = HISTORY_RAM_RECORDS - 1;   // Index of the newest record in RAM
+    uint8_t ramCount = 0;                          // Records in RAM
+    uint8_t unflushed = 0;                         // Newest records in RAM that are not in EEPROM yet
+    uint8_t logCount = 0;                          // Consecutive records in EEPROM older than those
+    uint16_t nextSequence = 0;
+
+    ExposureRecord current;                        // Exposure in progress
+    bool exposureOpen = false;
+
+    uint8_t flushBuffer[HISTORY_RECORD_SIZE];      // Record being copied to EEPROM
+    uint8_t flushPosition = HISTORY_RECORD_SIZE;   // Next byte to write; HISTORY_RECORD_SIZE when idle
+    int flushAddress = 0;
+
+    uint8_t viewAge = 0;                           // Record shown by the LCD history view (0 = newest)
+    unsigned long viewTouched = 0;
+
+    uint8_t ramIndex(uint8_t age) {
+        return (ramNewest + HISTORY_RAM_RECORDS - age) % HISTORY_RAM_RECORDS;
+    }
+
+    int slotAddress(uint16_t sequence) {
+        return HISTORY_LOG_ADDRESS + (sequence % HISTORY_LOG_RECORDS) * HISTORY_RECORD_SIZE;
+    }
+
+    void pack(const ExposureRecord& record, uint8_t* bytes) {
+        uint32_t fields[3] = {record.startMillis, record.requestedMillis, record.lampMicros};
+        bytes[0] = static_cast<uint8_t>(record.sequence);
+        bytes[1] = static_cast<uint8_t>(record.sequence >> 8);
+        for (uint8_t f = 0; f < 3; ++f) {
+            for (uint8_t i = 0; i < 4; ++i) {
+                bytes[2 + f * 4 + i] = static_cast<uint8_t>(fields[f] >> (8 * i));
+            }
+        }
+        bytes[14] = record.flags;
+        bytes[PACKED_SIZE] = crc8(bytes, PACKED_SIZE);
+    }
+
+    /** @brief Reads a log record, true if its CRC matches and it holds the expected sequence number. */
+    bool readLogRecord(uint16_t sequence, ExposureRecord& record) {
+        uint8_t bytes[HISTORY_RECORD_SIZE];
+        int address = slotAddress(sequence);
+        for (uint8_t i = 0; i < HISTORY_RECORD_SIZE; ++i) {
+            bytes[i] = EEPROM.read(address + i);
+        }
+        if (crc8(bytes, PACKED_SIZE) != bytes[PACKED_SIZE]) {
+            return false;
+        }
+        uint32_t fields[3] = {0, 0, 0};
+        for (uint8_t f = 0; f < 3; ++f) {
+            for (uint8_t i = 0; i < 4; ++i) {
+                fields[f] |= static_cast<uint32_t>(bytes[2 + f * 4 + i]) << (8 * i);
+            }
+        }
+        record.sequence = bytes[0] | (bytes[1] << 8);
+        record.startMillis = fields[0];
+        record.requestedMillis = fields[1];
+        record.lampMicros = fields[2];
+        record.flags = bytes[14];
+        return record.sequence == sequence;
+    }
+}
+
+/**
+ * @brief Finds the newest record of the EEPROM log. Call once from setup().
+ */
+void loadHistory() {
+    ExposureRecord record;
+    ramCount = 0;
+    unflushed = 0;
+    exposureOpen = false;
+    flushPosition = HISTORY_RECORD_SIZE;
+    bool found = false;
+    uint16_t newest = 0;
+    for (uint8_t slot = 0; slot < HISTORY_LOG_RECORDS; ++slot) {
+        // A slot only ever holds the sequence numbers that map to it
+        int address = HISTORY_LOG_ADDRESS + slot * HISTORY_RECORD_SIZE;
+        uint16_t sequence = EEPROM.read(address) | (EEPROM.read(address + 1) << 8);
+        if (sequence % HISTORY_LOG_RECORDS != slot || !readLogRecord(sequence, record)) {
+            continue;
+        }
+        // Sequence numbers wrap: the newer one is ahead by less than half the range
+        if (!found || static_cast<int16_t>(sequence - newest) > 0) {
+            newest = sequence;
+            found = true;
+        }
+    }
+    nextSequence = found ? newest + 1 : 0;
+    logCount = 0;
+    while (logCount < HISTORY_LOG_RECORDS && readLogRecord(nextSequence - 1 - logCount, record)) {
+        ++logCount;
+    }
+    DEBUG_PRINTF("History: %d records, next exposure #%u", logCount, nextSequence);
+}
+
+/**
+ * @brief Opens the record of an exposure that is being armed.
+ *
+ * @param requestedMillis The stored timer delay the exposure starts with.
+ * @param mode The exposure mode.
+ * @param dose True for a light-integrating exposure.
+ */
+void recordExposureStart(long requestedMillis, ExposureMode mode, bool dose) {
+    current.sequence = nextSequence;
+    current.startMillis = millis();
+    current.requestedMillis = static_cast<uint32_t>(requestedMillis);
+    current.lampMicros = 0;
+    current.flags = (static_cast<uint8_t>(mode) & HISTORY_MODE_MASK) | (dose ? HISTORY_DOSE : 0);
+    exposureOpen = true;
+}
+
+/**
+ * @brief Closes the open exposure record and puts it into the RAM ring.
+ *
+ * @param lampMicros Measured relay-on time of the exposure.
+ * @param aborted True if the exposure was stopped before its deadline.
+ */
+void recordExposureEnd(unsigned long lampMicros, bool aborted) {
+    if (!exposureOpen) {
+        return;
+    }
+    exposureOpen = false;
+    current.lampMicros = lampMicros;
+    if (aborted) {
+        current.flags |= HISTORY_ABORTED;
+    }
+    ramNewest = (ramNewest + 1) % HISTORY_RAM_RECORDS;
+    ramRecords[ramNewest] = current;
+    if (ramCount < HISTORY_RAM_RECORDS) {
+        ++ramCount;
+    }
+    if (unflushed < HISTORY_RAM_RECORDS) {
+        ++unflushed;
+    } else {
+        logCount = 0;   // the oldest unsaved record was overwritten: the log is no longer contiguous
+    }
+    ++nextSequence;
+}
+
+/**
+ * @brief Copies finished records to the EEPROM log while the timer is idle.
+ *
+ * Writes at most one byte per call, and only when the EEPROM is ready, so it
+ * never waits for a write to complete. Call once per loop() pass.
+ */
+void tickHistory() {
+    if (getTimerState() != TimerState::IDLE || !isEEPROMReady()) {
+        return;
+    }
+    if (flushPosition < HISTORY_RECORD_SIZE) {
+        EEPROM.update(flushAddress + flushPosition, flushBuffer[flushPosition]);
+        if (++flushPosition == HISTORY_RECORD_SIZE) {
+            --unflushed;
+            ++logCount;
+        }
+        return;
+    }
+    if (unflushed > 0) {
+        const ExposureRecord& record = ramRecords[ramIndex(unflushed - 1)];
+        pack(record, flushBuffer);
+        flushAddress = slotAddress(record.sequence);
+        flushPosition = 0;
+        if (logCount == HISTORY_LOG_RECORDS) {
+            --logCount;   // the slot holds the oldest record of the log
+        }
+    }
+}
+
+/**
+ * @brief Number of records that can be read back, newest first.
+ */
+uint8_t historyCount() {
+    return unflushed + logCount;
+}
+
+/**
+ * @brief Reads a record from RAM or from the EEPROM log.
+ *
+ * @param age 0 for the newest exposure, 1 for the one before, and so on.
+ * @param record Receives the record.
+ * @return False if the record is not available.
+ */
+bool getHistoryRecord(uint8_t age, ExposureRecord& record) {
+    if (age >= historyCount()) {
+        return false;
+    }
+    if (age < ramCount) {
+        record = ramRecords[ramIndex(age)];
+        return true;
+    }
+    return readLogRecord(nextSequence - 1 - age, record);
+}
+
+/**
+ * @brief Shows the newest exposure on the LCD (entry action of the history view).
+ */
+void openHistoryView() {
+    viewAge = 0;
+    viewTouched = millis();
+    ExposureRecord record;
+    bool found = getHistoryRecord(viewAge, record);
+    displayHistoryRecord(found ? &record : nullptr, viewAge, historyCount());
+}
+
+/**
+ * @brief Moves the history view one exposure back or forward.
+ *
+ * @param older True to show the exposure before the one shown.
+ */
+void scrollHistoryView(bool older) {
+    viewTouched = millis();
+    uint8_t count = historyCount();
+    if (older ? viewAge + 1 >= count : viewAge == 0) {
+        return;
+    }
+    viewAge += older ? 1 : -1;
+    ExposureRecord record;
+    bool found = getHistoryRecord(viewAge, record);
+    displayHistoryRecord(found ? &record : nullptr, viewAge, count);
+}
+
+/**
+ * @brief True once the history view has been left alone for HISTORY_VIEW_TIMEOUT.
+ */
+bool historyViewExpired() {
+    return millis() - viewTouched >= HISTORY_VIEW_TIMEOUT;
+}
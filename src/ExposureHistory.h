@@ -0,0 +1,71 @@
+/*
+ * File: ExposureHistory.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:37:23 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:06:09 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#ifndef EXPOSURE_HISTORY_H
+#define EXPOSURE_HISTORY_H
+
+#include <Arduino.h>
+#include "constants.h"
+
+constexpr uint8_t HISTORY_RAM_RECORDS = 4;        // Newest exposures kept in RAM
+constexpr uint8_t HISTORY_RECORD_SIZE = 16;       // Bytes per record in the EEPROM log, CRC included
+constexpr uint8_t HISTORY_LOG_RECORDS = HISTORY_LOG_SIZE / HISTORY_RECORD_SIZE;
+constexpr uint8_t HISTORY_ABORTED = 0x80;         // ExposureRecord::flags: stopped before the deadline
+constexpr uint8_t HISTORY_DOSE = 0x40;            // ExposureRecord::flags: light-integrating exposure
+constexpr uint8_t HISTORY_MODE_MASK = 0x0F;       // ExposureRecord::flags: ExposureMode
+constexpr unsigned long HISTORY_VIEW_TIMEOUT = 30000; // The LCD history view closes itself (ms)
+
+static_assert(HISTORY_LOG_SIZE % HISTORY_RECORD_SIZE == 0 && 65536UL % HISTORY_LOG_RECORDS == 0,
+              "The history log must hold a power-of-two number of whole records");
+
+/**
+ * @brief One exposure, as printed.
+ *
+ * @var sequence Exposure number, counting on across reboots (wraps at 65536).
+ * @var startMillis millis() when the exposure was started (time since power-on).
+ * @var requestedMillis The stored timer delay the exposure was started with.
+ * @var lampMicros Time the relay was actually on, across pauses and burn-in changes.
+ * @var flags ExposureMode in the low nibble, HISTORY_DOSE, HISTORY_ABORTED.
+ */
+struct ExposureRecord {
+    uint16_t sequence;
+    uint32_t startMillis;
+    uint32_t requestedMillis;
+    uint32_t lampMicros;
+    uint8_t flags;
+};
+
+void loadHistory();
+void recordExposureStart(long requestedMillis, ExposureMode mode, bool dose);
+void recordExposureEnd(unsigned long lampMicros, bool aborted);
+void tickHistory();
+uint8_t historyCount();
+bool getHistoryRecord(uint8_t age, ExposureRecord& record);
+void openHistoryView();
+void scrollHistoryView(bool older);
+bool historyViewExpired();
+
+#endif // EXPOSURE_HISTORY_H
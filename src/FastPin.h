@@ -0,0 +1,80 @@
+/*
+ * File: FastPin.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:02:27 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:02:27 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#ifndef FAST_PIN_H
+#define FAST_PIN_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Compile-time digital pin with direct port register access.
+ *
+ * The pin number is a template argument, so the port and bit are resolved by
+ * the compiler: on the ATmega328P high(), low() and toggle() compile to a
+ * single sbi/cbi instruction, and read() to a single sbic/sbis test. There is
+ * no pin lookup table, no PWM check and no interrupt lock as in digitalWrite().
+ *
+ * Pin numbering follows the Arduino Nano: D0-D7 on PORTD, D8-D13 on PORTB and
+ * A0-A5 (14-19) on PORTC. Any other pin number fails the build.
+ *
+ * Builds for other targets (such as the host tests) fall back to the Arduino
+ * pin functions.
+ *
+ * @tparam PIN Arduino digital pin number.
+ */
+template <uint8_t PIN>
+struct FastPin {
+    static_assert(PIN < 20, "FastPin: not a digital pin of the Arduino Nano (0-19)");
+
+    /** @brief Bit of the pin within its port. */
+    static constexpr uint8_t MASK = 1 << (PIN < 8 ? PIN : (PIN < 14 ? PIN - 8 : PIN - 14));
+
+#if defined(__AVR__)
+    static volatile uint8_t& portRegister() { return PIN < 8 ? PORTD : (PIN < 14 ? PORTB : PORTC); }
+    static volatile uint8_t& ddrRegister() { return PIN < 8 ? DDRD : (PIN < 14 ? DDRB : DDRC); }
+    static volatile uint8_t& pinRegister() { return PIN < 8 ? PIND : (PIN < 14 ? PINB : PINC); }
+
+    static inline void high() { portRegister() |= MASK; }
+    static inline void low() { portRegister() &= ~MASK; }
+    static inline void toggle() { pinRegister() = MASK; } // writing PINx toggles PORTx
+    static inline bool read() { return pinRegister() & MASK; }
+    static inline void output() { ddrRegister() |= MASK; }
+    static inline void input() { ddrRegister() &= ~MASK; portRegister() &= ~MASK; }
+    static inline void inputPullup() { ddrRegister() &= ~MASK; portRegister() |= MASK; }
+#else
+    static inline void high() { digitalWrite(PIN, HIGH); }
+    static inline void low() { digitalWrite(PIN, LOW); }
+    static inline void toggle() { digitalWrite(PIN, !digitalRead(PIN)); }
+    static inline bool read() { return digitalRead(PIN); }
+    static inline void output() { pinMode(PIN, OUTPUT); }
+    static inline void input() { pinMode(PIN, INPUT); }
+    static inline void inputPullup() { pinMode(PIN, INPUT_PULLUP); }
+#endif
+
+    /** @brief Writes a level known only at run time (one branch plus sbi/cbi). */
+    static inline void write(bool level) { level ? high() : low(); }
+};
+
+#endif // FAST_PIN_H
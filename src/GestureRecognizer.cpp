@@ -0,0 +1,114 @@
+/*
+ * File: GestureRecognizer.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:58:36 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:40:32 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#include "GestureRecognizer.h"
+
+namespace {
+    enum Phase : uint8_t {
+        IDLE,            // Button up, nothing pending
+        PRESSED,         // First press, hold threshold not reached yet
+        WAIT_SECOND,     // Released after a short press, double press window open
+        WAIT_RELEASE,    // Double press reported or press cancelled: the release ends it quietly
+        HELD,            // LONG_PRESS reported, waiting for the release
+    };
+
+    /** @brief True once time has reached deadline (wrap-safe; time may lie before deadline). */
+    bool reached(unsigned long time, unsigned long deadline) {
+        return static_cast<long>(time - deadline) >= 0;
+    }
+}
+
+/**
+ * @brief Feeds a debounced press or release edge to the recognizer.
+ *
+ * Call gesturePoll() with the edge time first, so that gestures which became
+ * due before this edge are reported in order even if the edge is handled late.
+ *
+ * @param state Recognizer state of the button.
+ * @param config Gesture timing of the button.
+ * @param pressed True for a press, false for a release.
+ * @param time Time of the edge.
+ * @return The gesture completed by this edge, or Gesture::NONE.
+ */
+Gesture gestureEdge(GestureState& state, const GestureConfig& config, bool pressed, unsigned long time) {
+    Gesture gesture = Gesture::NONE;
+    if (pressed) {
+        if (state.phase == WAIT_SECOND) {
+            state.phase = WAIT_RELEASE;
+            gesture = Gesture::DOUBLE_PRESS;
+        } else if (state.phase == IDLE) {
+            state.phase = PRESSED;
+        }
+    } else {
+        if (state.phase == PRESSED) {
+            if (config.doublePressMs == 0) {
+                state.phase = IDLE;
+                gesture = Gesture::SINGLE_PRESS;
+            } else {
+                state.phase = WAIT_SECOND;
+            }
+        } else if (state.phase == HELD) {
+            state.phase = IDLE;
+            gesture = Gesture::HOLD_RELEASE;
+        } else if (state.phase == WAIT_RELEASE) {
+            state.phase = IDLE;
+        }
+    }
+    state.edgeTime = time;
+    return gesture;
+}
+
+/**
+ * @brief Reports a gesture that became due by time alone.
+ *
+ * A held press crossing config.longPressMs yields LONG_PRESS; an expired
+ * double press window yields the pending SINGLE_PRESS. Both deadlines run
+ * from the edge time, and callers poll with the time of the next queued edge
+ * before handing it over, so the result does not depend on how often loop()
+ * runs.
+ *
+ * @param state Recognizer state of the button.
+ * @param config Gesture timing of the button.
+ * @param now Current time (or the time of the next edge).
+ * @return The due gesture, or Gesture::NONE.
+ */
+Gesture gesturePoll(GestureState& state, const GestureConfig& config, unsigned long now) {
+    if (state.phase == PRESSED && reached(now, state.edgeTime + config.longPressMs)) {
+        state.phase = HELD;
+        return Gesture::LONG_PRESS;
+    }
+    if (state.phase == WAIT_SECOND && reached(now, state.edgeTime + config.doublePressMs)) {
+        state.phase = IDLE;
+        return Gesture::SINGLE_PRESS;
+    }
+    return Gesture::NONE;
+}
+
+/**
+ * @brief Drops any gesture in progress; the rest of the current press is ignored.
+ */
+void gestureCancel(GestureState& state) {
+    state.phase = (state.phase == IDLE || state.phase == WAIT_SECOND) ? IDLE : WAIT_RELEASE;
+}
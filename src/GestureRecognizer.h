@@ -0,0 +1,74 @@
+/*
+ * File: GestureRecognizer.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:58:35 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:40:32 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Gestures reported for a button.
+ *
+ * LONG_PRESS is reported the moment the hold threshold is crossed, while the
+ * button is still down, so the user gets feedback without releasing it.
+ * HOLD_RELEASE then marks the end of that press-and-hold.
+ */
+enum class Gesture : uint8_t {
+    NONE,
+    SINGLE_PRESS,
+    DOUBLE_PRESS,
+    LONG_PRESS,
+    HOLD_RELEASE,
+};
+
+/**
+ * @brief Timing of the gestures of one button.
+ *
+ * @var longPressMs How long a press must be held to become a LONG_PRESS.
+ * @var doublePressMs Window after a release in which a second press makes a
+ *      DOUBLE_PRESS. 0 disables double presses, so SINGLE_PRESS is reported on
+ *      release without any delay.
+ */
+struct GestureConfig {
+    uint16_t longPressMs;
+    uint16_t doublePressMs;
+};
+
+/**
+ * @brief Recognizer state of one button.
+ *
+ * @var edgeTime Time of the last press or release edge.
+ * @var phase Internal phase of the recognizer.
+ */
+struct GestureState {
+    unsigned long edgeTime = 0;
+    uint8_t phase = 0;
+};
+
+Gesture gestureEdge(GestureState& state, const GestureConfig& config, bool pressed, unsigned long time);
+Gesture gesturePoll(GestureState& state, const GestureConfig& config, unsigned long now);
+void gestureCancel(GestureState& state);
+
+#endif // GESTURE_RECOGNIZER_H
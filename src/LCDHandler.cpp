@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Tuesday, 25th February 2025 12:33:53 pm
+ * Last Modified: Sunday, 18th October 2026 9:00:56 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -23,9 +23,11 @@
  */
 
 #include <avr/pgmspace.h>
-#include "lcdHandler.h"
+#include "LCDHandler.h"
 #include "constants.h"
+#include "ExposureHistory.h"
 #include "MemoryUtils.h"
+#include "PresetStore.h"
 
 // Define the desired LCD layout:
 #define SELECTED_LCD_LAYOUT LCDLayout4x20 // see constants.h for definitions
@@ -308,9 +310,7 @@ void printCentered(const __FlashStringHelper* text, int row) {
  */
 void displaySplashScreen() { 
     lcd.clear();
-    uint8_t len = strlen_P(SplashScreen::LINE_ONE_TEXT);
     printCentered(reinterpret_cast<const __FlashStringHelper*>(SplashScreen::LINE_ONE_TEXT),SELECTED_LCD_LAYOUT::LCD_ROW_ONE);
-    len = strlen_P(SplashScreen::LINE_TWO_TEXT);
     printCentered(reinterpret_cast<const __FlashStringHelper*>(SplashScreen::LINE_TWO_TEXT), SELECTED_LCD_LAYOUT::LCD_ROW_TWO);
 
     char buffer[SELECTED_LCD_LAYOUT::LCD_COLS + 1];
@@ -338,15 +338,16 @@ void displaySplashScreen() {
  * Calculates digit values and renders them with leading zero suppression.
  * Only updates when the displayed time has changed to minimize LCD operations.
  */
+ // Constants for display management
+ constexpr uint8_t EMPTY_DIGIT = 0xFF;
+ // Only update if the displayed time has changed
+ static uint16_t previousDeciseconds = UINT16_MAX;
+ // Store current digit values to track when a redraw is needed
+ static uint8_t displayedDigits[3] = {EMPTY_DIGIT, EMPTY_DIGIT, EMPTY_DIGIT};
+
  void updateTimerDisplay() {
-  // Constants for display management
-  constexpr uint8_t EMPTY_DIGIT = 0xFF;
-  
   // Calculate time value in deciseconds (0.1s)
   uint16_t deciseconds = timerDelay / 100;
-  
-  // Only update if the displayed time has changed
-  static uint16_t previousDeciseconds = UINT16_MAX;
 
   // Get positions from layout constants
   const uint8_t positions[3] = {
@@ -363,9 +364,6 @@ void displaySplashScreen() {
       uint8_t secondDigit = (deciseconds / 10) % 10;        // 1s place
       uint8_t thirdDigit = deciseconds / 100;               // 10s place
       
-      // Store current digit values to track when a redraw is needed
-      static uint8_t displayedDigits[3] = {EMPTY_DIGIT, EMPTY_DIGIT, EMPTY_DIGIT};
-      
       // Create a local digit array for current values
       uint8_t digits[3] = {firstDigit, secondDigit, thirdDigit};
       
@@ -404,8 +402,25 @@ void displaySplashScreen() {
   }
 }
 
+/**
+ * @brief Redraws the whole timer screen after another screen replaced it.
+ */
+ void redrawTimerScreen() {
+  lcd.clear();
+  displayStaticText();
+  displayPresetName();
+  previousDeciseconds = UINT16_MAX;
+  for (uint8_t i = 0; i < 3; i++) {
+    displayedDigits[i] = EMPTY_DIGIT;
+  }
+  updateTimerDisplay();
+}
+
 /**
  * @brief Displays an error message on the LCD indicating EEPROM failure.
+ *
+ * The message stays until the user acknowledges it with a button press,
+ * see the FAULT state of the timer state machine.
  */
  void displayEEPROMError() {
   lcd.clear();
@@ -413,5 +428,107 @@ void displaySplashScreen() {
   lcd.print(F("EEPROM Failure!"));
   lcd.setCursor(0, 1);
   lcd.print(F("Replace ASAP!"));
-  delay(2000); // Display for 2 seconds
+  lcd.setCursor(0, 3);
+  lcd.print(F("Press any button"));
+}
+
+/**
+ * @brief Shows the name of the active preset right of the big digits.
+ *
+ * The field is blanked when no preset is selected.
+ */
+void displayPresetName() {
+  lcd.setCursor(SELECTED_LCD_LAYOUT::PRESET_NAME_COL, SELECTED_LCD_LAYOUT::PRESET_NAME_ROW);
+  uint8_t index = getActivePresetIndex();
+  const char* name = (index == NO_PRESET) ? "" : getPreset(index).name;
+  uint8_t printed = 0;
+  for (; name[printed] != '\0' && printed < PRESET_NAME_LENGTH - 1; ++printed) {
+    lcd.write(name[printed]);
+  }
+  for (; printed < PRESET_NAME_LENGTH - 1; ++printed) {
+    lcd.write(' ');
+  }
+}
+
+/**
+ * @brief Shows one record of the exposure history (the HISTORY state of the timer).
+ *
+ * Rows: exposure number and position in the history, requested time and mode,
+ * measured lamp time, how the exposure ended and when it was started (uptime).
+ *
+ * @param record The record, or nullptr when the history is empty.
+ * @param age Position of the record, 0 for the newest.
+ * @param count Number of records in the history.
+ */
+void displayHistoryRecord(const ExposureRecord* record, uint8_t age, uint8_t count) {
+  lcd.clear();
+  if (record == nullptr) {
+    printCentered(F("Exposure history"), SELECTED_LCD_LAYOUT::LCD_ROW_TWO);
+    printCentered(F("No exposures yet"), SELECTED_LCD_LAYOUT::LCD_ROW_THREE);
+    return;
+  }
+  char buffer[32]; // in-range values fit the 20 columns, the margin keeps snprintf from cutting the rest short
+  snprintf_P(buffer, sizeof(buffer), PSTR("Exposure #%-5u%2u/%u"), record->sequence, age + 1, count);
+  lcd.setCursor(0, SELECTED_LCD_LAYOUT::LCD_ROW_ONE);
+  lcd.print(buffer);
+  bool fstop = (record->flags & HISTORY_MODE_MASK) == static_cast<uint8_t>(ExposureMode::FSTOP);
+  unsigned long requested = record->requestedMillis;
+  snprintf_P(buffer, sizeof(buffer), PSTR("Set  %3lu.%lus %s"), requested / 1000UL, (requested % 1000UL) / 100UL,
+             fstop ? "F-STOP" : "LINEAR");
+  lcd.setCursor(0, SELECTED_LCD_LAYOUT::LCD_ROW_TWO);
+  lcd.print(buffer);
+  unsigned long lamp = record->lampMicros;
+  snprintf_P(buffer, sizeof(buffer), PSTR("Lamp %3lu.%03lus"), lamp / 1000000UL, (lamp / 1000UL) % 1000UL);
+  lcd.setCursor(0, SELECTED_LCD_LAYOUT::LCD_ROW_THREE);
+  lcd.print(buffer);
+  snprintf_P(buffer, sizeof(buffer), PSTR("%-7s at %lus"), (record->flags & HISTORY_ABORTED) ? "Aborted" : "Done",
+             static_cast<unsigned long>(record->startMillis) / 1000UL);
+  lcd.setCursor(0, SELECTED_LCD_LAYOUT::LCD_ROW_FOUR);
+  lcd.print(buffer);
+}
+
+/**
+ * @brief Prints a whole row, blank-padded, so a screen can be updated without clearing it (no flicker).
+ */
+static void printRow(uint8_t row, const char* text) {
+  lcd.setCursor(0, row);
+  uint8_t printed = 0;
+  for (; text[printed] != '\0' && printed < SELECTED_LCD_LAYOUT::LCD_COLS; ++printed) {
+    lcd.write(text[printed]);
+  }
+  for (; printed < SELECTED_LCD_LAYOUT::LCD_COLS; ++printed) {
+    lcd.write(' ');
+  }
+}
+
+/**
+ * @brief Shows the light meter (the METER state of the timer).
+ *
+ * Rows: live reading, highlight and shadow readings (a dash until taken) and
+ * the suggested exposure and paper grade.
+ *
+ * @param live The live reading.
+ * @param highlight The highlight reading, 0 if not taken.
+ * @param shadow The shadow reading, 0 if not taken.
+ * @param delayMillis Suggested exposure, negative if there is none yet.
+ * @param grade Suggested paper grade, 0xFF if there is none yet.
+ */
+void displayMeter(uint16_t live, uint16_t highlight, uint16_t shadow, long delayMillis, uint8_t grade) {
+  char buffer[32];
+  snprintf_P(buffer, sizeof(buffer), PSTR("Light      %5u"), live);
+  printRow(SELECTED_LCD_LAYOUT::LCD_ROW_ONE, buffer);
+  snprintf_P(buffer, sizeof(buffer), highlight ? PSTR("Highlight  %5u") : PSTR("Highlight      -"), highlight);
+  printRow(SELECTED_LCD_LAYOUT::LCD_ROW_TWO, buffer);
+  snprintf_P(buffer, sizeof(buffer), shadow ? PSTR("Shadow     %5u") : PSTR("Shadow         -"), shadow);
+  printRow(SELECTED_LCD_LAYOUT::LCD_ROW_THREE, buffer);
+  uint16_t seconds = static_cast<uint16_t>(delayMillis / 1000);
+  uint8_t tenths = static_cast<uint8_t>((delayMillis % 1000) / 100);
+  if (delayMillis < 0) {
+    snprintf_P(buffer, sizeof(buffer), PSTR("Press to read"));
+  } else if (grade == 0xFF) {
+    snprintf_P(buffer, sizeof(buffer), PSTR("Set %3u.%us"), seconds, tenths);
+  } else {
+    snprintf_P(buffer, sizeof(buffer), PSTR("Set %3u.%us grade %u"), seconds, tenths, grade);
+  }
+  printRow(SELECTED_LCD_LAYOUT::LCD_ROW_FOUR, buffer);
 }
@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Tuesday, 18th February 2025 9:12:53 am
+ * Last Modified: Sunday, 18th October 2026 9:00:56 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -25,6 +25,8 @@
 #ifndef LCD_HANDLER_H
 #define LCD_HANDLER_H
 
+struct ExposureRecord;
+
 // Function declarations
 void testLCD();
 void initializeLCD();
@@ -33,5 +35,9 @@ void displaySplashScreen();
 void updateTimerDisplay();
 void drawOrEraseBigDigit(uint8_t position, uint8_t digit = 0, bool erase = false);
 void displayEEPROMError();
+void redrawTimerScreen();
+void displayPresetName();
+void displayHistoryRecord(const ExposureRecord* record, uint8_t age, uint8_t count);
+void displayMeter(uint16_t live, uint16_t highlight, uint16_t shadow, long delayMillis, uint8_t grade);
 
 #endif // LCD_HANDLER_H
@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Tuesday, 25th February 2025 10:25:56 am
+ * Last Modified: Sunday, 18th October 2026 9:19:27 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -24,6 +24,9 @@
 
 #include "LampControl.h"
 #include "constants.h"
+#include "FastPin.h"
+#include "LampModel.h"
+#include "OutputScheduler.h"
 #include <LiquidCrystal_I2C.h>
 
 extern LiquidCrystal_I2C lcd;
@@ -31,79 +34,77 @@ extern LiquidCrystal_I2C lcd;
 /**
  * @brief Tests the enlarger lamp by toggling the relay pin.
  *
- * This function sets the relay pin to output mode and turns it on for 1 second
- * to test the enlarger lamp. After the delay, it turns the relay off and sets
- * the manual light pin to output mode.
+ * This function sets up the output channels (safelight on, everything else
+ * off) and turns the relay on for 1 second to test the enlarger lamp.
  */
 void testEnlargerLamp() {
-    pinMode(RELAY_PIN, OUTPUT);
-    digitalWrite(RELAY_PIN, HIGH);
+    initializeOutputs();
+    switchOutputs(ENLARGER_OUTPUT, 0);
     delay(1000);
-    digitalWrite(RELAY_PIN, LOW);
-    pinMode(MANUAL_LIGHT_PIN, OUTPUT);
+    switchOutputs(0, ENLARGER_OUTPUT);
 }
  
 /**
- *  @brief Turns the enlarger lamp on if it is not manually turned off.
- * 
- * This function first checks if the lamp is manually turned off. If not, it
- * ensures the lamp is turned off before proceeding. If the lamp is set to be
- * turned on, it activates the lamp by setting the relay pin high and turns off
- * the LCD backlight. The flag to turn on the lamp is then reset.
+ * @brief Turns the enlarger lamp on for an exposure.
+ *
+ * Switches the relay on and turns off the LCD backlight to prevent light
+ * leaks. The exposure deadline is set by the caller right after this call.
  */
 void turnEnlargerLampOn() {
-    if (turnOnEnlargerLamp) {
-        DEBUG_PRINT("Turning enlarger lamp ON");
-        digitalWrite(RELAY_PIN, HIGH);
-        lcd.noBacklight();
-        turnOnEnlargerLamp = false;
-    }
+    DEBUG_PRINT("Turning enlarger lamp ON");
+    switchOutputs(ENLARGER_OUTPUT, 0);
+    lcd.noBacklight();
 }
 
 /**
- * @brief Handles the operation of the enlarger lamp based on manual control and timer settings.
- * 
- * This function turns on the enlarger lamp if it is not manually turned off. It checks
- * if the exposure timer has reached its configured duration and adjusts the timer delay
- * accordingly. If the timer delay reaches its minimum increment, the lamp is turned off
- * and exposure is stopped.
+ * @brief Turns off the enlarger lamp and the manual light indicator.
+ *
+ * This function switches the relay and manual light channels off together,
+ * and turns on the LCD backlight. The timer state machine calls it when it returns to idle.
  */
-void handleEnlargerLamp() {
-    // Turn on the enlarger lamp if it's not already manually turned off
-    if (!turnManuallyOnEnlargerLamp) {
-        turnEnlargerLampOn();
-    }
+void turnEnlargerLampOff() {
+    DEBUG_PRINT("Turning enlarger lamp OFF");
+    switchOutputs(0, ENLARGER_OUTPUT | FOCUS_LIGHT_OUTPUT);
+    lcd.backlight();
+}
 
-    // Check if the exposure timer has reached its TimerConfig::DURATION
-    unsigned long currentTime = micros();
-    if ((currentTime - globalTime) >= TimerConfig::DURATION) {
-        // Reset the timer if micros() has rolled over
-        globalTime = (currentTime < globalTime) ? currentTime : globalTime + TimerConfig::DURATION;
+static_assert(LAMP_COMPENSATION[0].requestedMillis == 0, "The compensation curve must start at 0 ms");
 
-        // Decrease the timer delay
-        if (timerDelay > TimerConfig::INCREMENT) {
-            timerDelay -= TimerConfig::INCREMENT;
-        } else {
-            timerDelay = storedTimerDelay; // Reset to stored value
-            turnEnlargerLampOff();
-            startExposure = false; // Stop exposure
+/**
+ * @brief Relay time to add to an exposure for the lamp's warm-up and afterglow.
+ *
+ * Interpolated from the LAMP_COMPENSATION curve (src/LampModel.h, generated
+ * by tools/fit_lamp_model.py for the lamp in use).
+ *
+ * @param requestedMicros The requested exposure time.
+ * @return Microseconds to add (negative: to take off).
+ */
+long lampCompensationMicros(unsigned long requestedMicros) {
+    constexpr uint8_t count = sizeof(LAMP_COMPENSATION) / sizeof(LAMP_COMPENSATION[0]);
+    unsigned long requestedMillis = requestedMicros / 1000UL;
+    uint16_t fromMillis = pgm_read_word(&LAMP_COMPENSATION[0].requestedMillis);
+    int16_t from = static_cast<int16_t>(pgm_read_word(&LAMP_COMPENSATION[0].correction));
+    long correction = from;
+    for (uint8_t i = 1; i < count; ++i) {
+        uint16_t toMillis = pgm_read_word(&LAMP_COMPENSATION[i].requestedMillis);
+        int16_t to = static_cast<int16_t>(pgm_read_word(&LAMP_COMPENSATION[i].correction));
+        correction = to;
+        if (requestedMillis < toMillis) {
+            correction = from + static_cast<long>(to - from) * static_cast<long>(requestedMillis - fromMillis)
+                                / static_cast<long>(toMillis - fromMillis);
+            break;
         }
+        fromMillis = toMillis;
+        from = to;
     }
+    return correction * 1000L / LAMP_CORRECTION_SCALE;
 }
 
 /**
- * @brief Turns off the enlarger lamp and resets related states.
- *
- * This function deactivates the enlarger lamp by setting the relay and manual light pins to LOW,
- * and turns on the LCD backlight. It also resets various control flags, including those for
- * starting exposure, turning on the enlarger lamp, manual lamp control, and the timer button state.
+ * @brief Relay time to add when a paused exposure switches the lamp on again:
+ * one more warm-up, less the afterglow the pause got (the last point of the curve).
  */
-void turnEnlargerLampOff() {
-    DEBUG_PRINT("Turning enlarger lamp OFF");
-    startExposure = false;
-    turnOnEnlargerLamp = false;
-    turnManuallyOnEnlargerLamp = false;
-    digitalWrite(RELAY_PIN, LOW);
-    digitalWrite(MANUAL_LIGHT_PIN, LOW);
-    lcd.backlight();
+long lampRestartMicros() {
+    constexpr uint8_t last = sizeof(LAMP_COMPENSATION) / sizeof(LAMP_COMPENSATION[0]) - 1;
+    return static_cast<int16_t>(pgm_read_word(&LAMP_COMPENSATION[last].correction)) * 1000L / LAMP_CORRECTION_SCALE;
 }
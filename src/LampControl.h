@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Tuesday, 18th February 2025 12:27:30 am
+ * Last Modified: Sunday, 18th October 2026 9:19:27 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -26,6 +26,8 @@
 #ifndef LAMP_CONTROL_H
 #define LAMP_CONTROL_H
 
+#include "FastPin.h"
+
 /**
  * Relay Configuration
  *
@@ -35,10 +37,18 @@
  */
  constexpr uint8_t RELAY_PIN = 7;                   // Relay pin to control the enlarger lamp
  constexpr uint8_t MANUAL_LIGHT_PIN = 8;            // Indicator pin for manual light mode
+ constexpr uint8_t SAFELIGHT_PIN = 5;               // Safelight relay (on while HIGH)
+ constexpr uint8_t BUZZER_PIN = 9;                  // Active buzzer (sounds while HIGH)
+
+// Direct port access (see FastPin.h) for reads and the interrupt-context relay stop;
+// everything else switches the pins through the output scheduler (OutputScheduler.h).
+typedef FastPin<RELAY_PIN> RelayPin;
+typedef FastPin<MANUAL_LIGHT_PIN> ManualLightPin;
 
 void testEnlargerLamp();
 void turnEnlargerLampOn();
-void handleEnlargerLamp();
 void turnEnlargerLampOff();
+long lampCompensationMicros(unsigned long requestedMicros);
+long lampRestartMicros();
 
 #endif // LAMP_CONTROL_H
@@ -0,0 +1,70 @@
+/*
+ * File: LampModel.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 9:08:25 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:33:52 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+// Generated by tools/fit_lamp_model.py from --tau-on 90 --tau-off 25. Do not edit, run the tool again.
+
+#ifndef LAMP_MODEL_H
+#define LAMP_MODEL_H
+
+#include <Arduino.h>
+
+/**
+ * @brief One point of the lamp compensation curve.
+ *
+ * @var requestedMillis Requested exposure time.
+ * @var correction Relay time to add for the lamp's warm-up and afterglow,
+ *      in 1/LAMP_CORRECTION_SCALE ms (negative: to take off).
+ */
+struct LampCompensationPoint {
+    uint16_t requestedMillis;
+    int16_t correction;
+};
+
+constexpr int16_t LAMP_CORRECTION_SCALE = 16;
+
+// Lamp model: warm-up time constant 90.0 ms, afterglow time constant 25.0 ms.
+
+/**
+ * @brief Compensation by requested time, sorted. Between points it is
+ * interpolated; past the last one it stays at the last value, which is also
+ * what every further switch-on (after a pause) costs.
+ */
+constexpr LampCompensationPoint LAMP_COMPENSATION[] PROGMEM = {
+    {0, 0},
+    {20, 416},
+    {50, 664},
+    {100, 850},
+    {150, 938},
+    {200, 983},
+    {300, 1022},
+    {500, 1038},
+    {750, 1040},
+    {1000, 1040},
+    {2000, 1040},
+};
+
+static_assert(sizeof(LAMP_COMPENSATION) / sizeof(LAMP_COMPENSATION[0]) >= 2, "The compensation curve needs two points");
+
+#endif // LAMP_MODEL_H
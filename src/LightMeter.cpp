@@ -0,0 +1,341 @@
+/*
+ * File: LightMeter.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:55:26 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:49:38 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+
+#include "LightMeter.h"
+#include "constants.h"
+#include "LampControl.h"
+#include "LCDHandler.h"
+#include "MemoryUtils.h"
+#include "SharedValue.h"
+
+namespace {
+    // Written by the conversion interrupt only
+    uint32_t sampleSum = 0;
+    uint16_t sampleCount = 0;
+    SharedValue<uint16_t> reading(0);   // Last decimated reading
+    volatile bool meterRunning = false;
+
+#if !defined(__AVR__)
+    unsigned long nextSampleTime = 0;   // Host: conversions are caught up in tickLightMeter()
+#endif
+
+    // Light integration, in dose units (DOSE_UNIT_BITS). The loop owns the
+    // target and the interrupt owns the count, so each value has one writer;
+    // the loop only resets the count while the interrupt ignores it.
+    SharedValue<uint32_t> doseTarget(0);    // Dose of the whole exposure (written by the loop)
+    SharedValue<uint32_t> doseCounted(0);   // Dose received so far (written by the interrupt)
+    uint16_t doseFraction = 0;          // Samples not yet making up a whole unit (interrupt only)
+    volatile bool doseIntegrating = false; // Relay on: samples count towards the dose
+    volatile bool doseDone = false;     // Reached; the interrupt switched the relay off
+    SharedValue<unsigned long> doseStoppedAt(0); // micros() of that relay edge, written before doseDone
+    bool doseMode = false;
+    uint16_t doseReference = DOSE_DEFAULT_REFERENCE;
+    uint16_t armedReference = DOSE_DEFAULT_REFERENCE; // The reference of the running exposure
+
+    uint16_t highlight = 0;             // 0 until taken
+    uint16_t shadow = 0;
+    uint16_t shownReading = 0xFFFF;
+    unsigned long shownAt = 0;
+
+    /** @brief Adds one conversion; publishes a reading every METER_SAMPLES. Interrupt context. */
+    void addSample(uint16_t sample) {
+        if (doseIntegrating && !doseDone) {
+            doseFraction += sample;
+            uint32_t counted = doseCounted.read() + (doseFraction >> DOSE_UNIT_BITS);
+            doseFraction &= (1U << DOSE_UNIT_BITS) - 1;
+            doseCounted.writeFromISR(counted);
+            if (counted >= doseTarget.read()) {
+                RelayPin::low();    // first: this edge is the end of the exposure (one cbi, not the scheduler)
+                doseStoppedAt.writeFromISR(micros());
+                doseIntegrating = false;
+                doseDone = true;
+            }
+        }
+        sampleSum += sample;
+        if (++sampleCount == METER_SAMPLES) {
+            reading.writeFromISR(static_cast<uint16_t>(sampleSum >> METER_EXTRA_BITS));
+            sampleSum = 0;
+            sampleCount = 0;
+        }
+    }
+
+    // Micros() per dose unit at a reading of 1: a reading is 2^METER_EXTRA_BITS
+    // times the mean sample, and one sample comes every METER_SAMPLE_US.
+    constexpr unsigned long DOSE_UNIT_US = METER_SAMPLE_US << (METER_EXTRA_BITS + DOSE_UNIT_BITS);
+    static_assert(DOSE_UNIT_US * METER_FULL_SCALE <= 0xFFFFFFFFUL, "Dose conversions overflow 32 bits");
+
+    /** @brief Dose of clockMicros at the reference intensity, in dose units (32-bit arithmetic only). */
+    uint32_t doseFor(unsigned long clockMicros, uint16_t reference) {
+        return (clockMicros / DOSE_UNIT_US) * reference + (clockMicros % DOSE_UNIT_US) * reference / DOSE_UNIT_US;
+    }
+
+    /** @brief The contrast grade for a shadow / highlight ratio. */
+    uint8_t gradeFor(uint16_t shadowReading, uint16_t highlightReading) {
+        uint32_t contrast = (static_cast<uint32_t>(shadowReading) << 4) / highlightReading;
+        for (uint8_t i = 0; i < sizeof(METER_GRADES) / sizeof(METER_GRADES[0]); ++i) {
+            if (contrast <= pgm_read_word(&METER_GRADES[i].maxContrast)) {
+                return pgm_read_byte(&METER_GRADES[i].grade);
+            }
+        }
+        return METER_SOFTEST_GRADE;
+    }
+}
+
+#if defined(__AVR__)
+ISR(ADC_vect) {
+    addSample(ADC);
+}
+#endif
+
+/**
+ * @brief Starts the free-running conversions on METER_ADC_CHANNEL.
+ */
+void startLightMeter() {
+    if (meterRunning) {
+        return;
+    }
+    sampleSum = 0;
+    sampleCount = 0;
+    meterRunning = true;
+#if defined(__AVR__)
+    DIDR0 |= _BV(METER_ADC_CHANNEL);                      // no digital input buffer on the sensor pin
+    ADMUX = _BV(REFS0) | METER_ADC_CHANNEL;               // AVcc reference
+    ADCSRB = 0;                                           // free running
+    ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADSC) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+#else
+    nextSampleTime = micros();
+#endif
+}
+
+/**
+ * @brief Stops the conversions, so the interrupt costs nothing outside the meter.
+ */
+void stopLightMeter() {
+#if defined(__AVR__)
+    ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);   // as analogRead() leaves it
+#endif
+    meterRunning = false;
+}
+
+/**
+ * @brief Call once per loop() pass. On the board the interrupt does all the
+ * work; host builds catch up on the conversions due since the last call.
+ */
+void tickLightMeter() {
+#if !defined(__AVR__)
+    while (meterRunning && static_cast<long>(micros() - nextSampleTime) >= 0) {
+        addSample(analogRead(METER_ADC_CHANNEL));
+        nextSampleTime += METER_SAMPLE_US;
+    }
+#endif
+}
+
+/**
+ * @brief The last reading, 0 .. METER_FULL_SCALE (0 before the first one).
+ */
+uint16_t lightReading() {
+    return reading.read();
+}
+
+/**
+ * @brief Shows the meter screen with no readings taken (entry action of the METER state).
+ */
+void openMeterView() {
+    clearMeterReadings();
+}
+
+/**
+ * @brief Stores the live reading: the highlight first, then the shadow.
+ *
+ * A further press starts over with a new highlight reading.
+ */
+void takeMeterReading() {
+    uint16_t live = max(lightReading(), static_cast<uint16_t>(1));
+    if (highlight == 0 || shadow != 0) {
+        highlight = live;
+        shadow = 0;
+    } else {
+        shadow = live;
+    }
+    DEBUG_PRINTF("Meter: highlight %u, shadow %u", highlight, shadow);
+    shownReading = 0xFFFF;   // redraw now
+    refreshMeterView();
+}
+
+/**
+ * @brief Forgets both readings.
+ */
+void clearMeterReadings() {
+    highlight = 0;
+    shadow = 0;
+    shownReading = 0xFFFF;
+    refreshMeterView();
+}
+
+/**
+ * @brief Redraws the meter screen when the live reading changed, at most every METER_VIEW_REFRESH_MS.
+ */
+void refreshMeterView() {
+    uint16_t live = lightReading();
+    bool forced = (shownReading == 0xFFFF);
+    if (!forced && (live == shownReading || millis() - shownAt < METER_VIEW_REFRESH_MS)) {
+        return;
+    }
+    shownReading = live;
+    shownAt = millis();
+    long delayMillis = 0;
+    uint8_t grade = 0;
+    bool suggested = meterSuggestion(delayMillis, grade);
+    displayMeter(live, highlight, shadow, suggested ? delayMillis : -1, grade);
+}
+
+/**
+ * @brief Exposure and contrast grade suggested by the readings taken.
+ *
+ * @param delayMillis Receives the exposure, within TimerConfig::MAX_DELAY, in TimerConfig::INCREMENT steps.
+ * @param grade Receives the paper grade, or 0xFF until the shadow reading is taken too.
+ * @return False until a highlight reading was taken.
+ */
+bool meterSuggestion(long& delayMillis, uint8_t& grade) {
+    if (highlight == 0) {
+        return false;
+    }
+    uint32_t exposure = METER_EXPOSURE_CONSTANT / highlight;
+    exposure = (exposure + TimerConfig::INCREMENT / 2) / TimerConfig::INCREMENT * TimerConfig::INCREMENT;
+    delayMillis = min(static_cast<long>(exposure), TimerConfig::MAX_DELAY);
+    grade = (shadow != 0) ? gradeFor(shadow, highlight) : 0xFF;
+    return true;
+}
+
+/**
+ * @brief Turns dose mode on or off for the exposures started from now on.
+ */
+void setDoseMode(bool on) {
+    doseMode = on;
+}
+
+/**
+ * @brief True if exposures integrate the light (see setDoseMode()).
+ */
+bool isDoseMode() {
+    return doseMode;
+}
+
+/**
+ * @brief Sets the reference intensity, as a meter reading (1 .. METER_FULL_SCALE).
+ *
+ * Not stored: it is DOSE_DEFAULT_REFERENCE again after a reset.
+ */
+void setDoseReference(uint16_t reference) {
+    doseReference = constrain(reference, static_cast<uint16_t>(1), METER_FULL_SCALE);
+}
+
+/**
+ * @brief The reference intensity exposures are integrated against.
+ */
+uint16_t getDoseReference() {
+    return doseReference;
+}
+
+/**
+ * @brief Prepares a light-integrating exposure and starts the conversions.
+ *
+ * Integration starts with integrateDose(true), right after the relay edge.
+ *
+ * @param clockMicros Exposure time at the reference intensity, in micros() counts of this board.
+ */
+void armDose(unsigned long clockMicros) {
+    armedReference = doseReference;
+    doseIntegrating = false;    // first: the interrupt leaves the count alone from here on
+    doseDone = false;
+    doseCounted.write(0);
+    doseFraction = 0;
+    doseTarget.write(max(doseFor(clockMicros, armedReference), static_cast<uint32_t>(1)));
+    startLightMeter();
+}
+
+/**
+ * @brief Counts the samples towards the dose while on (relay on), ignores them while off (paused).
+ */
+void integrateDose(bool on) {
+    doseIntegrating = on;   // the interrupt ignores it once the dose is reached
+}
+
+/**
+ * @brief True once the dose was reached and the relay switched off.
+ *
+ * @param stoppedAt Receives micros() at the relay edge.
+ */
+bool doseReached(unsigned long& stoppedAt) {
+    if (!doseDone) {
+        return false;
+    }
+    stoppedAt = doseStoppedAt.read();
+    return true;
+}
+
+/**
+ * @brief The dose left, as time at the reference intensity (micros() counts of this board).
+ */
+unsigned long remainingDoseMicros() {
+    uint32_t target = doseTarget.read();
+    uint32_t counted = doseCounted.read();
+    if (counted >= target) {
+        return 0;
+    }
+    uint32_t left = target - counted;
+    return (left / armedReference) * DOSE_UNIT_US + (left % armedReference) * DOSE_UNIT_US / armedReference;
+}
+
+/**
+ * @brief Adds dose to the running exposure, or takes some off (burn-in), never below zero.
+ *
+ * @param clockMicros Time at the reference intensity to add (negative to take off).
+ */
+void adjustDose(long clockMicros) {
+    uint32_t delta = doseFor(static_cast<unsigned long>(clockMicros < 0 ? -clockMicros : clockMicros), armedReference);
+    if (doseDone) {
+        return;
+    }
+    uint32_t target = doseTarget.read();
+    if (clockMicros >= 0) {
+        doseTarget.write(target + delta);
+    } else {
+        // Never below what was already received: then it ends at the next conversion
+        uint32_t floor = doseCounted.read() + 1;
+        doseTarget.write((target > floor + delta) ? target - delta : floor);
+    }
+}
+
+/**
+ * @brief Ends light integration (the exposure is over) and stops the conversions.
+ */
+void disarmDose() {
+    doseIntegrating = false;
+    doseTarget.write(0);
+    stopLightMeter();
+}
@@ -0,0 +1,132 @@
+/*
+ * File: LightMeter.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:55:02 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:49:38 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+
+#ifndef LIGHT_METER_H
+#define LIGHT_METER_H
+
+#include <Arduino.h>
+
+/*
+ * Easel light meter.
+ *
+ * A photodiode amplifier on ADC channel METER_ADC_CHANNEL (A0) measures the
+ * projected image. The ADC runs free, and its conversion-complete interrupt
+ * adds up 4^METER_EXTRA_BITS samples, then decimates the sum to a reading
+ * with METER_EXTRA_BITS more bits than the 10-bit converter (oversampling
+ * only gains resolution when the signal carries at least 1 LSB of noise,
+ * which a photodiode on a mains-powered lamp always does). The loop only ever
+ * reads the last published reading, so metering never blocks it with
+ * analogRead().
+ *
+ * In the METER state (see TimerStateMachine.h) the user takes a highlight
+ * reading (densest area of the negative, the least light on the easel) and a
+ * shadow reading (the most light). The suggested exposure is
+ * METER_EXPOSURE_CONSTANT / highlight, and the contrast grade comes from the
+ * shadow / highlight ratio through METER_GRADES.
+ */
+
+constexpr uint8_t METER_ADC_CHANNEL = 0;        // A0
+constexpr uint8_t METER_EXTRA_BITS = 4;         // 14-bit readings
+constexpr uint16_t METER_SAMPLES = 1U << (2 * METER_EXTRA_BITS); // Conversions per reading
+constexpr unsigned long METER_SAMPLE_US = 104;  // One conversion: 13 ADC clocks at 16 MHz / 128
+constexpr uint16_t METER_FULL_SCALE = 1023U << METER_EXTRA_BITS;
+constexpr uint16_t METER_VIEW_REFRESH_MS = 250; // LCD update rate of the live reading
+
+/**
+ * @brief Paper calibration: highlight reading x exposure (ms) that prints a
+ * highlight with its first visible tone. Make a correct test print, then take
+ * this from a highlight reading of the same negative: constant = reading x time.
+ */
+constexpr uint32_t METER_EXPOSURE_CONSTANT = 10000000UL;
+
+/**
+ * @brief One row of the contrast grade table.
+ *
+ * @var maxContrast Highest shadow / highlight ratio for this grade, in 1/16.
+ * @var grade Paper grade to use.
+ */
+struct MeterGrade {
+    uint16_t maxContrast;
+    uint8_t grade;
+};
+
+/**
+ * @brief Contrast grades by negative density range (ISO paper ranges), soft
+ * paper for contrasty negatives. Ratios above the last row give grade 0.
+ */
+constexpr MeterGrade METER_GRADES[] PROGMEM = {
+    {72, 5},    // density range below 0.65 (ratio 4.5)
+    {101, 4},   // 0.65 .. 0.80 (6.3)
+    {143, 3},   // 0.80 .. 0.95 (8.9)
+    {226, 2},   // 0.95 .. 1.15 (14.1)
+    {402, 1},   // 1.15 .. 1.40 (25.1)
+};
+constexpr uint8_t METER_SOFTEST_GRADE = 0;
+
+/*
+ * Light-integrating exposures.
+ *
+ * With dose mode on, an exposure of T seconds gives the paper the light of T
+ * seconds at the reference reading rather than T seconds of lamp time. The
+ * same conversion interrupt adds every sample to the dose received while
+ * the relay is on, and switches the relay off itself the moment the dose is
+ * reached, so the stop is at most one conversion (104 us) late whatever the
+ * loop is doing. A lamp running 10 % dim is then simply left on 10 % longer.
+ */
+
+/**
+ * @brief The dose is counted in units of 2^DOSE_UNIT_BITS ADC counts, so the
+ * longest exposure at full scale fits 32 bits.
+ */
+constexpr uint8_t DOSE_UNIT_BITS = 4;
+/** @brief Reference intensity until one is set (DOSE REF), as a meter reading. */
+constexpr uint16_t DOSE_DEFAULT_REFERENCE = 4096;
+/** @brief The lamp is switched off at this many times the set time even if the dose is not reached (dead sensor). */
+constexpr uint8_t DOSE_TIME_LIMIT = 4;
+
+void startLightMeter();
+void stopLightMeter();
+void tickLightMeter();
+uint16_t lightReading();
+void openMeterView();
+void takeMeterReading();
+void clearMeterReadings();
+void refreshMeterView();
+bool meterSuggestion(long& delayMillis, uint8_t& grade);
+
+void setDoseMode(bool on);
+bool isDoseMode();
+void setDoseReference(uint16_t reference);
+uint16_t getDoseReference();
+void armDose(unsigned long clockMicros);
+void integrateDose(bool on);
+bool doseReached(unsigned long& stoppedAt);
+unsigned long remainingDoseMicros();
+void adjustDose(long clockMicros);
+void disarmDose();
+
+#endif // LIGHT_METER_H
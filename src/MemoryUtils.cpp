@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 9:22:34 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Wednesday, 26th February 2025 8:54:47 pm
+ * Last Modified: Sunday, 18th October 2026 10:01:45 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -26,12 +26,20 @@
  #include "MemoryUtils.h"
  #include "constants.h"
  #include "LCDHandler.h"
+ #if defined(__AVR__)
+ #include <avr/eeprom.h>
+ #endif
  
  // Constants (moved from constants.h for better encapsulation)
  constexpr int MAX_RETRIES = 3;
+ constexpr uint8_t SHADOW_SEQUENCE_INVALID = 0xFF; // Sequence byte of a slot that is not committed (also the erased value)
+ static_assert(TimerConfig::MAX_DELAY <= RING_VALUE_MASK, "The delay must fit below the ring sequence byte");
+ static_assert(EEPROM_SLOT_COUNT < 256, "The ring sequence must not come round within one lap");
  
  // Global Variables (Internal to MemoryUtils.cpp - NOT in header file)
  static int currentEEPROMAddress = EEPROM_START_ADDRESS; // Track current write address
+ static uint8_t ringSequence = 0; // Sequence number of the newest ring slot
+ static uint8_t badBlockMap[BAD_BLOCK_MAP_SIZE]; // RAM copy of the bad-block bitmap (1 = usable, 0 = retired)
  
  /**
   * @brief Returns the number of bytes currently free in RAM.
@@ -83,6 +91,60 @@
  #endif
  }
  
+ #if defined(__AVR__)
+ constexpr uint8_t STACK_CANARY = 0xC5; // Fill pattern of RAM the stack has never reached
+
+ /**
+  * @brief Paints all RAM above .bss with STACK_CANARY before the C runtime starts.
+  *
+  * Runs from .init1, before the stack pointer is set up and before .data and
+  * .bss are initialized, so it must not use the stack or rely on r1 being zero.
+  * The stack itself has not been used yet, so painting up to RAMEND is safe.
+  */
+ extern "C" void paintStack() __attribute__((naked, used, section(".init1")));
+ extern "C" void paintStack() {
+     __asm__ __volatile__(
+         "    ldi r30, lo8(_end)     \n"
+         "    ldi r31, hi8(_end)     \n"
+         "    ldi r24, %0            \n"
+         "    ldi r25, hi8(%1)       \n"
+         "1:  st Z+, r24             \n"
+         "    cpi r30, lo8(%1)       \n"
+         "    cpc r31, r25           \n"
+         "    brlo 1b                \n"
+         "    breq 1b                \n"
+         :
+         : "i"(STACK_CANARY), "i"(RAMEND));
+ }
+ #endif
+
+ /**
+  * @brief Returns the smallest amount of free stack seen since boot.
+  *
+  * paintStack() fills the free RAM with a canary at boot. The bytes between the
+  * end of static data (or of the heap) and the deepest point the stack ever
+  * reached still hold it, so counting them gives the high-water mark of the
+  * stack. Unlike freeRam() it catches peaks that are gone by the time anyone
+  * asks, such as a deep call chain inside a display update.
+  *
+  * @return Bytes never touched by the stack, or -1 where the stack is not painted.
+  */
+ int minFreeStack() {
+ #if defined(__AVR__)
+     extern uint8_t _end;
+     extern char* __brkval;
+     const uint8_t* p = (__brkval != 0) ? reinterpret_cast<const uint8_t*>(__brkval) : &_end;
+     int untouched = 0;
+     while (p <= reinterpret_cast<const uint8_t*>(RAMEND) && *p == STACK_CANARY) {
+         ++p;
+         ++untouched;
+     }
+     return untouched;
+ #else
+     return -1;
+ #endif
+ }
+
  #if defined(ARDUINO_ARCH_SAM) || defined(ARDUINO_ARCH_SAMD)
  /**
   * Helper function for ARM-based Arduino boards
@@ -93,55 +155,149 @@
  }
  #endif
  
+ /**
+  * @brief Checks whether a wear leveling slot has been retired.
+  *
+  * A single bit test against the RAM copy of the bad-block bitmap, so the
+  * allocator can skip known-bad slots without touching the EEPROM.
+  *
+  * @param slot The wear leveling slot index (0 .. EEPROM_SLOT_COUNT - 1).
+  * @return True if the slot is retired (or out of range), false otherwise.
+  */
+ bool isEEPROMSlotRetired(int slot) {
+     if (slot < 0 || slot >= EEPROM_SLOT_COUNT) {
+         return true;
+     }
+     return !(badBlockMap[slot >> 3] & (1 << (slot & 7)));
+ }
+
+ /**
+  * @brief True if the EEPROM can take a write without waiting for the previous one.
+  */
+ bool isEEPROMReady() {
+ #if defined(__AVR__)
+     return eeprom_is_ready();
+ #else
+     return true;
+ #endif
+ }
+ 
+ /**
+  * @brief Raises the EEPROM failure flag once too much of the ring has been retired.
+  *
+  * The threshold is the fraction of the wear leveling capacity that has been lost
+  * (MAX_BAD_BLOCK_PERCENT), not a raw count of bad blocks.
+  */
+ static void updateEEPROMHealth() {
+     if (static_cast<long>(badBlocksCount) * 100 >= static_cast<long>(EEPROM_SLOT_COUNT) * MAX_BAD_BLOCK_PERCENT) {
+         EEPROM_FAILED = true; //set the flag to display user a message
+     }
+ }
+ 
+ /**
+  * @brief Marks the slot containing the given address as retired.
+  *
+  * Clears the slot's bit in the RAM bitmap and persists the affected bitmap byte,
+  * so the slot stays retired across reboots. Addresses outside the wear leveling
+  * area are ignored.
+  *
+  * @param address The EEPROM address that failed verification.
+  */
+ static void retireEEPROMSlot(int address) {
+     if (address < EEPROM_START_ADDRESS || address > EEPROM_END_ADDRESS - EEPROM_SLOT_SIZE) {
+         return;
+     }
+     int slot = (address - EEPROM_START_ADDRESS) / EEPROM_SLOT_SIZE;
+     if (isEEPROMSlotRetired(slot)) {
+         return; // already retired
+     }
+     badBlockMap[slot >> 3] &= ~(1 << (slot & 7));
+     EEPROM.update(BAD_BLOCK_MAP_ADDRESS + (slot >> 3), badBlockMap[slot >> 3]);
+     badBlocksCount++;
+     DEBUG_PRINTF("EEPROM slot %d retired, %d of %d slots lost", slot, badBlocksCount, EEPROM_SLOT_COUNT);
+     updateEEPROMHealth();
+ }
+ 
+ /**
+  * @brief Loads the bad-block bitmap from EEPROM and counts the retired slots.
+  *
+  * Without BAD_BLOCK_MAP_MARKER the bytes are not a bitmap (a fresh chip, or
+  * the old wear leveling ring of a board upgraded from older firmware): every
+  * slot is marked usable, then the marker is written.
+  */
+ static void loadBadBlockMap() {
+     badBlocksCount = 0;
+     if (EEPROM.read(BAD_BLOCK_MAP_MARKER_ADDRESS) != BAD_BLOCK_MAP_MARKER) {
+         DEBUG_PRINT("No bad-block bitmap, every slot usable");
+         for (int i = 0; i < BAD_BLOCK_MAP_SIZE; ++i) {
+             EEPROM.update(BAD_BLOCK_MAP_ADDRESS + i, 0xFF);
+         }
+         EEPROM.update(BAD_BLOCK_MAP_MARKER_ADDRESS, BAD_BLOCK_MAP_MARKER); // last: the map is complete
+     }
+     for (int i = 0; i < BAD_BLOCK_MAP_SIZE; ++i) {
+         badBlockMap[i] = EEPROM.read(BAD_BLOCK_MAP_ADDRESS + i);
+     }
+     for (int slot = 0; slot < EEPROM_SLOT_COUNT; ++slot) {
+         if (isEEPROMSlotRetired(slot)) {
+             badBlocksCount++;
+         }
+     }
+     DEBUG_PRINTF("Bad-block bitmap loaded: %d of %d slots retired", badBlocksCount, EEPROM_SLOT_COUNT);
+     updateEEPROMHealth();
+ }
+ 
  /**
   * @brief Gets the next EEPROM address for wear leveling.
   *
   * This function increments the current EEPROM address index and wraps around
-  * to the start address when the end of the address range is reached.
+  * to the start address when the end of the address range is reached. Slots
+  * retired in the bad-block bitmap are skipped.
   *
   * @return The next EEPROM address to use.
   */
  int getNextEEPROMAddress() {
-     int addressToUse = currentEEPROMAddress;
-     currentEEPROMAddress += sizeof(long); // Move to next address after the long value
-     if (currentEEPROMAddress > EEPROM_END_ADDRESS - sizeof(long)) { // important fix: subtract sizeof(long)
-         currentEEPROMAddress = EEPROM_START_ADDRESS; // Wrap around
+     for (int attempt = 0; attempt < EEPROM_SLOT_COUNT; ++attempt) {
+         int addressToUse = currentEEPROMAddress;
+         currentEEPROMAddress += EEPROM_SLOT_SIZE; // Move to next slot
+         if (currentEEPROMAddress > EEPROM_END_ADDRESS - EEPROM_SLOT_SIZE) {
+             currentEEPROMAddress = EEPROM_START_ADDRESS; // Wrap around
+         }
+         if (!isEEPROMSlotRetired((addressToUse - EEPROM_START_ADDRESS) / EEPROM_SLOT_SIZE)) {
+             return addressToUse;
+         }
      }
-     return addressToUse;
+     // Every slot is retired; keep handing out the current one, EEPROM_FAILED is already set.
+     return currentEEPROMAddress;
  }
  
  /**
  * @brief Writes a value to EEPROM with retry logic to handle bad blocks.
  *
  * This function attempts to write a value to the specified EEPROM address.
- * If the write fails (value read back is incorrect), it increments the bad
- * blocks count and returns false. The function also handles skipping bad
- * blocks and displaying a warning message on the LCD if too many bad blocks
- * are encountered.
+ * If the write fails (value read back is incorrect), the slot is retired in
+ * the bad-block bitmap and the function returns false. The EEPROM failure
+ * flag is raised once too large a fraction of the slots has been retired.
  *
  * @param address The EEPROM address to write to.
  * @param value The value to write.
  * @return True if the write was successful, false otherwise.
  */
  bool writeEEPROMWithRetry(int address, long value) {
+     const int32_t storedValue = value;
      for (int retry = 0; retry < MAX_RETRIES; ++retry) {
-         EEPROM.put(address, value);
-         long readValue;
+         EEPROM.put(address, storedValue);
+         int32_t readValue;
          EEPROM.get(address, readValue);
  
-         if (readValue == value) {
+         if (readValue == storedValue) {
              return true; // Write successful
          }
          delay(10); // Small delay before retry
      }
  
      // Write failed after multiple retries
-     badBlocksCount++;
      DEBUG_PRINTF("EEPROM write failed at address: %d", address);
- 
-     if (badBlocksCount > MAX_BAD_BLOCKS) {
-         EEPROM_FAILED = true; //set the flag to display user a message
-     }
+     retireEEPROMSlot(address);
      return false;
  }
  
@@ -149,18 +305,18 @@
  * @brief Reads a value to EEPROM with retry logic to handle bad blocks.
  *
  * This function attempts to read a value to the specified EEPROM address.
- * If the read fails (value read back is incorrect), it increments the bad
- * blocks count and returns false. The function also handles skipping bad
- * blocks and sets a flag to display a warning message on the LCD
- * if too many bad blocks are encountered.
+ * If the read fails (value read back is out of range), it returns -1.
  *
  * @param address The EEPROM address to read from.
  * @return timer delay stored in EEPROM, otherwise -1
  */
  long readEEPROMWithRetry(int address) {
   for (int retry = 0; retry < MAX_RETRIES; ++retry) {
-      long readValue;
+      int32_t readValue;
       EEPROM.get(address, readValue);
+      if (address >= EEPROM_START_ADDRESS && address < EEPROM_END_ADDRESS) {
+          readValue &= RING_VALUE_MASK; // drop the ring sequence number (erased slots stay out of range)
+      }
 
       // First check that the data is in a valid timer range and also is not an uninitialized value.
       if ((readValue >= 0 && readValue <= TimerConfig::MAX_DELAY) && (readValue != EEPROM_INIT_VALUE)) {
@@ -171,28 +327,321 @@
       delay(10); // Small delay before retry
   }
 
-  // Write failed after multiple retries
-  badBlocksCount++;
+  // Read failed after multiple retries. A blank or out-of-range value does not
+  // prove the cells are worn, so only failed writes retire a slot.
   DEBUG_PRINTF("EEPROM read failed at address: %d", address);
-
-  if (badBlocksCount > MAX_BAD_BLOCKS) {
-      EEPROM_FAILED = true; //set the flag to display user a message
-  }
   return -1;
 } 
  
  /**
-  * @brief Retrieves the last used EEPROM address from EEPROM.
+  * @brief Reads the sequence number of a ring slot.
+  *
+  * @return False if the slot holds no delay (erased, or out of range).
+  */
+ static bool readRingSequence(int slot, uint8_t& sequence) {
+     int32_t value;
+     EEPROM.get(EEPROM_START_ADDRESS + slot * EEPROM_SLOT_SIZE, value);
+     sequence = static_cast<uint32_t>(value) >> RING_SEQUENCE_SHIFT;
+     return (value & RING_VALUE_MASK) <= TimerConfig::MAX_DELAY;
+ }
+
+ /**
+  * @brief Finds the newest slot of the wear leveling ring.
+  *
+  * Every store numbers its slot one past the previous one, so walking the
+  * usable slots in ring order the newest is the last one its successor does
+  * not continue (erased, or not the next number).
+  *
+  * @return The slot, or -1 if the ring holds no delay.
+  */
+ static int findNewestRingSlot() {
+     int first = -1;
+     int previous = -1;
+     bool previousValid = false;
+     uint8_t previousSequence = 0;
+     for (int slot = 0; slot < EEPROM_SLOT_COUNT; ++slot) {
+         if (isEEPROMSlotRetired(slot)) {
+             continue;
+         }
+         uint8_t sequence;
+         bool valid = readRingSequence(slot, sequence);
+         if (previousValid && !(valid && sequence == static_cast<uint8_t>(previousSequence + 1))) {
+             return previous;
+         }
+         if (first < 0) {
+             first = slot;
+         }
+         previous = slot;
+         previousValid = valid;
+         previousSequence = sequence;
+     }
+     return previousValid ? previous : -1; // the newest is the last slot, the first one starts the next lap
+ }
+
+ /**
+  * @brief Restores the wear leveling ring and the stored timer delay at startup.
   *
-  * If EEPROM is not initialized, it initializes it.
-  * If EEPROM is already initialized it retrieves last used address.
-  * It must be called at startup time from `setup()` function.
+  * The bad-block bitmap is loaded first, so retired slots are skipped from the
+  * first write on. The ring goes on after its newest slot, whose delay becomes
+  * the timer delay; no address pointer is kept, so no single cell is written
+  * on every store. It must be called at startup time from `setup()` function.
   */
  void restoreEEPROMAddress() {
-     EEPROM.get(ADDRESS_TRACKER_ADDRESS, currentEEPROMAddress);
-     if (currentEEPROMAddress < EEPROM_START_ADDRESS || currentEEPROMAddress > EEPROM_END_ADDRESS - sizeof(long)) {
-         DEBUG_PRINT("Invalid EEPROM address. Resetting");
+     loadBadBlockMap();
+     int newest = findNewestRingSlot();
+     if (newest < 0) {
+         DEBUG_PRINT("No delay in the EEPROM ring");
          currentEEPROMAddress = EEPROM_START_ADDRESS;
+         ringSequence = 0;
+         eeAddress = EEPROM_START_ADDRESS;
+     } else {
+         readRingSequence(newest, ringSequence);
+         eeAddress = EEPROM_START_ADDRESS + newest * EEPROM_SLOT_SIZE;
+         currentEEPROMAddress = eeAddress + EEPROM_SLOT_SIZE;
+         if (currentEEPROMAddress > EEPROM_END_ADDRESS - EEPROM_SLOT_SIZE) {
+             currentEEPROMAddress = EEPROM_START_ADDRESS; // Wrap around
+         }
      }
-     DEBUG_PRINTF("Restored last used address %d from EEPROM", currentEEPROMAddress);
- }
\ No newline at end of file
+     DEBUG_PRINTF("Restored last used address %d from EEPROM", eeAddress);
+     storedTimerDelay = readEEPROMWithRetry(eeAddress);
+     timerDelay = storedTimerDelay;
+ }
+
+ /**
+  * @brief Saves the timer delay an exposure is started with (throttled EEPROM write).
+  *
+  * The delay goes to the next slot of the wear leveling ring, numbered one
+  * past the newest, so restoreEEPROMAddress() finds it after a reboot.
+  *
+  * @param currentMillis millis() now.
+  */
+ void storeTimerDelay(unsigned long currentMillis) {
+     // Check if enough time has passed since the last EEPROM write
+     if (currentMillis - lastEEPROMWrite >= TimerConfig::EEPROM_WRITE_DELAY) {
+         // Check if the timerDelay has changed since the last EEPROM write
+         if (timerDelay != storedTimerDelay) {
+             int nextAddress = getNextEEPROMAddress();
+             uint8_t sequence = ringSequence + 1;
+             if (writeEEPROMWithRetry(nextAddress, ringSlotValue(timerDelay, sequence))) {
+                 DEBUG_PRINTF("EEPROM updated at %d address. Stored delay is %d ms.", nextAddress, timerDelay);
+                 ringSequence = sequence;
+                 eeAddress = nextAddress; // Update current EEPROM address
+                 storedTimerDelay = timerDelay; // Update stored delay
+                 lastEEPROMWrite = currentMillis; // Update last write time
+             } else {
+                 DEBUG_PRINT("EEPROM write failed, skipping address.");
+             }
+         } else {
+             DEBUG_PRINT("EEPROM not updated: value unchanged");
+         }
+     } else {
+         DEBUG_PRINT("EEPROM not updated: too soon");
+     }
+     storedTimerDelay = timerDelay;
+ }
+ 
+ /**
+  * @brief CRC-8 (polynomial 0x07), continued from a previous value.
+  *
+  * Shared by everything that checks its own bytes: shadow slots, serial
+  * frames and the exposure history log.
+  */
+ uint8_t crc8(const uint8_t* data, uint8_t length, uint8_t crc) {
+     for (uint8_t i = 0; i < length; ++i) {
+         crc ^= data[i];
+         for (uint8_t bit = 0; bit < 8; ++bit) {
+             crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+         }
+     }
+     return crc;
+ }
+
+ /**
+  * @brief CRC-8 over a shadow slot payload and its sequence number.
+  */
+ static uint8_t shadowChecksum(const uint8_t* data, uint8_t length, uint8_t sequence) {
+     return crc8(&sequence, 1, crc8(data, length));
+ }
+ 
+ /**
+  * @brief Returns the EEPROM address of a shadow slot.
+  */
+ static int shadowSlotAddress(const ShadowRecord& record, uint8_t slot) {
+     return record.baseAddress + slot * (record.length + SHADOW_SLOT_OVERHEAD);
+ }
+ 
+ /**
+  * @brief Reads a shadow slot and checks that it holds a committed record.
+  *
+  * @param record The shadow record description.
+  * @param slot The slot to read (0 or 1).
+  * @param data Buffer of record.length bytes receiving the payload.
+  * @param sequence Receives the slot's sequence number.
+  * @return True if the slot is committed and its checksum matches.
+  */
+ static bool readShadowSlot(const ShadowRecord& record, uint8_t slot, uint8_t* data, uint8_t& sequence) {
+     int address = shadowSlotAddress(record, slot);
+     for (uint8_t i = 0; i < record.length; ++i) {
+         data[i] = EEPROM.read(address + i);
+     }
+     uint8_t crc = EEPROM.read(address + record.length);
+     sequence = EEPROM.read(address + record.length + 1);
+     return sequence != SHADOW_SEQUENCE_INVALID && crc == shadowChecksum(data, record.length, sequence);
+ }
+ 
+ /**
+  * @brief Boot-time recovery of a shadow record.
+  *
+  * Picks the newest committed slot (sequence numbers compared with wrap-around).
+  * A slot whose commit was interrupted is never committed, so it is ignored and
+  * simply overwritten by the next commit; no roll-back writes are needed.
+  *
+  * @param record The shadow record description. activeSlot and sequence are set.
+  * @param data Buffer of record.length bytes receiving the committed payload
+  *             (unspecified contents if nothing was committed).
+  * @return True if a committed record was found, false if the caller should use defaults.
+  */
+ bool recoverShadowRecord(ShadowRecord& record, void* data) {
+     uint8_t* payload = static_cast<uint8_t*>(data);
+     record.commitStep = 0;
+     uint8_t sequence[2];
+     bool valid[2];
+     valid[1] = readShadowSlot(record, 1, payload, sequence[1]);
+     valid[0] = readShadowSlot(record, 0, payload, sequence[0]);
+
+     record.activeSlot = SHADOW_SLOT_NONE;
+     record.sequence = SHADOW_SEQUENCE_INVALID;
+     if (valid[0] && valid[1]) {
+         record.activeSlot = (static_cast<int8_t>(sequence[1] - sequence[0]) > 0) ? 1 : 0;
+     } else if (valid[0] || valid[1]) {
+         record.activeSlot = valid[0] ? 0 : 1;
+     } else {
+         DEBUG_PRINTF("No committed record at EEPROM address %d", record.baseAddress);
+         return false;
+     }
+     record.sequence = sequence[record.activeSlot];
+     if (record.activeSlot == 1) {
+         readShadowSlot(record, 1, payload, sequence[1]);
+     }
+     DEBUG_PRINTF("Recovered record at %d from slot %d (sequence %d)", record.baseAddress, record.activeSlot, record.sequence);
+     return true;
+ }
+ 
+ /**
+  * @brief True if the committed slot already holds the payload.
+  */
+ static bool shadowRecordHolds(const ShadowRecord& record, const uint8_t* payload) {
+     if (record.activeSlot == SHADOW_SLOT_NONE) {
+         return false;
+     }
+     int activeAddress = shadowSlotAddress(record, record.activeSlot);
+     uint8_t i = 0;
+     while (i < record.length && EEPROM.read(activeAddress + i) == payload[i]) {
+         ++i;
+     }
+     return i == record.length;
+ }
+
+ /**
+  * @brief Sequence number of the next commit (never SHADOW_SEQUENCE_INVALID).
+  */
+ static uint8_t nextShadowSequence(const ShadowRecord& record) {
+     uint8_t nextSequence = record.sequence + 1;
+     return (nextSequence == SHADOW_SEQUENCE_INVALID) ? 0 : nextSequence;
+ }
+
+ /**
+  * @brief Checks the filled shadow slot, then writes its commit marker (phase 2).
+  */
+ static bool finishShadowCommit(ShadowRecord& record, const uint8_t* payload) {
+     uint8_t targetSlot = (record.activeSlot == 0) ? 1 : 0;
+     int address = shadowSlotAddress(record, targetSlot);
+     for (uint8_t i = 0; i < record.length; ++i) {
+         if (EEPROM.read(address + i) != payload[i]) {
+             DEBUG_PRINTF("Shadow slot at %d failed to verify", address);
+             return false; // the committed slot is still intact
+         }
+     }
+     uint8_t nextSequence = nextShadowSequence(record);
+     EEPROM.update(address + record.length + 1, nextSequence);
+     record.activeSlot = targetSlot;
+     record.sequence = nextSequence;
+     return true;
+ }
+
+ /**
+  * @brief Atomically replaces a multi-field record in EEPROM.
+  *
+  * Phase 1 invalidates the inactive slot (one cell), then writes the payload and
+  * checksum into it with EEPROM.update(), so only the bytes that differ from the
+  * slot's previous contents are programmed. Phase 2 writes the new sequence
+  * number, which is the commit marker. Until that single byte lands, the
+  * previously committed slot is untouched and remains the one recovered at boot.
+  * A commit under way with stepShadowCommit() is replaced by this one.
+  *
+  * @param record The shadow record description (updated on success).
+  * @param data The new payload (record.length bytes).
+  * @return True if committed (or unchanged), false if the payload did not verify.
+  */
+ bool commitShadowRecord(ShadowRecord& record, const void* data) {
+     const uint8_t* payload = static_cast<const uint8_t*>(data);
+     record.commitStep = 0;
+
+     // Nothing to do if the committed slot already holds this payload
+     if (shadowRecordHolds(record, payload)) {
+         return true;
+     }
+
+     uint8_t nextSequence = nextShadowSequence(record);
+     int address = shadowSlotAddress(record, (record.activeSlot == 0) ? 1 : 0);
+
+     // Phase 1: invalidate the shadow slot, then fill it
+     EEPROM.update(address + record.length + 1, SHADOW_SEQUENCE_INVALID);
+     for (uint8_t i = 0; i < record.length; ++i) {
+         EEPROM.update(address + i, payload[i]);
+     }
+     EEPROM.update(address + record.length, shadowChecksum(payload, record.length, nextSequence));
+
+     // Phase 2: the commit marker
+     return finishShadowCommit(record, payload);
+ }
+
+ /**
+  * @brief Runs commitShadowRecord() one EEPROM write per call.
+  *
+  * Each call programs at most one cell and returns, so a caller can spread a
+  * commit over loop() passes instead of waiting some 3.3 ms per written byte.
+  * Cells that already hold their new value are skipped without a call of their
+  * own. The payload must stay the same until the commit is finished; a caller
+  * that changes it sets record.commitStep to 0 to start over.
+  *
+  * @param record The shadow record description (updated once committed).
+  * @param data The new payload (record.length bytes).
+  * @return True while the commit needs more calls, false once it is committed,
+  *         was unchanged or did not verify.
+  */
+ bool stepShadowCommit(ShadowRecord& record, const void* data) {
+     const uint8_t* payload = static_cast<const uint8_t*>(data);
+     int address = shadowSlotAddress(record, (record.activeSlot == 0) ? 1 : 0);
+
+     if (record.commitStep == 0) {
+         if (shadowRecordHolds(record, payload)) {
+             return false;
+         }
+         EEPROM.update(address + record.length + 1, SHADOW_SEQUENCE_INVALID);
+         record.commitStep = 1;
+         return true;
+     }
+     // Steps 1 .. length fill the payload, step length + 1 writes the checksum
+     while (record.commitStep <= record.length + 1) {
+         uint8_t i = record.commitStep++ - 1;
+         uint8_t value = (i < record.length) ? payload[i] : shadowChecksum(payload, record.length, nextShadowSequence(record));
+         if (EEPROM.read(address + i) != value) {
+             EEPROM.update(address + i, value);
+             return true;
+         }
+     }
+     record.commitStep = 0;
+     finishShadowCommit(record, payload);
+     return false;
+ }
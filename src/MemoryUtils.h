@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 9:23:21 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Wednesday, 26th February 2025 8:50:58 pm
+ * Last Modified: Sunday, 18th October 2026 10:01:45 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -27,10 +27,54 @@
  
  #include <Arduino.h>
  
+ /**
+  * @brief Two-phase (shadow slot + commit marker) EEPROM record.
+  *
+  * A multi-field record is kept in two shadow slots, each laid out as
+  * [payload][crc8][sequence]. A commit rewrites only the inactive slot and
+  * finishes with its sequence byte (the commit marker), so a brown-out at any
+  * point leaves either the complete old or the complete new record readable.
+  *
+  * @var baseAddress EEPROM address of the first shadow slot.
+  * @var length Payload size in bytes.
+  * @var activeSlot Slot holding the committed record (0 or 1), SHADOW_SLOT_NONE if none.
+  * @var sequence Sequence number of the committed record.
+  * @var commitStep Progress of a commit made with stepShadowCommit(), 0 if none is under way.
+  */
+ struct ShadowRecord {
+     int baseAddress;
+     uint8_t length;
+     uint8_t activeSlot;
+     uint8_t sequence;
+     uint8_t commitStep;
+ };
+ 
+ constexpr uint8_t SHADOW_SLOT_NONE = 0xFF;
+ constexpr uint8_t SHADOW_SLOT_OVERHEAD = 2; // crc8 + sequence byte per slot
+ /** @brief EEPROM bytes needed by a shadow record with the given payload size. */
+ constexpr int shadowRecordSize(uint8_t length) { return 2 * (length + SHADOW_SLOT_OVERHEAD); }
+
+ // A ring slot holds the delay in its low 24 bits and a sequence number in the top byte
+ constexpr uint8_t RING_SEQUENCE_SHIFT = 24;
+ constexpr int32_t RING_VALUE_MASK = 0x00FFFFFFL;
+ /** @brief Value of a wear leveling ring slot holding the delay with the given sequence number. */
+ constexpr int32_t ringSlotValue(long delay, uint8_t sequence) {
+     return static_cast<int32_t>((static_cast<uint32_t>(delay) & RING_VALUE_MASK) |
+                                 (static_cast<uint32_t>(sequence) << RING_SEQUENCE_SHIFT));
+ }
+ 
  int freeRam(); // Calculates the number of bytes currently free in RAM.
+ int minFreeStack(); // Lowest free stack since boot (stack painting), -1 if unsupported.
  int getNextEEPROMAddress();
+ bool isEEPROMSlotRetired(int slot);
+ bool isEEPROMReady();
  bool writeEEPROMWithRetry(int address, long value);
  long readEEPROMWithRetry(int address);
  void restoreEEPROMAddress();
+ void storeTimerDelay(unsigned long currentMillis);
+ bool recoverShadowRecord(ShadowRecord& record, void* data);
+ bool commitShadowRecord(ShadowRecord& record, const void* data);
+ bool stepShadowCommit(ShadowRecord& record, const void* data);
+ uint8_t crc8(const uint8_t* data, uint8_t length, uint8_t crc = 0);
  
  #endif
\ No newline at end of file
@@ -0,0 +1,244 @@
+/*
+ * File: OutputScheduler.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 9:12:50 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:31:38 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+
+#include "OutputScheduler.h"
+#include "constants.h"
+#include "SharedValue.h"
+
+namespace {
+    constexpr uint8_t CHANNEL_COUNT = static_cast<uint8_t>(OutputChannel::COUNT);
+    constexpr uint8_t PORT_COUNT = 3;   // PORTB, PORTC, PORTD
+
+    constexpr uint8_t portOf(uint8_t pin) { return pin < 8 ? 2 : (pin < 14 ? 0 : 1); }
+
+    /**
+     * @brief Port and bit of a channel.
+     *
+     * @var port 0 = PORTB, 1 = PORTC, 2 = PORTD.
+     * @var mask Bit of the pin within the port.
+     */
+    struct ChannelPin {
+        uint8_t port;
+        uint8_t mask;
+        uint8_t pin;
+    };
+
+    /** @brief Pins of the channels, in OutputChannel order. */
+    const ChannelPin CHANNEL_PINS[CHANNEL_COUNT] PROGMEM = {
+        {portOf(RELAY_PIN), FastPin<RELAY_PIN>::MASK, RELAY_PIN},
+        {portOf(MANUAL_LIGHT_PIN), FastPin<MANUAL_LIGHT_PIN>::MASK, MANUAL_LIGHT_PIN},
+        {portOf(SAFELIGHT_PIN), FastPin<SAFELIGHT_PIN>::MASK, SAFELIGHT_PIN},
+        {portOf(BUZZER_PIN), FastPin<BUZZER_PIN>::MASK, BUZZER_PIN},
+    };
+
+    /**
+     * @brief Channels to switch at one time.
+     *
+     * @var due millis() at which the event is applied.
+     * @var on Channels to switch on.
+     * @var off Channels to switch off.
+     */
+    struct OutputEvent {
+        unsigned long due;
+        uint8_t on;
+        uint8_t off;
+    };
+
+    OutputEvent events[OUTPUT_EVENT_QUEUE_SIZE];   // Sorted by due time, earliest first
+    uint8_t eventCount = 0;
+
+    /** @brief Later switches of the same channels win over the earlier ones in an event. */
+    void merge(OutputEvent& event, uint8_t on, uint8_t off) {
+        event.on = (event.on & ~off) | on;
+        event.off = (event.off & ~on) | off;
+    }
+
+    /** @brief Drops the pending switches of the given channels, and events left empty. */
+    void cancel(uint8_t channels) {
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < eventCount; ++i) {
+            events[i].on &= ~channels;
+            events[i].off &= ~channels;
+            if (events[i].on | events[i].off) {
+                events[kept++] = events[i];
+            }
+        }
+        eventCount = kept;
+    }
+
+    /** @brief Drives one channel through its FastPin: a single sbi/cbi on AVR. */
+    void writeChannel(uint8_t channel, bool level) {
+        switch (static_cast<OutputChannel>(channel)) {
+            case OutputChannel::ENLARGER:
+                level ? RelayPin::high() : RelayPin::low();
+                break;
+            case OutputChannel::FOCUS_LIGHT:
+                level ? ManualLightPin::high() : ManualLightPin::low();
+                break;
+            case OutputChannel::SAFELIGHT:
+                level ? FastPin<SAFELIGHT_PIN>::high() : FastPin<SAFELIGHT_PIN>::low();
+                break;
+            default:
+                level ? FastPin<BUZZER_PIN>::high() : FastPin<BUZZER_PIN>::low();
+                break;
+        }
+    }
+
+    /**
+     * @brief Switches channels, one write per port.
+     *
+     * The enlarger goes first, on its own sbi/cbi, so the relay edge an
+     * exposure is timed from never waits for other channels. A port with
+     * one channel to switch gets a single sbi/cbi as well; a port with
+     * several gets one read-modify-write, interrupts masked.
+     */
+    void apply(uint8_t on, uint8_t off) {
+        uint8_t changed = on | off;
+        if (changed & ENLARGER_OUTPUT) {
+            writeChannel(static_cast<uint8_t>(OutputChannel::ENLARGER), on & ENLARGER_OUTPUT);
+            changed &= ~ENLARGER_OUTPUT;
+        }
+        uint8_t channels[PORT_COUNT] = {0, 0, 0};   // Channels to switch, per port
+        uint8_t set[PORT_COUNT] = {0, 0, 0};
+        uint8_t clear[PORT_COUNT] = {0, 0, 0};
+        for (uint8_t channel = 0; channel < CHANNEL_COUNT; ++channel) {
+            uint8_t bit = 1 << channel;
+            if (changed & bit) {
+                uint8_t port = pgm_read_byte(&CHANNEL_PINS[channel].port);
+                uint8_t mask = pgm_read_byte(&CHANNEL_PINS[channel].mask);
+                channels[port] |= bit;
+                (on & bit ? set : clear)[port] |= mask;
+            }
+        }
+        for (uint8_t port = 0; port < PORT_COUNT; ++port) {
+            uint8_t bits = channels[port];
+            if (bits == 0) {
+                continue;
+            }
+#if defined(__AVR__)
+            if (bits & (bits - 1)) {
+                static volatile uint8_t* const ports[PORT_COUNT] = {&PORTB, &PORTC, &PORTD};
+                InterruptGuard guard;   // the ADC interrupt may clear the relay bit meanwhile
+                *ports[port] = (*ports[port] & ~clear[port]) | set[port];
+                continue;
+            }
+#endif
+            // One channel on this port (or a host build, without port registers)
+            for (uint8_t channel = 0; channel < CHANNEL_COUNT; ++channel) {
+                if (bits & (1 << channel)) {
+                    writeChannel(channel, on & (1 << channel));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Makes all channel pins outputs: everything off but the safelight.
+ */
+void initializeOutputs() {
+    for (uint8_t channel = 0; channel < CHANNEL_COUNT; ++channel) {
+        pinMode(pgm_read_byte(&CHANNEL_PINS[channel].pin), OUTPUT);
+    }
+    eventCount = 0;
+    switchOutputs(SAFELIGHT_OUTPUT, ENLARGER_OUTPUT | FOCUS_LIGHT_OUTPUT | BUZZER_OUTPUT);
+}
+
+/**
+ * @brief Switches channels now, together, and cancels their pending timed switches.
+ *
+ * @param on Mask of channels to switch on (see outputBit()).
+ * @param off Mask of channels to switch off.
+ */
+void switchOutputs(uint8_t on, uint8_t off) {
+    cancel(on | off);
+    apply(on, off);
+}
+
+/**
+ * @brief Adds a timed switch to the event list.
+ *
+ * Switches due at the same millisecond share one event, and are applied
+ * with one write per port.
+ *
+ * @param delayMillis Time from now.
+ * @param on Mask of channels to switch on then.
+ * @param off Mask of channels to switch off then.
+ * @return False if the event list is full (the switch is dropped).
+ */
+bool scheduleOutputs(unsigned long delayMillis, uint8_t on, uint8_t off) {
+    unsigned long due = millis() + delayMillis;
+    uint8_t at = eventCount;
+    while (at > 0 && static_cast<long>(events[at - 1].due - due) > 0) {
+        --at;
+    }
+    if (at > 0 && events[at - 1].due == due) {
+        merge(events[at - 1], on, off);
+        return true;
+    }
+    if (eventCount == OUTPUT_EVENT_QUEUE_SIZE) {
+        DEBUG_PRINT("Output event list full");
+        return false;
+    }
+    for (uint8_t i = eventCount; i > at; --i) {
+        events[i] = events[i - 1];
+    }
+    events[at].due = due;
+    events[at].on = 0;
+    events[at].off = 0;
+    merge(events[at], on, off);
+    ++eventCount;
+    return true;
+}
+
+/**
+ * @brief Applies every event that is due, all in one go. Call once per loop() pass.
+ */
+void tickOutputs() {
+    unsigned long now = millis();
+    uint8_t due = 0;
+    OutputEvent combined = {now, 0, 0};
+    while (due < eventCount && static_cast<long>(now - events[due].due) >= 0) {
+        merge(combined, events[due].on, events[due].off);
+        ++due;
+    }
+    if (due == 0) {
+        return;
+    }
+    for (uint8_t i = due; i < eventCount; ++i) {
+        events[i - due] = events[i];
+    }
+    eventCount -= due;
+    apply(combined.on, combined.off);
+}
+
+/**
+ * @brief Current level of a channel's pin.
+ */
+bool isOutputOn(OutputChannel channel) {
+    return digitalRead(pgm_read_byte(&CHANNEL_PINS[static_cast<uint8_t>(channel)].pin)) == HIGH;
+}
@@ -0,0 +1,80 @@
+/*
+ * File: OutputScheduler.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 9:12:50 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:31:38 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+
+#ifndef OUTPUT_SCHEDULER_H
+#define OUTPUT_SCHEDULER_H
+
+#include <Arduino.h>
+#include "LampControl.h"
+
+/*
+ * Output channels: the enlarger relay, the focus indicator, the safelight and
+ * the buzzer. Every switch goes through switchOutputs() or, for a timed
+ * action, through the event list of scheduleOutputs(), sorted by due time.
+ * All edges that are due together are merged and written with one write per
+ * port (the relay and safelight share PORTD, the indicator and buzzer PORTB),
+ * so outputs meant to switch together do. The enlarger relay is always
+ * switched first and on its own, with RelayPin's single sbi/cbi, so the edge
+ * an exposure is timed from does not depend on what else switches with it;
+ * so is any channel that is alone on its port.
+ *
+ * The light-integrating stop in the ADC interrupt (LightMeter.cpp) clears the
+ * relay bit directly; read-modify-writes of a port mask interrupts so they
+ * never undo it.
+ */
+
+/** @brief Output channels, as bit numbers of a channel mask. */
+enum class OutputChannel : uint8_t {
+    ENLARGER,      // RELAY_PIN
+    FOCUS_LIGHT,   // MANUAL_LIGHT_PIN
+    SAFELIGHT,     // SAFELIGHT_PIN
+    BUZZER,        // BUZZER_PIN
+    COUNT
+};
+
+constexpr uint8_t outputBit(OutputChannel channel) { return 1 << static_cast<uint8_t>(channel); }
+
+constexpr uint8_t ENLARGER_OUTPUT = outputBit(OutputChannel::ENLARGER);
+constexpr uint8_t FOCUS_LIGHT_OUTPUT = outputBit(OutputChannel::FOCUS_LIGHT);
+constexpr uint8_t SAFELIGHT_OUTPUT = outputBit(OutputChannel::SAFELIGHT);
+constexpr uint8_t BUZZER_OUTPUT = outputBit(OutputChannel::BUZZER);
+
+// --- Timed actions around an exposure ---
+constexpr uint16_t SAFELIGHT_LEAD_MS = 200;   // Safelight off this long before the enlarger comes on
+constexpr uint16_t SAFELIGHT_LAG_MS = 1000;   // Safelight back on this long after the exposure
+constexpr uint16_t BUZZER_BEEP_MS = 150;      // Beep at the end of an exposure
+
+/** @brief Capacity of the event list. */
+constexpr uint8_t OUTPUT_EVENT_QUEUE_SIZE = 8;
+
+void initializeOutputs();
+void switchOutputs(uint8_t on, uint8_t off);
+bool scheduleOutputs(unsigned long delayMillis, uint8_t on, uint8_t off);
+void tickOutputs();
+bool isOutputOn(OutputChannel channel);
+
+#endif // OUTPUT_SCHEDULER_H
@@ -0,0 +1,372 @@
+/*
+ * File: PresetStore.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:44:12 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:55:40 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#include <EEPROM.h>
+#include "PresetStore.h"
+#include "MemoryUtils.h"
+#include "LCDHandler.h"
+#include "TimerStateMachine.h"
+
+/*
+ * Profile store for named exposure presets.
+ *
+ * The whole store is one fixed-size image committed atomically through a
+ * ShadowRecord (see MemoryUtils.h) at PRESET_STORE_ADDRESS:
+ *   PresetStoreHeader  - magic, schema version, record size and record count
+ *   Preset[count]      - records of `recordSize` bytes each
+ *   ...
+ *   StoreSettings      - device settings, in the last bytes of the image (schema 2)
+ *
+ * All presets are cached in RAM by loadPresets() at boot, so switching presets
+ * never reads the EEPROM. Records written by an older schema are migrated by
+ * copying the common prefix of each record and defaulting the new fields.
+ * The image size is fixed by PRESET_STORE_SIZE, so the slot geometry never
+ * changes when fields are appended.
+ *
+ * A batch (beginPresetBatch() .. commitPresetBatch()) edits the RAM cache
+ * only and commits every change at once, so a set of presets uploaded over
+ * the serial port is either stored completely or not at all. Cancelling
+ * reloads the last committed image; no second copy is kept in RAM.
+ *
+ * The base delay a preset picks up when an exposure starts is not committed
+ * right away: tickPresets() commits it one byte per loop() pass, while the
+ * timer is idle and once no delay has changed for PRESET_COMMIT_DELAY. A test
+ * strip session then costs one commit instead of one per exposure, and the
+ * start path none.
+ */
+
+constexpr uint8_t PRESET_STORE_MAGIC = 0xD7;    // Marks an initialized profile store
+constexpr uint8_t PRESET_SCHEMA_VERSION = 2;    // Bump when fields are appended to Preset or StoreSettings
+constexpr uint8_t SETTINGS_SCHEMA_VERSION = 2;  // First schema with StoreSettings
+constexpr uint8_t PRESET_IMAGE_SIZE = PRESET_STORE_SIZE / 2 - SHADOW_SLOT_OVERHEAD;
+
+struct PresetStoreHeader {
+    uint8_t magic;
+    uint8_t schemaVersion;
+    uint8_t recordSize;
+    uint8_t recordCount;
+};
+
+struct PresetStoreContents {
+    PresetStoreHeader header;
+    Preset presets[PRESET_COUNT];
+};
+
+/**
+ * @brief Settings of the timer itself, kept at a fixed offset from the end of
+ * the image so they stay put whatever the size of the preset records.
+ *
+ * @var clockPpm Oscillator error measured by the clock calibration (see ClockCalibration.h).
+ */
+struct StoreSettings {
+    int16_t clockPpm;
+};
+
+constexpr uint8_t SETTINGS_OFFSET = PRESET_IMAGE_SIZE - sizeof(StoreSettings);
+
+/** @brief RAM image of the profile store, committed byte for byte. */
+union PresetStoreImage {
+    PresetStoreContents store;
+    uint8_t bytes[PRESET_IMAGE_SIZE];
+};
+
+static_assert(sizeof(PresetStoreContents) <= SETTINGS_OFFSET, "Presets and settings do not fit into PRESET_STORE_SIZE");
+static_assert(shadowRecordSize(PRESET_IMAGE_SIZE) <= PRESET_STORE_SIZE, "Preset shadow slots do not fit into PRESET_STORE_SIZE");
+
+static PresetStoreImage image;                    // RAM cache of the profile store
+static Preset* const presets = image.store.presets;
+static ShadowRecord presetRecord = {PRESET_STORE_ADDRESS, PRESET_IMAGE_SIZE, SHADOW_SLOT_NONE, 0, 0};
+static uint8_t activePresetIndex = NO_PRESET;     // Currently selected preset
+static uint8_t programStep = 0;                   // 0 = base exposure, 1..stepCount = program steps
+static bool batchOpen = false;                    // Changes stay in RAM until commitPresetBatch()
+static bool delayPending = false;                 // A preset delay changed that tickPresets() has not committed yet
+static unsigned long delayChangedAt = 0;          // millis() of the last such change
+
+/**
+ * @brief Fills a preset with factory defaults ("P1".."P4", 10 seconds, no program).
+ */
+static void setDefaultPreset(uint8_t index, Preset& preset) {
+    memset(&preset, 0, sizeof(preset));
+    preset.name[0] = 'P';
+    preset.name[1] = '1' + index;
+    preset.delay = 10000;
+    preset.mode = ExposureMode::LINEAR;
+}
+
+/**
+ * @brief Clamps a preset read from EEPROM or received from outside into valid ranges.
+ */
+static void sanitizePreset(Preset& preset) {
+    preset.name[PRESET_NAME_LENGTH - 1] = '\0';
+    if (preset.delay < 0 || preset.delay > TimerConfig::MAX_DELAY) {
+        preset.delay = 0;
+    }
+    if (static_cast<uint8_t>(preset.mode) > static_cast<uint8_t>(ExposureMode::FSTOP)) {
+        preset.mode = ExposureMode::LINEAR;
+    }
+    if (preset.stepCount > PRESET_MAX_STEPS) {
+        preset.stepCount = 0;
+    }
+    for (uint8_t i = 0; i < preset.stepCount; ++i) {
+        if (preset.steps[i] > TimerConfig::MAX_DELAY / 100) {
+            preset.steps[i] = TimerConfig::MAX_DELAY / 100;
+        }
+    }
+}
+
+/**
+ * @brief Loads all presets into RAM, initializing or migrating the store if needed.
+ *
+ * Must be called once from `setup()`. The committed image is recovered from
+ * its shadow slots; an interrupted commit falls back to the previous image.
+ * A store without the magic byte is initialized with defaults. A store written
+ * with a different schema version, record size or record count is migrated:
+ * the common prefix of every record is kept, new fields get their defaults,
+ * and the result is committed in one step.
+ */
+void loadPresets() {
+    bool committed = recoverShadowRecord(presetRecord, image.bytes);
+    const PresetStoreHeader header = image.store.header;
+    bool initialized = committed && header.magic == PRESET_STORE_MAGIC && header.recordSize > 0;
+
+    if (initialized && header.schemaVersion == PRESET_SCHEMA_VERSION
+        && header.recordSize == sizeof(Preset) && header.recordCount == PRESET_COUNT) {
+        for (uint8_t i = 0; i < PRESET_COUNT; ++i) {
+            sanitizePreset(presets[i]);
+        }
+        return;
+    }
+
+    DEBUG_PRINTF("Migrating preset store from schema %d", initialized ? header.schemaVersion : 0);
+    StoreSettings settings = {0};
+    if (initialized && header.schemaVersion >= SETTINGS_SCHEMA_VERSION) {
+        memcpy(&settings, &image.bytes[SETTINGS_OFFSET], sizeof(settings));
+    }
+    Preset migrated[PRESET_COUNT];
+    for (uint8_t i = 0; i < PRESET_COUNT; ++i) {
+        setDefaultPreset(i, migrated[i]);
+        int recordOffset = sizeof(PresetStoreHeader) + i * header.recordSize;
+        if (initialized && i < header.recordCount && recordOffset + header.recordSize <= PRESET_IMAGE_SIZE) {
+            uint8_t copySize = min(header.recordSize, static_cast<uint8_t>(sizeof(Preset)));
+            memcpy(&migrated[i], &image.bytes[recordOffset], copySize);
+            sanitizePreset(migrated[i]);
+        }
+    }
+    memset(image.bytes, 0, sizeof(image.bytes));
+    memcpy(presets, migrated, sizeof(migrated));
+    memcpy(&image.bytes[SETTINGS_OFFSET], &settings, sizeof(settings));
+    image.store.header.magic = PRESET_STORE_MAGIC;
+    image.store.header.schemaVersion = PRESET_SCHEMA_VERSION;
+    image.store.header.recordSize = sizeof(Preset);
+    image.store.header.recordCount = PRESET_COUNT;
+    commitShadowRecord(presetRecord, image.bytes);
+}
+
+/**
+ * @brief Commits the RAM image, unless a batch is collecting changes.
+ */
+static bool commitPresets() {
+    if (batchOpen) {
+        return true;
+    }
+    delayPending = false; // the image holds it
+    return commitShadowRecord(presetRecord, image.bytes);
+}
+
+/**
+ * @brief Replaces a preset in RAM and commits the profile store.
+ *
+ * The commit is atomic and only rewrites the bytes that actually changed.
+ * Inside a batch the preset is only staged in RAM.
+ *
+ * @param index The preset index (0 .. PRESET_COUNT - 1).
+ * @param preset The new preset contents.
+ * @return True if the preset was stored, false for an invalid index or a failed commit.
+ */
+bool storePreset(uint8_t index, const Preset& preset) {
+    if (index >= PRESET_COUNT) {
+        return false;
+    }
+    presets[index] = preset;
+    sanitizePreset(presets[index]);
+    return commitPresets();
+}
+
+/**
+ * @brief Returns the stored oscillator correction in parts per million (0 until calibrated).
+ */
+long getStoredClockPpm() {
+    StoreSettings settings;
+    memcpy(&settings, &image.bytes[SETTINGS_OFFSET], sizeof(settings));
+    return settings.clockPpm;
+}
+
+/**
+ * @brief Stores the oscillator correction with the profile store (or stages it in a batch).
+ *
+ * @param ppm The correction in parts per million (stored in 16 bits).
+ * @return True if it was stored.
+ */
+bool storeClockPpm(long ppm) {
+    StoreSettings settings = {static_cast<int16_t>(ppm)};
+    memcpy(&image.bytes[SETTINGS_OFFSET], &settings, sizeof(settings));
+    return commitPresets();
+}
+
+/**
+ * @brief Returns a cached preset. The index must be below PRESET_COUNT.
+ */
+const Preset& getPreset(uint8_t index) {
+    return presets[index];
+}
+
+/**
+ * @brief Returns the active preset index, or NO_PRESET.
+ */
+uint8_t getActivePresetIndex() {
+    return activePresetIndex;
+}
+
+/**
+ * @brief Switches to the next preset (P1 -> P2 -> ... -> none -> P1).
+ */
+void selectNextPreset() {
+    uint8_t next = (activePresetIndex == NO_PRESET) ? 0 : activePresetIndex + 1;
+    selectPreset(next < PRESET_COUNT ? next : NO_PRESET);
+}
+
+/**
+ * @brief Makes a preset active.
+ *
+ * Recalls the delay and mode of the preset from the RAM cache. Selecting
+ * "none" resets the timer to zero, as the encoder push button always did.
+ *
+ * @param index The preset index, or NO_PRESET.
+ */
+void selectPreset(uint8_t index) {
+    activePresetIndex = (index < PRESET_COUNT) ? index : NO_PRESET;
+    programStep = 0;
+
+    if (activePresetIndex == NO_PRESET) {
+        timerDelay = 0;
+        exposureMode = ExposureMode::LINEAR;
+    } else {
+        timerDelay = presets[activePresetIndex].delay;
+        exposureMode = presets[activePresetIndex].mode;
+    }
+    DEBUG_PRINTF("Preset %d selected, delay %ld ms", activePresetIndex, timerDelay);
+    displayPresetName();
+}
+
+/**
+ * @brief Saves an adjusted base delay into the active preset.
+ *
+ * Called when an exposure starts. Program steps never overwrite the base delay.
+ * The change is committed later by tickPresets().
+ *
+ * @param delay The delay the exposure was started with, in milliseconds.
+ */
+void updateActivePresetDelay(long delay) {
+    if (activePresetIndex == NO_PRESET || programStep != 0 || presets[activePresetIndex].delay == delay) {
+        return;
+    }
+    presets[activePresetIndex].delay = delay;
+    presetRecord.commitStep = 0; // a commit under way has the old image
+    delayPending = true;
+    delayChangedAt = millis();
+}
+
+/**
+ * @brief Call once per loop() pass. Commits a changed preset delay while the timer is idle.
+ *
+ * Waits until no delay has changed for PRESET_COMMIT_DELAY, then writes at
+ * most one EEPROM byte per pass, and only when the EEPROM is ready.
+ */
+void tickPresets() {
+    if (!delayPending || batchOpen || getTimerState() != TimerState::IDLE || !isEEPROMReady()
+        || millis() - delayChangedAt < PRESET_COMMIT_DELAY) {
+        return;
+    }
+    delayPending = stepShadowCommit(presetRecord, image.bytes);
+}
+
+/**
+ * @brief Advances the step program of the active preset after an exposure.
+ *
+ * @param fallbackDelay The delay to return when no step program is active.
+ * @return The delay of the next program step, the base delay after the last
+ *         step, or fallbackDelay.
+ */
+long nextProgramDelay(long fallbackDelay) {
+    if (activePresetIndex == NO_PRESET || presets[activePresetIndex].stepCount == 0) {
+        return fallbackDelay;
+    }
+    const Preset& preset = presets[activePresetIndex];
+    programStep = (programStep + 1) % (preset.stepCount + 1);
+    return programStep ? preset.steps[programStep - 1] * 100L : preset.delay;
+}
+
+/**
+ * @brief Starts collecting preset changes in RAM (see storePreset()).
+ */
+void beginPresetBatch() {
+    if (delayPending) {
+        commitPresets(); // cancelling the batch reloads the committed image
+    }
+    batchOpen = true;
+}
+
+/**
+ * @brief Commits every change made since beginPresetBatch() in one atomic write.
+ *
+ * @return True if the store was committed, false without an open batch or on a failed commit.
+ */
+bool commitPresetBatch() {
+    if (!batchOpen) {
+        return false;
+    }
+    batchOpen = false;
+    displayPresetName();
+    return commitPresets();
+}
+
+/**
+ * @brief Drops every change made since beginPresetBatch().
+ */
+void cancelPresetBatch() {
+    if (!batchOpen) {
+        return;
+    }
+    batchOpen = false;
+    loadPresets(); // the committed image is still in EEPROM
+    displayPresetName();
+}
+
+/**
+ * @brief True between beginPresetBatch() and its commit or cancel.
+ */
+bool isPresetBatchOpen() {
+    return batchOpen;
+}
@@ -0,0 +1,76 @@
+/*
+ * File: PresetStore.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:43:36 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:55:40 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#ifndef PRESET_STORE_H
+#define PRESET_STORE_H
+
+#include <Arduino.h>
+#include "constants.h"
+
+// --- Preset Configuration ---
+constexpr uint8_t PRESET_COUNT = 4;        // Number of presets in the profile store
+constexpr uint8_t PRESET_NAME_LENGTH = 5;  // Including the terminating zero (fits right of the big digits)
+constexpr uint8_t PRESET_MAX_STEPS = 4;    // Exposures of a step program after the base exposure
+constexpr uint8_t NO_PRESET = 0xFF;        // Active preset index when no preset is selected
+constexpr unsigned long PRESET_COMMIT_DELAY = 300000; // Time without delay changes before a preset delay is written to EEPROM (ms)
+
+/**
+ * @brief A named exposure preset (paper/negative combination).
+ *
+ * Presets are persisted as-is in the profile store, so new fields must only be
+ * appended at the end and PRESET_SCHEMA_VERSION bumped; older records are then
+ * migrated field by field instead of being wiped.
+ *
+ * @var delay Base exposure in milliseconds.
+ * @var steps Step program: exposures run after the base exposure, in deciseconds.
+ * @var name Short display name, shown right of the big digits.
+ * @var mode Exposure mode (see ExposureMode).
+ * @var stepCount Number of valid entries in steps.
+ */
+struct Preset {
+    int32_t delay;
+    uint16_t steps[PRESET_MAX_STEPS];
+    char name[PRESET_NAME_LENGTH];
+    ExposureMode mode;
+    uint8_t stepCount;
+};
+
+void loadPresets();
+bool storePreset(uint8_t index, const Preset& preset);
+const Preset& getPreset(uint8_t index);
+uint8_t getActivePresetIndex();
+void selectNextPreset();
+void selectPreset(uint8_t index);
+void updateActivePresetDelay(long delay);
+void tickPresets();
+long nextProgramDelay(long fallbackDelay);
+void beginPresetBatch();
+bool commitPresetBatch();
+void cancelPresetBatch();
+bool isPresetBatchOpen();
+long getStoredClockPpm();
+bool storeClockPpm(long ppm);
+
+#endif // PRESET_STORE_H
@@ -0,0 +1,531 @@
+/*
+ * File: SerialCommands.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:29:57 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:57:09 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#include "SerialCommands.h"
+#include "SerialOutput.h"
+#include "constants.h"
+#include "ButtonHandler.h"
+#include "ClockCalibration.h"
+#include "ExposureHistory.h"
+#include "LightMeter.h"
+#include "MemoryUtils.h"
+#include "PresetStore.h"
+#include "Telemetry.h"
+#include "TimerStateMachine.h"
+
+namespace {
+    constexpr uint8_t REPLY_SIZE = 72;                  // Longest reply line (DIAG)
+    constexpr long MAX_STEP_DECISECONDS = TimerConfig::MAX_DELAY / 100;
+
+    char line[COMMAND_LINE_SIZE];
+    uint8_t lineLength = 0;
+    bool lineOverflow = false;                         // Rest of the line is discarded
+    uint8_t historyDumpLeft = 0;                       // HIST lines still to send (+1 for the final OK)
+
+    /**
+     * @brief One reply line, assembled on the stack without printf.
+     */
+    class Reply {
+    public:
+        Reply() : length(0) { text[0] = '\0'; }
+
+        /** @brief Appends a string from program memory (PSTR). */
+        Reply& add(const char* flashText) {
+            for (char c; (c = pgm_read_byte(flashText)) != '\0'; ++flashText) {
+                put(c);
+            }
+            return *this;
+        }
+        /** @brief Appends a string from RAM. */
+        Reply& addText(const char* ramText) {
+            while (*ramText != '\0') {
+                put(*ramText++);
+            }
+            return *this;
+        }
+        Reply& add(long value) {
+            if (value < 0) {
+                put('-');
+                return add(0UL - static_cast<unsigned long>(value));
+            }
+            return add(static_cast<unsigned long>(value));
+        }
+        Reply& add(unsigned long value) {
+            char digits[3 * sizeof(unsigned long)];
+            uint8_t count = 0;
+            do {
+                digits[count++] = '0' + value % 10;
+                value /= 10;
+            } while (value > 0);
+            while (count > 0) {
+                put(digits[--count]);
+            }
+            return *this;
+        }
+        void send() { queueSerialText(text); }
+        uint8_t size() const { return length; }
+
+    private:
+        void put(char c) {
+            if (length < REPLY_SIZE - 1) {
+                text[length++] = c;
+                text[length] = '\0';
+            }
+        }
+
+        char text[REPLY_SIZE];
+        uint8_t length;
+    };
+
+    void replyOk() {
+        Reply().add(PSTR("OK")).send();
+    }
+
+    void replyError(const char* reason) {
+        Reply().add(PSTR("ERR ")).add(reason).send();
+    }
+
+    /** @brief Splits the next space-separated word off the line, in place. */
+    char* nextToken(char*& cursor) {
+        while (*cursor == ' ' || *cursor == '\t') {
+            ++cursor;
+        }
+        if (*cursor == '\0') {
+            return nullptr;
+        }
+        char* token = cursor;
+        while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t') {
+            ++cursor;
+        }
+        if (*cursor != '\0') {
+            *cursor++ = '\0';
+        }
+        return token;
+    }
+
+    /** @brief Case-insensitive comparison with an upper-case keyword in program memory. */
+    bool isKeyword(const char* token, const char* keyword) {
+        if (token == nullptr) {
+            return false;
+        }
+        for (;; ++token, ++keyword) {
+            char expected = pgm_read_byte(keyword);
+            char c = (*token >= 'a' && *token <= 'z') ? *token - ('a' - 'A') : *token;
+            if (c != expected) {
+                return false;
+            }
+            if (c == '\0') {
+                return true;
+            }
+        }
+    }
+
+    /** @brief Parses a decimal number within [minimum, maximum]. */
+    bool parseNumber(const char* token, long minimum, long maximum, long& value) {
+        if (token == nullptr || *token == '\0') {
+            return false;
+        }
+        bool negative = (*token == '-');
+        token += negative ? 1 : 0;
+        long result = 0;
+        do {
+            if (*token < '0' || *token > '9' || result > 99999999L) {
+                return false;   // not a digit, or far out of any range we accept
+            }
+            result = result * 10 + (*token - '0');
+        } while (*++token != '\0');
+        value = negative ? -result : result;
+        return value >= minimum && value <= maximum;
+    }
+
+    /** @brief Parses a 1-based preset number into an index. */
+    bool parsePresetIndex(const char* token, uint8_t& index) {
+        long number;
+        if (!parseNumber(token, 1, PRESET_COUNT, number)) {
+            return false;
+        }
+        index = static_cast<uint8_t>(number - 1);
+        return true;
+    }
+
+    /** @brief Reads the step program (deciseconds) from the rest of the line. */
+    bool parseSteps(char*& cursor, Preset& preset) {
+        preset.stepCount = 0;
+        for (char* token; (token = nextToken(cursor)) != nullptr;) {
+            long step;
+            if (preset.stepCount == PRESET_MAX_STEPS || !parseNumber(token, 1, MAX_STEP_DECISECONDS, step)) {
+                return false;
+            }
+            preset.steps[preset.stepCount++] = static_cast<uint16_t>(step);
+        }
+        return true;
+    }
+
+    /** @brief Stores a preset now, or stages it when a batch is open. */
+    void storeFromCommand(uint8_t index, const Preset& preset) {
+        if (!isPresetBatchOpen() && isLampInUse()) {
+            replyError(PSTR("busy"));   // EEPROM writes would stall the exposure
+            return;
+        }
+        if (storePreset(index, preset)) {
+            replyOk();
+        } else {
+            replyError(PSTR("eeprom"));
+        }
+    }
+
+    // --- Commands ---
+
+    void commandGet(char* args) {
+        char* what = nextToken(args);
+        if (isKeyword(what, PSTR("DELAY")) && nextToken(args) == nullptr) {
+            Reply().add(PSTR("DELAY ")).add(timerDelay).send();
+            return;
+        }
+        uint8_t index;
+        if (!isKeyword(what, PSTR("PRESET")) || !parsePresetIndex(nextToken(args), index) || nextToken(args) != nullptr) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        const Preset& preset = getPreset(index);
+        Reply reply;
+        reply.add(PSTR("PRESET ")).add(static_cast<long>(index + 1)).add(PSTR(" ")).addText(preset.name)
+             .add(PSTR(" ")).add(static_cast<long>(preset.delay))
+             .add(preset.mode == ExposureMode::FSTOP ? PSTR(" FSTOP") : PSTR(" LINEAR"));
+        for (uint8_t i = 0; i < preset.stepCount; ++i) {
+            reply.add(PSTR(" ")).add(static_cast<long>(preset.steps[i]));
+        }
+        reply.send();
+    }
+
+    void commandSet(char* args) {
+        long delay;
+        if (!isKeyword(nextToken(args), PSTR("DELAY"))
+            || !parseNumber(nextToken(args), 0, TimerConfig::MAX_DELAY, delay) || nextToken(args) != nullptr) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        if (getTimerState() != TimerState::IDLE) {
+            replyError(PSTR("busy"));
+            return;
+        }
+        timerDelay = delay;
+        replyOk();
+    }
+
+    void commandStart(char*) {
+        TimerState before = getTimerState();
+        dispatchTimerEvent(TimerEvent::START);
+        if (getTimerState() == before) {
+            replyError(PSTR("state"));
+        } else {
+            replyOk();
+        }
+    }
+
+    void commandAbort(char*) {
+        if (!isLampInUse()) {
+            replyError(PSTR("state"));
+            return;
+        }
+        abortLampUse();
+        replyOk();
+    }
+
+    void commandPreset(char* args) {
+        uint8_t index;
+        long delay;
+        Preset preset;
+        memset(&preset, 0, sizeof(preset));
+        char* name = nullptr;
+        char* mode = nullptr;
+        if (!parsePresetIndex(nextToken(args), index) || (name = nextToken(args)) == nullptr
+            || strlen(name) >= PRESET_NAME_LENGTH
+            || !parseNumber(nextToken(args), 0, TimerConfig::MAX_DELAY, delay)
+            || (mode = nextToken(args)) == nullptr) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        if (isKeyword(mode, PSTR("FSTOP"))) {
+            preset.mode = ExposureMode::FSTOP;
+        } else if (isKeyword(mode, PSTR("LINEAR"))) {
+            preset.mode = ExposureMode::LINEAR;
+        } else {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        if (!parseSteps(args, preset)) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        strcpy(preset.name, name);
+        preset.delay = delay;
+        storeFromCommand(index, preset);
+    }
+
+    void commandProgram(char* args) {
+        uint8_t index;
+        if (!parsePresetIndex(nextToken(args), index)) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        Preset preset = getPreset(index);
+        if (!parseSteps(args, preset)) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        storeFromCommand(index, preset);
+    }
+
+    void commandBegin(char*) {
+        beginPresetBatch();
+        replyOk();
+    }
+
+    void commandCommit(char*) {
+        if (!isPresetBatchOpen()) {
+            replyError(PSTR("no batch"));
+        } else if (isLampInUse()) {
+            replyError(PSTR("busy"));   // the batch stays open, commit again when idle
+        } else if (commitPresetBatch()) {
+            replyOk();
+        } else {
+            replyError(PSTR("eeprom"));
+        }
+    }
+
+    void commandCancel(char*) {
+        cancelPresetBatch();
+        replyOk();
+    }
+
+    void commandDiag(char*) {
+        Reply().add(PSTR("DIAG state=")).add(static_cast<long>(getTimerState()))
+               .add(PSTR(" ram=")).add(static_cast<long>(freeRam()))
+               .add(PSTR(" stack=")).add(static_cast<long>(minFreeStack()))
+               .add(PSTR(" ee_bad=")).add(static_cast<long>(badBlocksCount))
+               .add(PSTR("/")).add(static_cast<long>(EEPROM_SLOT_COUNT))
+               .add(PSTR(" ee_fail=")).add(static_cast<long>(EEPROM_FAILED))
+               .add(PSTR(" tx_drop=")).add(static_cast<long>(droppedSerialFrames()))
+               .send();
+    }
+
+    void commandTelemetry(char* args) {
+        char* token = nextToken(args);
+        long periodMillis;
+        if (token != nullptr) {
+            if (!parseNumber(token, 0, 60000, periodMillis) || nextToken(args) != nullptr) {
+                replyError(PSTR("syntax"));
+                return;
+            }
+            setTelemetryPeriod(static_cast<uint16_t>(periodMillis));
+        }
+        Reply().add(PSTR("TELEM ")).add(static_cast<long>(getTelemetryPeriod())).send();
+    }
+
+    void commandCalibrate(char* args) {
+        char* what = nextToken(args);
+        long value = CALIBRATION_DEFAULT_PULSES;
+        if (what == nullptr) {
+            CalibrationState state = getCalibrationState();
+            Reply().add(PSTR("CAL ")).add(getClockPpm())
+                   .add(state == CalibrationState::RUNNING ? PSTR(" RUNNING ")
+                        : state == CalibrationState::DONE ? PSTR(" DONE ")
+                        : state == CalibrationState::FAILED ? PSTR(" FAILED ") : PSTR(" IDLE "))
+                   .add(static_cast<long>(calibrationPulsesSeen())).send();
+        } else if (isKeyword(what, PSTR("START"))) {
+            char* pulses = nextToken(args);
+            if ((pulses != nullptr && !parseNumber(pulses, 1, 254, value)) || nextToken(args) != nullptr) {
+                replyError(PSTR("syntax"));
+                return;
+            }
+            beginClockCalibration(static_cast<uint8_t>(value));
+            replyOk();
+        } else if (isKeyword(what, PSTR("SET"))) {
+            if (!parseNumber(nextToken(args), -CALIBRATION_MAX_PPM, CALIBRATION_MAX_PPM, value) || nextToken(args) != nullptr) {
+                replyError(PSTR("syntax"));
+            } else if (isLampInUse()) {
+                replyError(PSTR("busy"));
+            } else if (setClockPpm(value)) {
+                replyOk();
+            } else {
+                replyError(PSTR("eeprom"));
+            }
+        } else {
+            replyError(PSTR("syntax"));
+        }
+    }
+
+    void commandDose(char* args) {
+        char* what = nextToken(args);
+        long reference;
+        if (what == nullptr) {
+            Reply().add(isDoseMode() ? PSTR("DOSE ON ") : PSTR("DOSE OFF "))
+                   .add(static_cast<long>(getDoseReference())).send();
+            return;
+        }
+        if (isKeyword(what, PSTR("ON")) || isKeyword(what, PSTR("OFF"))) {
+            if (nextToken(args) != nullptr) {
+                replyError(PSTR("syntax"));
+                return;
+            }
+            setDoseMode(isKeyword(what, PSTR("ON")));   // from the next exposure on
+            replyOk();
+            return;
+        }
+        if (!isKeyword(what, PSTR("REF"))) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        char* value = nextToken(args);
+        if (value == nullptr) {
+            if (getTimerState() != TimerState::METER || lightReading() == 0) {
+                replyError(PSTR("state"));   // the reading of the open meter is taken
+                return;
+            }
+            reference = lightReading();
+        } else if (!parseNumber(value, 1, METER_FULL_SCALE, reference) || nextToken(args) != nullptr) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        setDoseReference(static_cast<uint16_t>(reference));
+        Reply().add(PSTR("DOSE REF ")).add(reference).send();
+    }
+
+    void commandHistory(char* args) {
+        if (nextToken(args) != nullptr) {
+            replyError(PSTR("syntax"));
+            return;
+        }
+        historyDumpLeft = historyCount() + 1;   // sent by sendHistoryLine(), oldest first
+    }
+
+    /**
+     * @brief Sends the next line of a HIST dump, if the transmit ring has room for it.
+     *
+     * One line per loop pass, so a full history never stalls the loop or
+     * overruns the ring. The records are read when they are sent: exposures
+     * finished meanwhile shift the ages, which at worst repeats a record.
+     */
+    void sendHistoryLine() {
+        Reply reply;
+        ExposureRecord record;
+        if (historyDumpLeft == 1) {
+            reply.add(PSTR("OK"));
+        } else if (getHistoryRecord(historyDumpLeft - 2, record)) {
+            reply.add(PSTR("HIST ")).add(static_cast<long>(record.sequence))
+                 .add(PSTR(" ")).add(static_cast<unsigned long>(record.startMillis))
+                 .add(PSTR(" ")).add(static_cast<unsigned long>(record.requestedMillis))
+                 .add(PSTR(" ")).add(static_cast<unsigned long>(record.lampMicros))
+                 .add((record.flags & HISTORY_MODE_MASK) == static_cast<uint8_t>(ExposureMode::FSTOP) ? PSTR(" FSTOP") : PSTR(" LINEAR"))
+                 .add((record.flags & HISTORY_ABORTED) ? PSTR(" ABORTED") : PSTR(" DONE"))
+                 .add((record.flags & HISTORY_DOSE) ? PSTR(" DOSE") : PSTR(""));
+        } else {
+            --historyDumpLeft;   // the record is gone (or unreadable), skip it
+            return;
+        }
+        if (serialTextFits(reply.size())) {
+            reply.send();
+            --historyDumpLeft;
+        }
+    }
+
+    typedef void (*CommandHandler)(char* args);
+
+    struct Command {
+        char name[8];
+        CommandHandler handler;
+    };
+
+    const Command COMMANDS[] PROGMEM = {
+        {"GET", commandGet},
+        {"SET", commandSet},
+        {"START", commandStart},
+        {"ABORT", commandAbort},
+        {"PRESET", commandPreset},
+        {"PROGRAM", commandProgram},
+        {"BEGIN", commandBegin},
+        {"COMMIT", commandCommit},
+        {"CANCEL", commandCancel},
+        {"DIAG", commandDiag},
+        {"TELEM", commandTelemetry},
+        {"HIST", commandHistory},
+        {"CAL", commandCalibrate},
+        {"DOSE", commandDose},
+    };
+
+    void executeLine(char* cursor) {
+        char* word = nextToken(cursor);
+        if (word == nullptr) {
+            return; // empty line
+        }
+        for (uint8_t i = 0; i < sizeof(COMMANDS) / sizeof(COMMANDS[0]); ++i) {
+            if (isKeyword(word, COMMANDS[i].name)) {
+                CommandHandler handler = reinterpret_cast<CommandHandler>(pgm_read_ptr(&COMMANDS[i].handler));
+                handler(cursor);
+                return;
+            }
+        }
+        replyError(PSTR("unknown command"));
+    }
+}
+
+/**
+ * @brief Parses received bytes and runs at most one complete command.
+ *
+ * Call once per loop() pass. Never waits for input. While a HIST dump is
+ * being sent, it sends one more line instead.
+ */
+void pollSerialCommands() {
+    if (historyDumpLeft > 0) {
+        sendHistoryLine();   // the next command waits until the dump is complete
+        return;
+    }
+    for (uint8_t i = 0; i < COMMAND_BYTES_PER_POLL && Serial.available() > 0; ++i) {
+        char c = static_cast<char>(Serial.read());
+        if (c != '\r' && c != '\n') {
+            if (lineLength < COMMAND_LINE_SIZE - 1) {
+                line[lineLength++] = c;
+            } else {
+                lineOverflow = true;
+            }
+            continue;
+        }
+        bool overflow = lineOverflow;
+        line[lineLength] = '\0';
+        uint8_t length = lineLength;
+        lineLength = 0;
+        lineOverflow = false;
+        if (overflow) {
+            replyError(PSTR("line too long"));
+            return;
+        }
+        if (length > 0) {
+            executeLine(line);
+            return; // one command per pass keeps loop() short
+        }
+    }
+}
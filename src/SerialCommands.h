@@ -0,0 +1,62 @@
+/*
+ * File: SerialCommands.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:29:57 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:57:09 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#ifndef SERIAL_COMMANDS_H
+#define SERIAL_COMMANDS_H
+
+#include <Arduino.h>
+
+/*
+ * Line-oriented remote control over the serial port (115200 baud).
+ *
+ * Commands are words separated by spaces, one command per line ending in
+ * CR, LF or both; keywords are not case sensitive. Every command gets one
+ * reply line: the requested value, "OK", or "ERR <reason>".
+ *
+ *   GET DELAY                    -> DELAY <ms>
+ *   SET DELAY <ms>               set the timer (idle only)
+ *   START                        start, pause or resume, like the timer button
+ *   ABORT                        stop the exposure, focus light or meter, like the encoder button
+ *   GET PRESET <1-4>             -> PRESET <n> <name> <ms> <LINEAR|FSTOP> [<step ds>...]
+ *   PRESET <1-4> <name> <ms> <LINEAR|FSTOP> [<step ds>...]
+ *                                replace a preset and its step program (steps in deciseconds)
+ *   PROGRAM <1-4> [<step ds>...] replace only the step program of a preset
+ *   BEGIN / COMMIT / CANCEL      stage PRESET and PROGRAM lines and store them in one write
+ *   DIAG                         -> DIAG state=.. ram=.. stack=.. ee_bad=../.. ee_fail=.. tx_drop=..
+ *   TELEM [<ms>]                 -> TELEM <ms>; sets the telemetry period, 0 stops it (see Telemetry.h)
+ *
+ * The parser never blocks and never allocates: it takes the bytes already
+ * received, at most COMMAND_BYTES_PER_POLL of them and at most one command
+ * per call, and keeps the partial line in a fixed buffer. Replies go through
+ * the non-blocking transmit ring (see SerialOutput.h).
+ */
+
+constexpr uint8_t COMMAND_LINE_SIZE = 64;       // Longest accepted line, including the terminator
+constexpr uint8_t COMMAND_BYTES_PER_POLL = 16;  // Received bytes parsed per loop() pass
+
+void pollSerialCommands();
+
+#endif // SERIAL_COMMANDS_H
@@ -0,0 +1,186 @@
+/*
+ * File: SerialOutput.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:24:04 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:47:18 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#include "SerialOutput.h"
+#include "MemoryUtils.h"
+
+static_assert((SERIAL_TX_RING_SIZE & (SERIAL_TX_RING_SIZE - 1)) == 0 && SERIAL_TX_RING_SIZE <= 128,
+              "SERIAL_TX_RING_SIZE must be a power of two no larger than 128");
+
+// Type byte + payload + CRC, plus the COBS code byte and the delimiter
+constexpr uint8_t SERIAL_FRAME_MAX_ENCODED = 1 + SERIAL_FRAME_MAX_PAYLOAD + 1 + 1 + 1;
+constexpr uint8_t TX_RING_MASK = SERIAL_TX_RING_SIZE - 1;
+
+static uint8_t txRing[SERIAL_TX_RING_SIZE];
+// Free-running indices: head - tail is the fill level, even across the uint8_t wrap
+static uint8_t txHead = 0;
+static uint8_t txTail = 0;
+static uint16_t pendingDrops = 0;   // Dropped since the last frame that got through
+static uint16_t totalDrops = 0;
+
+/**
+ * @brief Appends one byte to a COBS encoding in progress.
+ *
+ * @param out Encoded output.
+ * @param length Bytes written to out so far.
+ * @param code Index in out of the code byte of the current block.
+ */
+static void cobsPut(uint8_t* out, uint8_t& length, uint8_t& code, uint8_t value) {
+    if (value == 0) {
+        out[code] = length - code;
+        code = length++;
+        return;
+    }
+    out[length++] = value;
+    // A block holds at most 254 data bytes; frames here never get close
+}
+
+/**
+ * @brief Copies bytes into the ring if all of them fit.
+ */
+static bool enqueue(const uint8_t* data, uint8_t length) {
+    uint8_t used = txHead - txTail;
+    if (length > SERIAL_TX_RING_SIZE - used) {
+        return false;
+    }
+    for (uint8_t i = 0; i < length; ++i) {
+        txRing[txHead++ & TX_RING_MASK] = data[i];
+    }
+    return true;
+}
+
+static void countDrop() {
+    if (pendingDrops < 0xFFFF) ++pendingDrops;
+    if (totalDrops < 0xFFFF) ++totalDrops;
+}
+
+/**
+ * @brief Encodes and queues one frame, without drop accounting.
+ */
+static bool enqueueFrame(FrameType type, const uint8_t* payload, uint8_t length) {
+    uint8_t encoded[SERIAL_FRAME_MAX_ENCODED];
+    uint8_t size = 1;
+    uint8_t code = 0;
+    uint8_t header = static_cast<uint8_t>(type);
+    uint8_t crc = crc8(payload, length, crc8(&header, 1));
+
+    cobsPut(encoded, size, code, header);
+    for (uint8_t i = 0; i < length; ++i) {
+        cobsPut(encoded, size, code, payload[i]);
+    }
+    cobsPut(encoded, size, code, crc);
+    encoded[code] = size - code;
+    encoded[size++] = 0;
+    return enqueue(encoded, size);
+}
+
+/**
+ * @brief Queues one binary frame for transmission without blocking.
+ *
+ * @param type Frame type, sent first.
+ * @param payload Frame payload.
+ * @param length Payload length, at most SERIAL_FRAME_MAX_PAYLOAD.
+ * @return True if the frame was queued, false if it was dropped.
+ */
+bool queueSerialFrame(FrameType type, const uint8_t* payload, uint8_t length) {
+    if (length > SERIAL_FRAME_MAX_PAYLOAD) {
+        return false;
+    }
+    if (pendingDrops > 0) {
+        uint8_t count[2] = { static_cast<uint8_t>(pendingDrops), static_cast<uint8_t>(pendingDrops >> 8) };
+        if (!enqueueFrame(FrameType::DROPPED, count, sizeof(count))) {
+            countDrop();
+            return false;
+        }
+        pendingDrops = 0;
+    }
+    if (!enqueueFrame(type, payload, length)) {
+        countDrop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief True if a frame with this payload length fits in the ring right now.
+ *
+ * Lets optional, periodic output skip a sample instead of dropping it.
+ */
+bool serialFrameFits(uint8_t length) {
+    uint8_t used = txHead - txTail;
+    // Encoded size is payload + 4 (code byte, type, CRC, delimiter), plus the drop report if one is due
+    uint8_t needed = length + 4 + (pendingDrops > 0 ? 2 + 4 : 0);
+    return length <= SERIAL_FRAME_MAX_PAYLOAD && needed <= SERIAL_TX_RING_SIZE - used;
+}
+
+/**
+ * @brief True if a text line of this length fits in the ring right now.
+ *
+ * Lets a long reply go out one line per loop pass instead of dropping lines.
+ */
+bool serialTextFits(uint8_t length) {
+    uint8_t used = txHead - txTail;
+    // "\r\n" and the delimiter
+    return length + 3 <= SERIAL_TX_RING_SIZE - used;
+}
+
+/**
+ * @brief Queues one line of text for transmission without blocking.
+ *
+ * @param text The line, without line ending; "\r\n" and the delimiter are appended.
+ * @return True if the line was queued, false if it was dropped.
+ */
+bool queueSerialText(const char* text) {
+    static const uint8_t ending[] = { '\r', '\n', 0 };
+    size_t length = strlen(text);
+    uint8_t used = txHead - txTail;
+    if (length + sizeof(ending) > static_cast<size_t>(SERIAL_TX_RING_SIZE - used)) {
+        countDrop();
+        return false;
+    }
+    enqueue(reinterpret_cast<const uint8_t*>(text), static_cast<uint8_t>(length));
+    return enqueue(ending, sizeof(ending));
+}
+
+/**
+ * @brief Moves queued bytes to the UART, as many as it accepts without blocking.
+ *
+ * Call once per loop iteration.
+ */
+void flushSerialOutput() {
+    int space = Serial.availableForWrite();
+    while (space > 0 && txTail != txHead) {
+        Serial.write(txRing[txTail++ & TX_RING_MASK]);
+        --space;
+    }
+}
+
+/**
+ * @brief Frames dropped because the ring was full, since boot (saturates at 65535).
+ */
+uint16_t droppedSerialFrames() {
+    return totalDrops;
+}
@@ -0,0 +1,78 @@
+/*
+ * File: SerialOutput.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:24:04 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:47:18 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#ifndef SERIAL_OUTPUT_H
+#define SERIAL_OUTPUT_H
+
+#include <Arduino.h>
+
+/*
+ * Non-blocking serial output.
+ *
+ * Everything the firmware sends goes through one transmit ring instead of
+ * Serial.print(), so a slow or absent host never stalls the main loop:
+ * queueing is all-or-nothing and never waits, and flushSerialOutput(), called
+ * once per loop, hands the hardware UART only as many bytes as
+ * Serial.availableForWrite() says it can take without blocking.
+ *
+ * Binary records are sent as frames:
+ *   COBS([type][payload...][crc8]) 0x00
+ * COBS (consistent overhead byte stuffing) removes every zero from the frame,
+ * so 0x00 only ever appears as the delimiter and a decoder that starts reading
+ * mid-stream resynchronizes at the next one. The CRC-8 (polynomial 0x07) covers
+ * the type and the payload. A frame that does not fit in the ring is dropped
+ * and counted; the next frame that fits is preceded by a DROPPED frame carrying
+ * the count, so the host knows exactly where records are missing.
+ *
+ * Text lines (replies of the serial command interface) share the ring, so
+ * they stay in order with the frames. A line is sent as
+ *   text "\r\n" 0x00
+ * which a terminal shows as plain text, while a frame decoder sees one more
+ * delimited chunk that is not a valid frame and passes it through as text.
+ *
+ * The ring is not interrupt safe: queue frames from the main loop only.
+ */
+
+constexpr uint8_t SERIAL_TX_RING_SIZE = 128;      // Power of two, at most 128
+constexpr uint8_t SERIAL_FRAME_MAX_PAYLOAD = 32;  // Largest payload of one frame
+
+/**
+ * @brief First byte of every frame, telling the host decoder how to read the payload.
+ */
+enum class FrameType : uint8_t {
+    LOG = 0x01,     // Tokenized debug record (see TokenLog.h)
+    DROPPED = 0x02,   // uint16 LE: frames dropped since the last frame that got through
+    TELEMETRY = 0x03  // Periodic state sample (see Telemetry.h)
+};
+
+bool queueSerialFrame(FrameType type, const uint8_t* payload, uint8_t length);
+bool queueSerialText(const char* text);
+bool serialFrameFits(uint8_t length);
+bool serialTextFits(uint8_t length);
+void flushSerialOutput();
+uint16_t droppedSerialFrames();
+
+#endif // SERIAL_OUTPUT_H
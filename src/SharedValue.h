@@ -0,0 +1,129 @@
+/*
+ * File: SharedValue.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:06:53 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:32:20 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#ifndef SHARED_VALUE_H
+#define SHARED_VALUE_H
+
+#include <Arduino.h>
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+// One core: keeping the compiler from caching or reordering memory accesses is enough.
+#define SHARED_VALUE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * @brief Masks interrupts for its lifetime and restores the previous state (nesting safe).
+ */
+class InterruptGuard {
+public:
+    InterruptGuard() : sreg(SREG) { cli(); }
+    ~InterruptGuard() { SREG = sreg; }
+private:
+    uint8_t sreg;
+};
+#else
+// Host builds run simulated interrupts on other threads: use a full fence.
+#define SHARED_VALUE_BARRIER() __sync_synchronize()
+
+/**
+ * @brief Host stand-in: holds the simulated interrupt lock (see hal/Arduino.h).
+ */
+class InterruptGuard {
+public:
+    InterruptGuard() { noInterrupts(); }
+    ~InterruptGuard() { interrupts(); }
+};
+#endif
+
+/**
+ * @brief A multi-byte value shared between interrupt handlers and the main loop.
+ *
+ * On the 8-bit AVR a 32-bit access takes four instructions, so an interrupt
+ * can observe (or produce) a half-written value. SharedValue guards the copy
+ * with a sequence counter that is odd while a write is in progress:
+ *
+ * - read() copies the value and retries if the counter was odd or changed
+ *   meanwhile. It never masks interrupts and is safe in any context.
+ * - writeFromISR() is for interrupt handlers, which run with interrupts masked.
+ * - write() is for the main loop. It masks interrupts only for the few
+ *   instructions of the copy, so an interrupt handler reading the value
+ *   never has to wait for a write it has interrupted.
+ *
+ * Each value must have a single writing context. A value the main loop
+ * resets while its interrupt handler is switched off (interrupt source
+ * masked, and any flag the handler checks cleared first) is the one
+ * exception: the handler cannot run during or around that write().
+ *
+ * @tparam T A trivially copyable type (integers, small structs).
+ */
+template <typename T>
+class SharedValue {
+public:
+    SharedValue() : sequence(0), value() {}
+    SharedValue(const T& initial) : sequence(0), value(initial) {}
+
+    /** @brief Consistent snapshot of the value. */
+    T read() const {
+        uint8_t before;
+        T copy;
+        do {
+            before = sequence;
+            SHARED_VALUE_BARRIER();
+            copy = value;
+            SHARED_VALUE_BARRIER();
+        } while ((before & 1) || before != sequence);
+        return copy;
+    }
+
+    /** @brief Stores a value from the main loop (interrupts masked during the copy). */
+    void write(const T& newValue) {
+        InterruptGuard guard;
+        writeFromISR(newValue);
+    }
+
+    /** @brief Stores a value from an interrupt handler. */
+    void writeFromISR(const T& newValue) {
+        sequence = sequence + 1;
+        SHARED_VALUE_BARRIER();
+        value = newValue;
+        SHARED_VALUE_BARRIER();
+        sequence = sequence + 1;
+    }
+
+    operator T() const { return read(); }
+    SharedValue& operator=(const T& newValue) {
+        write(newValue);
+        return *this;
+    }
+
+private:
+    SharedValue(const SharedValue&);
+    SharedValue& operator=(const SharedValue&);
+
+    volatile uint8_t sequence;
+    T value;
+};
+
+#endif // SHARED_VALUE_H
@@ -0,0 +1,122 @@
+/*
+ * File: Telemetry.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:32:47 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 10:03:11 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#include "Telemetry.h"
+#include "constants.h"
+#include "LampControl.h"
+#include "SerialOutput.h"
+#include "TimerStateMachine.h"
+
+namespace {
+    constexpr uint8_t TELEMETRY_PAYLOAD_SIZE = 25;
+
+    uint16_t period = 0;              // Milliseconds between samples, 0 = off
+    uint16_t sequence = 0;
+    unsigned long lastSample = 0;     // millis() of the last sample
+    unsigned long lastPass = 0;       // micros() of the previous loop() pass
+    uint16_t loopMax = 0;
+    uint16_t loopCount = 0;
+
+    /** @brief Little-endian field writer over the sample payload. */
+    struct Packer {
+        uint8_t* out;
+        void put8(uint8_t value) { *out++ = value; }
+        void put16(uint16_t value) { put8(value); put8(value >> 8); }
+        void put32(uint32_t value) { put16(value); put16(value >> 16); }
+    };
+
+    void sendSample(unsigned long now) {
+        uint8_t payload[TELEMETRY_PAYLOAD_SIZE];
+        Packer packer = {payload};
+        uint8_t flags = (RelayPin::read() ? 0x01 : 0) | (ManualLightPin::read() ? 0x02 : 0) | (EEPROM_FAILED ? 0x04 : 0);
+
+        packer.put16(sequence++);
+        packer.put32(now);
+        packer.put8(static_cast<uint8_t>(getTimerState()));
+        packer.put8(flags);
+        packer.put32(remainingExposureMicros());
+        packer.put32(static_cast<uint32_t>(timerDelay));
+        packer.put16(loopMax);
+        packer.put16(loopCount);
+        packer.put8(static_cast<uint8_t>(badBlocksCount));
+        packer.put16(static_cast<uint16_t>(eeAddress));
+        packer.put16(droppedSerialFrames());
+        if (serialFrameFits(TELEMETRY_PAYLOAD_SIZE)) {
+            queueSerialFrame(FrameType::TELEMETRY, payload, TELEMETRY_PAYLOAD_SIZE);
+        }
+        loopMax = 0;
+        loopCount = 0;
+    }
+}
+
+/**
+ * @brief Starts, retunes or stops the telemetry stream.
+ *
+ * @param periodMillis Time between samples; 0 stops the stream, shorter
+ *        periods than TELEMETRY_MIN_PERIOD_MS are raised to it.
+ */
+void setTelemetryPeriod(uint16_t periodMillis) {
+    period = (periodMillis == 0 || periodMillis >= TELEMETRY_MIN_PERIOD_MS) ? periodMillis : TELEMETRY_MIN_PERIOD_MS;
+    lastSample = millis();
+    loopMax = 0;
+    loopCount = 0;
+}
+
+/**
+ * @brief Time between samples in milliseconds, 0 when the stream is off.
+ */
+uint16_t getTelemetryPeriod() {
+    return period;
+}
+
+/**
+ * @brief Measures the loop latency and queues a sample when one is due.
+ *
+ * Call once per loop() pass.
+ */
+void tickTelemetry() {
+    unsigned long passStart = micros();
+    unsigned long pass = passStart - lastPass;
+    lastPass = passStart;
+    if (period == 0) {
+        return;
+    }
+    // Both saturate on their own, so a slow pass late in a long period still counts
+    if (loopCount < 0xFFFF) {
+        ++loopCount;
+    }
+    if (pass > loopMax) {
+        loopMax = pass < 0xFFFF ? pass : 0xFFFF;
+    }
+    unsigned long now = millis();
+    if (now - lastSample >= period) {
+        lastSample += period;
+        if (now - lastSample >= period) {
+            lastSample = now; // fell behind (e.g. an EEPROM commit), do not burst to catch up
+        }
+        sendSample(now);
+    }
+}
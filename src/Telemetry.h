@@ -0,0 +1,63 @@
+/*
+ * File: Telemetry.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:32:47 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:32:47 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+/*
+ * Telemetry stream for bench logging.
+ *
+ * While enabled, a FrameType::TELEMETRY frame (see SerialOutput.h) is queued
+ * every period with the timer state, the relay, the remaining exposure, the
+ * loop latency and the EEPROM health. All fields are little endian:
+ *
+ *   uint16 sequence       incremented for every sample, sent or skipped
+ *   uint32 millis         time of the sample
+ *   uint8  state          TimerState
+ *   uint8  flags          bit 0 relay on, bit 1 manual light on, bit 2 EEPROM failed
+ *   uint32 remaining_us   exposure time left (0 when no exposure is active)
+ *   int32  delay_ms       timerDelay (the countdown while exposing)
+ *   uint16 loop_max_us    longest loop() pass since the previous sample (saturates)
+ *   uint16 loops          loop() passes since the previous sample (saturates)
+ *   uint8  ee_bad         retired EEPROM wear leveling slots
+ *   uint16 ee_address     EEPROM address of the stored timer delay
+ *   uint16 tx_dropped     serial frames dropped since boot
+ *
+ * A sample is only queued when the whole frame fits in the transmit ring;
+ * otherwise it is skipped, so telemetry never pushes out log records or
+ * replies, and the host sees the gap in the sequence numbers.
+ * tools/telemetry_to_csv.py converts the stream to CSV.
+ */
+
+constexpr uint16_t TELEMETRY_MIN_PERIOD_MS = 20;   // 50 Hz, about a third of the 115200 baud link
+
+void setTelemetryPeriod(uint16_t periodMillis);
+uint16_t getTelemetryPeriod();
+void tickTelemetry();
+
+#endif // TELEMETRY_H
@@ -0,0 +1,402 @@
+/*
+ * File: TimerStateMachine.cpp
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:04:55 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:47:58 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#include "TimerStateMachine.h"
+#include "constants.h"
+#include "ClockCalibration.h"
+#include "ExposureHistory.h"
+#include "LampControl.h"
+#include "LCDHandler.h"
+#include "LightMeter.h"
+#include "MemoryUtils.h"
+#include "OutputScheduler.h"
+#include "PresetStore.h"
+
+namespace {
+    constexpr uint8_t STATE_COUNT = static_cast<uint8_t>(TimerState::COUNT);
+    constexpr uint8_t EVENT_COUNT = static_cast<uint8_t>(TimerEvent::COUNT);
+    constexpr uint8_t NO_TRANSITION = 0xFF;
+
+    constexpr uint8_t to(TimerState state) { return static_cast<uint8_t>(state); }
+
+    /**
+     * @brief Next state for every (state, event) pair; NO_TRANSITION ignores the event.
+     */
+    const uint8_t TRANSITIONS[STATE_COUNT][EVENT_COUNT] PROGMEM = {
+        //                 START                 HOLD                     ABORT           LAMP_READY           EXPIRED         FAILURE          ACKNOWLEDGE      BROWSE          METER
+        /* IDLE */         {to(TimerState::ARMED), to(TimerState::MANUAL_FOCUS), NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, to(TimerState::FAULT), NO_TRANSITION, to(TimerState::HISTORY), NO_TRANSITION},
+        /* ARMED */        {NO_TRANSITION, NO_TRANSITION, to(TimerState::IDLE), to(TimerState::EXPOSING), NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION},
+        /* EXPOSING */     {to(TimerState::PAUSED), NO_TRANSITION, to(TimerState::IDLE), NO_TRANSITION, to(TimerState::IDLE), NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION},
+        /* PAUSED */       {to(TimerState::EXPOSING), NO_TRANSITION, to(TimerState::IDLE), NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION},
+        /* MANUAL_FOCUS */ {to(TimerState::IDLE), to(TimerState::IDLE), to(TimerState::IDLE), NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, to(TimerState::METER)},
+        /* FAULT */        {NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, to(TimerState::IDLE), NO_TRANSITION, NO_TRANSITION},
+        /* HISTORY */      {to(TimerState::IDLE), NO_TRANSITION, to(TimerState::IDLE), NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, to(TimerState::IDLE), to(TimerState::IDLE), NO_TRANSITION},
+        /* METER */        {to(TimerState::IDLE), to(TimerState::IDLE), to(TimerState::IDLE), NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION, NO_TRANSITION},
+    };
+
+    TimerState currentState = TimerState::IDLE;
+    // Exposure times below are in micros() counts of this board; ClockCalibration.h
+    // converts them from and to real time.
+    unsigned long remainingMicros = 0; // Exposure time left while armed or paused
+    bool faultAcknowledged = false;    // The EEPROM failure is shown only once
+    unsigned long lampOnSince = 0;     // micros() of the last relay-on edge of an exposure
+    unsigned long lampMicros = 0;      // Relay-on time of the exposure so far (exposure history)
+    bool exposureExpired = false;      // The exposure ran to its deadline
+    bool exposureDose = false;         // The exposure integrates the light (see LightMeter.h)
+    long compensationMicros = 0;       // Relay time added for the lamp's warm-up and afterglow (LampModel.h)
+    unsigned long armedAt = 0;         // millis() of the ARMED entry (safelight lead)
+
+    /** @brief Exposure time left at now, in microseconds (0 once the deadline has passed). */
+    unsigned long remainingAt(unsigned long now) {
+        long remaining = static_cast<long>(exposureDeadline - now);
+        return (remaining > 0) ? static_cast<unsigned long>(remaining) : 0;
+    }
+
+    /** @brief A signed real time span in micros() counts of this board. */
+    long clockDelta(long trueMicros) {
+        long magnitude = static_cast<long>(toClockMicros(static_cast<unsigned long>(trueMicros < 0 ? -trueMicros : trueMicros)));
+        return (trueMicros < 0) ? -magnitude : magnitude;
+    }
+
+    /** @brief Remaining relay time less the lamp compensation still in it: the exposure time left. */
+    unsigned long withoutCompensation(unsigned long remaining) {
+        long left = static_cast<long>(remaining) - compensationMicros;
+        return (left > 0) ? static_cast<unsigned long>(left) : 0;
+    }
+
+    /** @brief Shows the remaining exposure, rounded up to the 0.1 s display resolution. */
+    void showRemaining(unsigned long remaining) {
+        if (exposureDose) {
+            remaining = remainingDoseMicros(); // the deadline is only the safety limit
+        }
+        remaining = toTrueMicros(withoutCompensation(remaining));
+        timerDelay = static_cast<long>((remaining + TimerConfig::DURATION - 1) / TimerConfig::DURATION) * TimerConfig::INCREMENT;
+    }
+
+    // --- Entry actions ---
+
+    void enterIdle(TimerState from) {
+        if (from == TimerState::FAULT) {
+            faultAcknowledged = true;
+            redrawTimerScreen();
+            return;
+        }
+        if (from == TimerState::HISTORY) {
+            redrawTimerScreen();
+            return;
+        }
+        turnEnlargerLampOff();
+        if (from == TimerState::METER) {
+            stopLightMeter();
+            switchOutputs(SAFELIGHT_OUTPUT, 0);
+            long suggestedDelay;
+            uint8_t grade;
+            if (meterSuggestion(suggestedDelay, grade)) {
+                timerDelay = suggestedDelay; // the metered exposure becomes the next one
+            }
+            redrawTimerScreen();
+            return;
+        }
+        if (exposureDose) {
+            disarmDose();
+            exposureDose = false;
+        }
+        if (from == TimerState::EXPOSING && !exposureExpired) {
+            lampMicros += micros() - lampOnSince; // aborted with the relay on
+        }
+        if (from == TimerState::ARMED || from == TimerState::EXPOSING || from == TimerState::PAUSED) {
+            recordExposureEnd(toTrueMicros(lampMicros), !exposureExpired);
+            if (exposureExpired) {
+                switchOutputs(BUZZER_OUTPUT, 0);
+                scheduleOutputs(BUZZER_BEEP_MS, 0, BUZZER_OUTPUT);
+            }
+            scheduleOutputs(SAFELIGHT_LAG_MS, SAFELIGHT_OUTPUT, 0); // the paper is done with first
+        }
+    }
+
+    void enterArmed(TimerState) {
+        storeTimerDelay(millis());
+        updateActivePresetDelay(timerDelay);
+        unsigned long requested = static_cast<unsigned long>(timerDelay) * 1000UL;
+        remainingMicros = toClockMicros(requested);
+        lampMicros = 0;
+        exposureExpired = false;
+        compensationMicros = 0;
+        exposureDose = isDoseMode();
+        if (exposureDose) {
+            // The sensor sees the warm-up: no lamp compensation
+            armDose(remainingMicros);
+            long limit = min(timerDelay * DOSE_TIME_LIMIT, TimerConfig::MAX_DELAY);
+            remainingMicros = toClockMicros(static_cast<unsigned long>(limit) * 1000UL);
+        } else {
+            compensationMicros = clockDelta(max(lampCompensationMicros(requested), -static_cast<long>(requested)));
+            remainingMicros += compensationMicros;
+        }
+        recordExposureStart(storedTimerDelay, exposureMode, exposureDose);
+        switchOutputs(FOCUS_LIGHT_OUTPUT, SAFELIGHT_OUTPUT);
+        armedAt = millis(); // the lamp waits SAFELIGHT_LEAD_MS for the safelight to go out
+    }
+
+    void enterExposing(TimerState from) {
+        unsigned long stoppedAt;
+        if (exposureDose && doseReached(stoppedAt)) {
+            lampOnSince = stoppedAt; // reached right before a pause: tickExposing() ends it
+            return;
+        }
+        if (from == TimerState::PAUSED && !exposureDose && remainingMicros > 0) {
+            // The lamp warms up again
+            long restart = max(clockDelta(lampRestartMicros()), -static_cast<long>(remainingMicros));
+            remainingMicros += restart;
+            compensationMicros += restart;
+        }
+        // The deadline is taken right after the relay edge, here and in enterPaused(),
+        // so the relay-on time adds up exactly across any number of pauses.
+        turnEnlargerLampOn();
+        lampOnSince = micros();
+        exposureDeadline = lampOnSince + remainingMicros;
+        if (exposureDose) {
+            integrateDose(true);
+        }
+    }
+
+    void enterPaused(TimerState) {
+        if (exposureDose) {
+            integrateDose(false);
+        }
+        switchOutputs(0, ENLARGER_OUTPUT);
+        unsigned long now = micros();
+        unsigned long stoppedAt;
+        if (exposureDose && doseReached(stoppedAt)) {
+            now = stoppedAt; // the conversion interrupt was first
+        }
+        lampMicros += now - lampOnSince;
+        remainingMicros = remainingAt(now);
+        DEBUG_PRINT("Exposure paused");
+    }
+
+    void enterManualFocus(TimerState) {
+        switchOutputs(ENLARGER_OUTPUT | FOCUS_LIGHT_OUTPUT, 0);
+    }
+
+    void enterFault(TimerState) {
+        displayEEPROMError();
+    }
+
+    void enterHistoryView(TimerState) {
+        openHistoryView();
+    }
+
+    void enterMeter(TimerState) {
+        // The lamp stays on from manual focus: the meter reads the projected image,
+        // without the safelight
+        switchOutputs(0, SAFELIGHT_OUTPUT);
+        startLightMeter();
+        openMeterView();
+    }
+
+    // --- Tick handlers ---
+
+    void tickIdle() {
+        if (EEPROM_FAILED && !faultAcknowledged) {
+            dispatchTimerEvent(TimerEvent::FAILURE);
+            return;
+        }
+        updateTimerDisplay();
+    }
+
+    void tickArmed() {
+        if (millis() - armedAt >= SAFELIGHT_LEAD_MS) {
+            dispatchTimerEvent(TimerEvent::LAMP_READY);
+        }
+    }
+
+    void tickExposing() {
+        unsigned long stoppedAt;
+        if (exposureDose && doseReached(stoppedAt)) {
+            // The conversion interrupt has switched the relay off already
+            lampMicros += stoppedAt - lampOnSince;
+            exposureExpired = true;
+            timerDelay = nextProgramDelay(storedTimerDelay);
+            dispatchTimerEvent(TimerEvent::EXPIRED);
+            updateTimerDisplay();
+            return;
+        }
+        unsigned long remaining = remainingAt(micros());
+        if (remaining == 0 && exposureDose) {
+            // Safety limit: the dose was not reached, record it as aborted
+            DEBUG_PRINT("Dose not reached, lamp off");
+            timerDelay = storedTimerDelay;
+            dispatchTimerEvent(TimerEvent::EXPIRED);
+        } else if (remaining == 0) {
+            switchOutputs(0, ENLARGER_OUTPUT); // first, before any bookkeeping
+            lampMicros += micros() - lampOnSince;
+            exposureExpired = true;
+            timerDelay = nextProgramDelay(storedTimerDelay); // Reset to stored value or the next program step
+            dispatchTimerEvent(TimerEvent::EXPIRED);
+        } else {
+            showRemaining(remaining);
+        }
+        updateTimerDisplay();
+    }
+
+    void tickDisplay() {
+        updateTimerDisplay();
+    }
+
+    void tickFault() {
+        // The error message stays until a button press acknowledges it
+    }
+
+    void tickHistoryView() {
+        if (historyViewExpired()) {
+            dispatchTimerEvent(TimerEvent::BROWSE);
+        }
+    }
+
+    void tickMeter() {
+        refreshMeterView();
+    }
+
+    typedef void (*EnterHandler)(TimerState from);
+    typedef void (*TickHandler)();
+
+    struct StateHandlers {
+        EnterHandler enter;
+        TickHandler tick;
+    };
+
+    /** @brief Entry action and tick handler of every state, in TimerState order. */
+    const StateHandlers HANDLERS[STATE_COUNT] PROGMEM = {
+        {enterIdle, tickIdle},
+        {enterArmed, tickArmed},
+        {enterExposing, tickExposing},
+        {enterPaused, tickDisplay},
+        {enterManualFocus, tickDisplay},
+        {enterFault, tickFault},
+        {enterHistoryView, tickHistoryView},
+        {enterMeter, tickMeter},
+    };
+}
+
+/**
+ * @brief Feeds an event to the timer state machine.
+ *
+ * One table lookup decides the next state; events without a transition in
+ * the current state are ignored. The entry action of the new state runs
+ * before this function returns.
+ *
+ * @param event The event.
+ */
+void dispatchTimerEvent(TimerEvent event) {
+    uint8_t next = pgm_read_byte(&TRANSITIONS[to(currentState)][static_cast<uint8_t>(event)]);
+    if (next == NO_TRANSITION) {
+        return;
+    }
+    TimerState from = currentState;
+    currentState = static_cast<TimerState>(next);
+    DEBUG_PRINTF("Timer state %d -> %d", static_cast<int>(from), next);
+    EnterHandler enter = reinterpret_cast<EnterHandler>(pgm_read_ptr(&HANDLERS[next].enter));
+    enter(from);
+}
+
+/**
+ * @brief Runs the tick handler of the current state. Called once per loop().
+ */
+void tickTimerStateMachine() {
+    TickHandler tick = reinterpret_cast<TickHandler>(pgm_read_ptr(&HANDLERS[to(currentState)].tick));
+    tick();
+}
+
+/**
+ * @brief Returns the current state.
+ */
+TimerState getTimerState() {
+    return currentState;
+}
+
+/**
+ * @brief True while the lamp is on or an exposure is in progress (no EEPROM-heavy work then).
+ */
+bool isLampInUse() {
+    return currentState == TimerState::ARMED || currentState == TimerState::EXPOSING
+        || currentState == TimerState::PAUSED || currentState == TimerState::MANUAL_FOCUS
+        || currentState == TimerState::METER;
+}
+
+/**
+ * @brief True while an exposure is armed, running or paused.
+ */
+bool isExposureActive() {
+    return currentState == TimerState::ARMED || currentState == TimerState::EXPOSING
+        || currentState == TimerState::PAUSED;
+}
+
+/**
+ * @brief Lengthens or shortens an armed, running or paused exposure (burn-in).
+ *
+ * The remaining time stays within 0 .. TimerConfig::MAX_DELAY. Shortening it
+ * to zero ends a running exposure at the next tick. A light-integrating
+ * exposure gets the dose of the change at the reference intensity.
+ *
+ * @param deltaMillis Milliseconds to add (negative to take time off).
+ */
+void extendExposure(long deltaMillis) {
+    if (!isExposureActive()) {
+        return;
+    }
+    bool running = (currentState == TimerState::EXPOSING);
+    unsigned long now = micros();
+    long delta = static_cast<long>(toClockMicros(static_cast<unsigned long>(deltaMillis < 0 ? -deltaMillis : deltaMillis) * 1000UL));
+    if (exposureDose) {
+        adjustDose(deltaMillis < 0 ? -delta : delta);
+        delta *= DOSE_TIME_LIMIT; // the safety limit moves with it
+    }
+    long remaining = static_cast<long>(running ? remainingAt(now) : remainingMicros) + (deltaMillis < 0 ? -delta : delta);
+    remaining = constrain(remaining, 0L, static_cast<long>(toClockMicros(TimerConfig::MAX_DELAY * 1000UL)));
+    if (running) {
+        exposureDeadline = now + remaining;
+    } else {
+        remainingMicros = remaining;
+    }
+    showRemaining(remaining);
+    DEBUG_PRINTF("Exposure adjusted by %ld ms", deltaMillis);
+}
+
+/**
+ * @brief Exposure time left, in real microseconds: counting down while exposing, frozen while armed or paused.
+ *
+ * For a light-integrating exposure this is the dose left, as time at the reference intensity.
+ *
+ * @return The remaining time, or 0 when no exposure is active.
+ */
+unsigned long remainingExposureMicros() {
+    if (exposureDose && isExposureActive()) {
+        return toTrueMicros(remainingDoseMicros());
+    }
+    if (currentState == TimerState::EXPOSING) {
+        return toTrueMicros(withoutCompensation(remainingAt(micros())));
+    }
+    return isExposureActive() ? toTrueMicros(withoutCompensation(remainingMicros)) : 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * File: TimerStateMachine.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:04:04 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 9:00:56 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#ifndef TIMER_STATE_MACHINE_H
+#define TIMER_STATE_MACHINE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief States of the timer. Each state has an entry action and a tick handler.
+ */
+enum class TimerState : uint8_t {
+    IDLE,          // Lamp off, encoder sets the delay
+    ARMED,         // Exposure requested, relay switches on at the next tick
+    EXPOSING,      // Relay on, counting down to the exposure deadline
+    PAUSED,        // Relay off, remaining exposure time kept
+    MANUAL_FOCUS,  // Lamp on without timer (long press)
+    FAULT,         // EEPROM failure shown until acknowledged
+    HISTORY,       // Exposure history shown on the LCD, encoder scrolls
+    METER,         // Lamp on, easel light meter shown on the LCD
+    COUNT
+};
+
+/**
+ * @brief Events fed to the timer state machine.
+ */
+enum class TimerEvent : uint8_t {
+    START,        // Timer button short press
+    HOLD,         // Timer button long press
+    ABORT,        // Encoder button press while the lamp is in use
+    LAMP_READY,   // Armed exposure may switch the relay on
+    EXPIRED,      // Exposure deadline passed
+    FAILURE,      // EEPROM failure detected
+    ACKNOWLEDGE,  // Any button press in the fault state
+    BROWSE,       // Encoder button long press: opens or closes the exposure history
+    METER,        // Encoder button press in manual focus: meters the easel
+    COUNT
+};
+
+void dispatchTimerEvent(TimerEvent event);
+void tickTimerStateMachine();
+TimerState getTimerState();
+bool isLampInUse();
+bool isExposureActive();
+void extendExposure(long deltaMillis);
+unsigned long remainingExposureMicros();
+
+#endif // TIMER_STATE_MACHINE_H
@@ -0,0 +1,120 @@
+/*
+ * File: TokenLog.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 8:24:04 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 8:24:04 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+
+#ifndef TOKEN_LOG_H
+#define TOKEN_LOG_H
+
+#include <Arduino.h>
+#include "SerialOutput.h"
+
+/*
+ * Tokenized debug log.
+ *
+ * A log record never contains its text. The format string stays in flash
+ * (PSTR), and the record carries only its flash address as a message ID, the
+ * micros() timestamp and the raw arguments:
+ *   [id: uint16 LE][micros: uint32 LE][arg]...
+ * Each argument is four bytes: integers as 32-bit little endian (signedness
+ * comes from the conversion in the format), floating point as an IEEE single.
+ * A string argument is copied with its terminating zero, truncated to
+ * LOG_STRING_ARG_MAX characters. Records are queued as FrameType::LOG frames
+ * on the serial transmit ring (see SerialOutput.h), so logging costs a few
+ * dozen cycles of copying instead of a synchronous snprintf() and print.
+ *
+ * tools/log_decoder.py turns the frames back into text: it looks every ID up
+ * in the .text section of the firmware ELF, where the format strings live, and
+ * formats the arguments on the host. Logging is main-loop only, like the ring.
+ */
+
+constexpr uint8_t LOG_STRING_ARG_MAX = 16;  // Characters of a %s argument that are sent
+
+class LogRecord {
+public:
+    explicit LogRecord(const char* format) : length(0) {
+        putWord(static_cast<uint16_t>(reinterpret_cast<uintptr_t>(format)));
+        put(micros());
+    }
+
+    void put(int value) { put(static_cast<long>(value)); }
+    void put(unsigned int value) { put(static_cast<unsigned long>(value)); }
+    void put(long value) { put(static_cast<unsigned long>(value)); }
+    void put(unsigned long value) {
+        putWord(static_cast<uint16_t>(value));
+        putWord(static_cast<uint16_t>(value >> 16));
+    }
+    void put(double value) {
+        float single = static_cast<float>(value);
+        uint32_t bits;
+        memcpy(&bits, &single, sizeof(bits));
+        put(static_cast<unsigned long>(bits));
+    }
+    void put(const char* text) {
+        for (uint8_t i = 0; i < LOG_STRING_ARG_MAX && text[i] != '\0'; ++i) {
+            putByte(text[i]);
+        }
+        putByte(0);
+    }
+
+    void send() { queueSerialFrame(FrameType::LOG, buffer, length); }
+
+private:
+    void putByte(uint8_t value) {
+        // A record that overflows is sent truncated; the decoder marks the missing arguments
+        if (length < SERIAL_FRAME_MAX_PAYLOAD) {
+            buffer[length++] = value;
+        }
+    }
+    void putWord(uint16_t value) {
+        putByte(static_cast<uint8_t>(value));
+        putByte(static_cast<uint8_t>(value >> 8));
+    }
+
+    uint8_t buffer[SERIAL_FRAME_MAX_PAYLOAD];
+    uint8_t length;
+};
+
+inline void logArguments(LogRecord&) {}
+
+template <typename T, typename... Rest>
+inline void logArguments(LogRecord& record, T value, Rest... rest) {
+    record.put(value);
+    logArguments(record, rest...);
+}
+
+/**
+ * @brief Queues one tokenized log record.
+ *
+ * @param format printf-style format string in program memory (PSTR).
+ * @param args Arguments matching the conversions in format.
+ */
+template <typename... Args>
+void logRecord(const char* format, Args... args) {
+    LogRecord record(format);
+    logArguments(record, args...);
+    record.send();
+}
+
+#endif // TOKEN_LOG_H
@@ -0,0 +1,74 @@
+/*
+ * File: VerticalDebounce.h
+ * Project: Darkroom Enlarger Timer
+ * File Created: Sunday, 18th October 2026 7:56:21 pm
+ * Author: Andrei Grichine (andrei.grichine@gmail.com)
+ * -----
+ * Last Modified: Sunday, 18th October 2026 7:56:21 pm
+ * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+ * -----
+ * Copyright: 2019 - 2025. Prime73 Inc.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----
+ * HISTORY:
+ */
+
+
+#ifndef VERTICAL_DEBOUNCE_H
+#define VERTICAL_DEBOUNCE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Debounce state for up to eight inputs of one port.
+ *
+ * Every input has a 2-bit counter, stored "vertically": bit n of count0 and
+ * count1 together form the counter of input n. All eight inputs are therefore
+ * debounced with the same few byte operations, and an extra input costs no
+ * extra RAM or time.
+ *
+ * @var state Debounced inputs, bit set = active (pressed).
+ * @var count0 Low bits of the per-input counters.
+ * @var count1 High bits of the per-input counters.
+ */
+struct VerticalDebouncer {
+    uint8_t state = 0;
+    uint8_t count0 = 0xFF;
+    uint8_t count1 = 0xFF;
+};
+
+/** @brief Consecutive samples an input must differ from its debounced state before it changes. */
+constexpr uint8_t VERTICAL_DEBOUNCE_SAMPLES = 4;
+
+/**
+ * @brief Feeds one port sample to the vertical counters.
+ *
+ * Inputs that differ from their debounced state count down; an input that
+ * matches its debounced state has its counter reset. When a counter rolls over
+ * after VERTICAL_DEBOUNCE_SAMPLES samples the debounced state toggles.
+ * Cheap enough to run from a timer interrupt.
+ *
+ * @param debouncer The debounce state to update.
+ * @param sample Current inputs, bit set = active (invert active-low pins first).
+ * @return Mask of inputs whose debounced state changed with this sample.
+ *         `changed & debouncer.state` are presses, `changed & ~debouncer.state` releases.
+ */
+inline uint8_t debounceSample(VerticalDebouncer& debouncer, uint8_t sample) {
+    uint8_t changed = debouncer.state ^ sample;
+    debouncer.count0 = ~(debouncer.count0 & changed);
+    debouncer.count1 = debouncer.count0 ^ (debouncer.count1 & changed);
+    changed &= debouncer.count0 & debouncer.count1;
+    debouncer.state ^= changed;
+    return changed;
+}
+
+#endif // VERTICAL_DEBOUNCE_H
@@ -4,7 +4,7 @@
  * File Created: Tuesday, 18th February 2025 6:37:15 am
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Wednesday, 26th February 2025 10:28:02 pm
+ * Last Modified: Sunday, 18th October 2026 9:47:58 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -34,8 +34,8 @@
 
 /** @brief LCD instance (initialized with I2C address and pin assignments). */
 LiquidCrystal_I2C lcd(I2C_ADDRESS, EN_PIN, RW_PIN, RS_PIN, D4_PIN, D5_PIN, D6_PIN, D7_PIN, BACK_PIN, POSITIVE);
-/** @brief Global time (initialized to 0). */
-unsigned long globalTime = 0;
+/** @brief micros() at which the running exposure ends (set when the relay switches on). */
+unsigned long exposureDeadline = 0;
 /** @brief Current timer delay (initialized to 0). */
 long timerDelay = 0;
 /** @brief Last stored timer delay (initialized to 0). */
@@ -44,15 +44,11 @@ long storedTimerDelay = 0;
 unsigned long lastEEPROMWrite = 0;
 /** @brief EEPROM address to store timer delay (initialized to 0). */
 int eeAddress = 0;
-/** @brief Flag to start the exposure timer (initialized to false). */
-volatile bool startExposure = false;
-/** @brief Flag to turn on the enlarger lamp (initialized to false). */
-volatile bool turnOnEnlargerLamp = false;
-/** @brief Flag to turn on the enlarger lamp manually (initialized to false). */
-volatile bool turnManuallyOnEnlargerLamp = false;
+/** @brief Exposure mode of the current timer setting (initialized to linear seconds). */
+ExposureMode exposureMode = ExposureMode::LINEAR;
 /** @brief Index to track the current EEPROM address (initialized to 0). */
 int currentEEPROMAddressIndex = 0;
-/** @brief Counter for bad EEPROM blocks (initialized to 0). */
+/** @brief Number of retired (bad) EEPROM wear leveling slots (restored from the bad-block bitmap at boot). */
 int badBlocksCount = 0;
 /** @brief Flag indicating an EEPROM failure (initialized to false). */
 bool EEPROM_FAILED = false;
@@ -4,7 +4,7 @@
 * File Created: Wednesday, 26th February 2025 8:32:50 pm
 * Author: Andrei Grichine (andrei.grichine@gmail.com)
 * -----
-* Last Modified: Wednesday, 26th February 2025 10:23:11 pm
+* Last Modified: Sunday, 18th October 2026 9:47:58 pm
 * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
 * -----
 * Copyright: 2019 - 2025. Prime73 Inc.
@@ -54,6 +54,16 @@ namespace TimerConfig {
     constexpr unsigned long EEPROM_WRITE_DELAY = 5000;
 }
 
+/**
+ * @brief Exposure modes. Stored with every preset, so values must never be renumbered.
+ */
+enum class ExposureMode : uint8_t {
+    /** @brief Plain seconds, adjusted in TimerConfig::INCREMENT steps. */
+    LINEAR = 0,
+    /** @brief F-stop printing: the encoder scales the time in fractions of a stop. */
+    FSTOP = 1,
+};
+
 /**
  * @namespace LCDLayout4x20
  * @brief Configuration parameters for a 4x20 LCD display.
@@ -89,6 +99,10 @@ namespace LCDLayout4x20
     constexpr uint8_t LAST_DELAY_ROW = LCD_ROW_THREE;
     /** @brief Column for the last delay text. */
     constexpr uint8_t LAST_DELAY_COL = 3;
+    /** @brief Row for the active preset name. */
+    constexpr uint8_t PRESET_NAME_ROW = LCD_ROW_ONE;
+    /** @brief Column for the active preset name (right of the big digits). */
+    constexpr uint8_t PRESET_NAME_COL = 16;
 }
 
 /** @brief Pin number for LCD RS (Register Select) pin. */
@@ -115,14 +129,41 @@ constexpr uint8_t I2C_ADDRESS = 0x27;
  */
 /** @brief A default value we use to initialize EEPROM, should be outside of our normal range to know if we've initialized the address */
 constexpr uint8_t EEPROM_INIT_VALUE = -1;
-/** @brief Location of the address tracker address */
-constexpr int ADDRESS_TRACKER_ADDRESS = 4;
-/** @brief Start address for wear leveling (leave some space for other data) */
-constexpr int EEPROM_START_ADDRESS = 10;
+/** @brief Location of the bad-block bitmap (one bit per wear leveling slot: 1 = usable, 0 = retired). */
+constexpr int BAD_BLOCK_MAP_ADDRESS = 10;
 /** @brief Total EEPROM size in bytes (adjust for your Arduino). 1024 bytes on the ATmega328P, 512 bytes on the ATmega168 and ATmega8, 4 KB (4096 bytes) on the ATmega1280 and ATmega2560 */
-constexpr int EEPROM_END_ADDRESS = 1014;
-/** @brief Maximum allowed bad blocks before warning. */
-constexpr int MAX_BAD_BLOCKS = 5;
+constexpr int EEPROM_SIZE = 1024;
+/** @brief Bytes reserved at the top of EEPROM for the preset profile store (two shadow slots, see PresetStore.cpp). */
+constexpr int PRESET_STORE_SIZE = 176;
+/** @brief Location of the preset profile store. */
+constexpr int PRESET_STORE_ADDRESS = EEPROM_SIZE - PRESET_STORE_SIZE;
+/** @brief Bytes reserved below the preset store for the exposure history log (see ExposureHistory.cpp). */
+constexpr int HISTORY_LOG_SIZE = 256;
+/** @brief Location of the exposure history log. */
+constexpr int HISTORY_LOG_ADDRESS = PRESET_STORE_ADDRESS - HISTORY_LOG_SIZE;
+/** @brief Start address for wear leveling (leave some space for other data) */
+constexpr int EEPROM_START_ADDRESS = 48;
+/** @brief End address (exclusive) of the wear leveling area. */
+constexpr int EEPROM_END_ADDRESS = HISTORY_LOG_ADDRESS;
+/** @brief Size of a single wear leveling slot. The timer delay is always persisted as a 32-bit value. */
+constexpr int EEPROM_SLOT_SIZE = sizeof(int32_t);
+/** @brief Number of wear leveling slots between EEPROM_START_ADDRESS and EEPROM_END_ADDRESS. */
+constexpr int EEPROM_SLOT_COUNT = (EEPROM_END_ADDRESS - EEPROM_START_ADDRESS) / EEPROM_SLOT_SIZE;
+/** @brief Size of the bad-block bitmap in bytes. */
+constexpr int BAD_BLOCK_MAP_SIZE = (EEPROM_SLOT_COUNT + 7) / 8;
+/** @brief Location of the bitmap's format marker, right after the bitmap. */
+constexpr int BAD_BLOCK_MAP_MARKER_ADDRESS = BAD_BLOCK_MAP_ADDRESS + BAD_BLOCK_MAP_SIZE;
+/**
+ * @brief Format marker of the bad-block bitmap.
+ *
+ * Older firmware kept the wear leveling ring where the bitmap is now. Its
+ * marker byte is the top byte of a stored delay (0x00) or erased (0xFF), never
+ * this value, so an upgraded board does not take old delays for retired slots.
+ */
+constexpr uint8_t BAD_BLOCK_MAP_MARKER = 0xB1;
+static_assert(BAD_BLOCK_MAP_MARKER_ADDRESS < EEPROM_START_ADDRESS, "Bad-block bitmap overlaps the wear leveling area");
+/** @brief Percentage of retired wear leveling slots at which the EEPROM is reported as failed. */
+constexpr uint8_t MAX_BAD_BLOCK_PERCENT = 10;
 
 /**
  * @namespace SplashScreen
@@ -142,8 +183,8 @@ extern const uint8_t REVISION_NUMBER PROGMEM;
 
 /** @brief LCD instance (defined in constants.cpp). */
 extern LiquidCrystal_I2C lcd;
-/** @brief Global time (defined in constants.cpp). */
-extern unsigned long globalTime;
+/** @brief micros() at which the running exposure ends (defined in constants.cpp). */
+extern unsigned long exposureDeadline;
 /** @brief Current timer delay (defined in constants.cpp). */
 extern long timerDelay;
 /** @brief Last stored timer delay (defined in constants.cpp). */
@@ -152,15 +193,11 @@ extern long storedTimerDelay;
 extern unsigned long lastEEPROMWrite;
 /** @brief EEPROM address to store timer delay (defined in constants.cpp). */
 extern int eeAddress;
-/** @brief Flag to start the exposure timer (defined in constants.cpp). */
-extern volatile bool startExposure;
-/** @brief Flag to turn on the enlarger lamp (defined in constants.cpp). */
-extern volatile bool turnOnEnlargerLamp;
-/** @brief Flag to turn on the enlarger lamp manually (defined in constants.cpp). */
-extern volatile bool turnManuallyOnEnlargerLamp;
+/** @brief Exposure mode of the current timer setting (defined in constants.cpp). */
+extern ExposureMode exposureMode;
 /** @brief Index to track the current EEPROM address (defined in constants.cpp). */
 extern int currentEEPROMAddressIndex;
-/** @brief Counter for bad EEPROM blocks (defined in constants.cpp). */
+/** @brief Number of retired (bad) EEPROM wear leveling slots (defined in constants.cpp). */
 extern int badBlocksCount;
 /** @brief Flag indicating an EEPROM failure (defined in constants.cpp). */
 extern bool EEPROM_FAILED;
@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Monday, 24th February 2025 2:35:35 pm
+ * Last Modified: Sunday, 18th October 2026 9:47:58 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -24,8 +24,12 @@
 
 #include "encoderHandler.h"
 #include "constants.h"
+#include "EncoderAcceleration.h"
+#include "ExposureHistory.h"
+#include "TimerStateMachine.h"
 
 MD_REncoder rotaryEncoder(ROTARY_ENCODER_PIN_A, ROTARY_ENCODER_PIN_B);
+static EncoderAccelerator encoderAccelerator;
 
 /**
  * Initializes the rotary encoder hardware.
@@ -42,33 +46,34 @@ void initializeEncoder() {
  * @brief Reads the rotary encoder input and adjusts the timer delay based on the rotation direction and speed.
  * 
  * The function reads the direction of the rotary encoder and modifies the timer delay accordingly.
- * If speed adjustment is enabled and the encoder speed exceeds a predefined limit, the increment
- * value is adjusted proportionally. The timer delay is decreased when the encoder is rotated
- * counterclockwise and increased when rotated clockwise, within the bounds of the maximum delay.
+ * The size of each step comes from the acceleration table of the current exposure mode, indexed
+ * by the detent rate: slow turns give fine steps, fast sweeps coarse ones. The timer delay is
+ * decreased when the encoder is rotated counterclockwise and increased when rotated clockwise,
+ * within the bounds of the maximum delay. During an exposure (running or paused) the encoder
+ * extends or shortens the exposure instead, see extendExposure(). While the exposure history
+ * is shown, it scrolls the history: counterclockwise to older exposures. The light meter ignores it.
  * Debug information is printed to indicate the direction and current timer delay.
  */
 void handleEncoderInput() {
     uint8_t direction = rotaryEncoder.read();
-    if (!direction) return;
+    if (direction != DIR_CW && direction != DIR_CCW) return;
 
-    uint32_t tempIncrement = TimerConfig::INCREMENT;
-
-    // Adjust increment based on speed if enabled
-    if (ENABLE_SPEED && rotaryEncoder.speed() > ROTARY_ENCODER_SPEED_LIMIT) {
-        tempIncrement *= rotaryEncoder.speed();
+    bool increase = (direction == DIR_CW);
+    if (getTimerState() == TimerState::HISTORY) {
+        scrollHistoryView(!increase);
+        return;
     }
-
-    // Handle direction-specific logic
-    if (direction == DIR_CCW) {
-        // Decrease timer delay when moving counterclockwise
-        timerDelay = (timerDelay > tempIncrement) ? (timerDelay - tempIncrement) : 0;
-        DEBUG_PRINT("CCW ");
-    } else if (direction == DIR_CW) {
-        // Increase timer delay when moving clockwise
-        timerDelay = (timerDelay + tempIncrement < TimerConfig::MAX_DELAY) ? (timerDelay + tempIncrement) : TimerConfig::MAX_DELAY;
-        DEBUG_PRINT("CW ");
-        
+    if (getTimerState() == TimerState::METER) {
+        return; // leaving the meter sets the delay
     }
-    DEBUG_PRINTF("timerDelay: %d",timerDelay);
+    if (isExposureActive()) {
+        // Burn-in: add or take off time in seconds, whatever the exposure mode
+        uint16_t step = accelerationStep(encoderAccelerator, ExposureMode::LINEAR, increase, millis());
+        extendExposure(increase ? step : -static_cast<long>(step));
+        return;
+    }
+    uint16_t step = accelerationStep(encoderAccelerator, exposureMode, increase, millis());
+    timerDelay = applyEncoderStep(timerDelay, exposureMode, increase, step);
+    DEBUG_PRINTF("%s", increase ? "CW" : "CCW");
+    DEBUG_PRINTF("timerDelay: %ld", timerDelay);
 }
-
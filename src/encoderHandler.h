@@ -4,7 +4,7 @@
  * File Created: Monday, 17th February 2025 12:58:56 pm
  * Author: Andrei Grichine (andrei.grichine@gmail.com)
  * -----
- * Last Modified: Tuesday, 18th February 2025 12:27:07 am
+ * Last Modified: Sunday, 18th October 2026 7:55:29 pm
  * Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
  * -----
  * Copyright: 2019 - 2025. Prime73 Inc.
@@ -28,24 +28,20 @@
 #include <MD_REncoder.h>
 
 /**
- * @brief Configures the rotary encoder pins and speed limit.
+ * @brief Configures the rotary encoder pins.
  * 
- * Defines the pins used for the rotary encoder and sets a speed limit
- * to control sensitivity. The speed limit is used to adjust the increment
- * value based on the current speed to prevent excessive sensitivity when
- * setting the timer delay.
+ * Defines the pins used for the rotary encoder. The adjustment per detent
+ * follows the acceleration curve of the current exposure mode, see
+ * EncoderAcceleration.h.
  * 
  * @define ROTARY_ENCODER_PIN_A Pin number for the left pin (A) of the rotary encoder.
  * @define ROTARY_ENCODER_PIN_B Pin number for the right pin (B) of the rotary encoder.
- * @define ROTARY_ENCODER_SPEED_LIMIT Speed threshold for adjusting the increment value.
  * 
  * @extern MD_REncoder rotaryEncoder An external instance of the MD_REncoder class.
  */
 constexpr uint8_t ROTARY_ENCODER_PIN_A = 3; // left pin (A)
 constexpr uint8_t ROTARY_ENCODER_PIN_B = 2; // right pin (B)
 
-constexpr uint8_t ROTARY_ENCODER_SPEED_LIMIT = 2; // the rotary encoder speed threshold above which the increment value is multiplied by the current speed value. This is to avoid the encoder to be too sensitive when setting the timer delay.
-
 extern MD_REncoder rotaryEncoder;
 
 void initializeEncoder();
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+
+# File: fit_lamp_model.py
+# Project: Darkroom Enlarger Timer
+# File Created: Sunday, 18th October 2026 9:07:52 pm
+# Author: Andrei Grichine (andrei.grichine@gmail.com)
+# -----
+# Last Modified: Sunday, 18th October 2026 9:34:18 pm
+# Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+# -----
+# Copyright: 2019 - 2025. Prime73 Inc.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+# -----
+# HISTORY:
+
+
+
+
+"""Fits the warm-up and afterglow of an enlarger lamp and writes src/LampModel.h.
+
+A tungsten or halogen filament needs some 100 ms to reach full output after
+the relay closes and still glows after it opens. The model is first order:
+the output rises as 1 - exp(-t / tau_on) while the relay is on and decays
+with tau_off after it opens, so T ms of relay time give
+
+    E(T) = T - tau_on (1 - exp(-T / tau_on)) + tau_off (1 - exp(-T / tau_on))
+
+ms of light at full output. The header holds, for a set of requested times
+R, the relay time T(R) - R to add so that E(T) = R, in 1/16 ms; the firmware
+interpolates between the points (see lampCompensationMicros() in
+src/LampControl.cpp).
+
+Fit the model to measurements: expose an integrating light meter for a few
+relay times, short ones especially, and express each reading as ms at full
+output (reading / reading of a long exposure x its time). One "on_ms,dose_ms"
+pair per line, '#' comments allowed:
+
+    fit_lamp_model.py --measurements lamp.csv > ../src/LampModel.h
+
+Or give the time constants directly (--tau-on, --tau-off), or --none for a
+lamp that needs no compensation, such as an LED head.
+"""
+
+import argparse
+import datetime
+import math
+import os
+import sys
+
+# Requested times (ms) the table is computed for; dense where the lamp is still warming up
+POINTS_MS = [0, 20, 50, 100, 150, 200, 300, 500, 750, 1000, 2000]
+Q = 16   # table entries are in 1/Q ms
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def dose(on_ms, tau_on, tau_off):
+    """Light of on_ms of relay time, in ms at full output."""
+    if tau_on <= 0:
+        return on_ms + (tau_off if on_ms > 0 else 0.0)
+    risen = 1.0 - math.exp(-on_ms / tau_on)
+    return on_ms - tau_on * risen + tau_off * risen
+
+
+def relay_time(requested_ms, tau_on, tau_off):
+    """Relay time giving requested_ms of light at full output (bisection, E is increasing)."""
+    if requested_ms <= 0:
+        return 0.0
+    low, high = 0.0, requested_ms + tau_on + 1.0
+    for _ in range(60):
+        middle = (low + high) / 2
+        if dose(middle, tau_on, tau_off) < requested_ms:
+            low = middle
+        else:
+            high = middle
+    return high
+
+
+def read_measurements(path):
+    pairs = []
+    with open(path) as source:
+        for number, line in enumerate(source, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line or line.startswith("on_ms"):
+                continue
+            try:
+                on_ms, dose_ms = (float(field) for field in line.split(","))
+            except ValueError:
+                sys.exit(f"{path}:{number}: expected on_ms,dose_ms")
+            pairs.append((on_ms, dose_ms))
+    if len(pairs) < 2:
+        sys.exit(f"{path}: at least two measurements are needed")
+    return pairs
+
+
+def fit(pairs):
+    """Least-squares time constants, coarse grid first, then finer around the best."""
+    def error(tau_on, tau_off):
+        return sum((dose(on_ms, tau_on, tau_off) - dose_ms) ** 2 for on_ms, dose_ms in pairs)
+
+    best = (0.0, 0.0)
+    span, step = (1000.0, 500.0), 10.0
+    center = (span[0] / 2, span[1] / 2)
+    for _ in range(4):
+        candidates = []
+        tau_on = max(0.0, center[0] - span[0] / 2)
+        while tau_on <= center[0] + span[0] / 2:
+            tau_off = max(0.0, center[1] - span[1] / 2)
+            while tau_off <= center[1] + span[1] / 2:
+                candidates.append((error(tau_on, tau_off), tau_on, tau_off))
+                tau_off += step
+            tau_on += step
+        _, best_on, best_off = min(candidates)
+        best = center = (best_on, best_off)
+        span, step = (step * 10, step * 10), step / 10   # wide: the valley runs diagonally
+    return best
+
+
+def file_header(name):
+    """The license header every source file starts with, taken from src/MemoryUtils.h."""
+    now = datetime.datetime.now()
+    day = now.day
+    suffix = "th" if 11 <= day % 100 <= 13 else {1: "st", 2: "nd", 3: "rd"}.get(day % 10, "th")
+    stamp = f"{now:%A}, {day}{suffix} {now:%B %Y} {now.hour % 12 or 12}:{now:%M:%S} " + ("am" if now.hour < 12 else "pm")
+    with open(os.path.join(REPO_ROOT, "src", "MemoryUtils.h")) as source:
+        lines = source.read().splitlines()[:24]
+    out = []
+    for line in lines:
+        if line.startswith(" * File: "):
+            line = f" * File: {name}"
+        elif line.startswith(" * File Created: ") or line.startswith(" * Last Modified: "):
+            line = line.split(":", 1)[0] + ": " + stamp
+        out.append(line)
+    return "\n".join(out)
+
+
+def header(tau_on, tau_off, source):
+    rows = []
+    for requested in POINTS_MS:
+        correction = round((relay_time(requested, tau_on, tau_off) - requested) * Q)
+        rows.append(f"    {{{requested}, {correction}}},")
+    return f"""{file_header("LampModel.h")}
+
+// Generated by tools/fit_lamp_model.py from {source}. Do not edit, run the tool again.
+
+#ifndef LAMP_MODEL_H
+#define LAMP_MODEL_H
+
+#include <Arduino.h>
+
+/**
+ * @brief One point of the lamp compensation curve.
+ *
+ * @var requestedMillis Requested exposure time.
+ * @var correction Relay time to add for the lamp's warm-up and afterglow,
+ *      in 1/LAMP_CORRECTION_SCALE ms (negative: to take off).
+ */
+struct LampCompensationPoint {{
+    uint16_t requestedMillis;
+    int16_t correction;
+}};
+
+constexpr int16_t LAMP_CORRECTION_SCALE = {Q};
+
+// Lamp model: warm-up time constant {tau_on:.1f} ms, afterglow time constant {tau_off:.1f} ms.
+
+/**
+ * @brief Compensation by requested time, sorted. Between points it is
+ * interpolated; past the last one it stays at the last value, which is also
+ * what every further switch-on (after a pause) costs.
+ */
+constexpr LampCompensationPoint LAMP_COMPENSATION[] PROGMEM = {{
+{chr(10).join(rows)}
+}};
+
+static_assert(sizeof(LAMP_COMPENSATION) / sizeof(LAMP_COMPENSATION[0]) >= 2, "The compensation curve needs two points");
+
+#endif // LAMP_MODEL_H
+"""
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n", 1)[0])
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument("--measurements", metavar="CSV", help="on_ms,dose_ms pairs measured with an integrating meter")
+    group.add_argument("--tau-on", type=float, metavar="MS", help="warm-up time constant (with --tau-off)")
+    group.add_argument("--none", action="store_true", help="no compensation (LED heads)")
+    parser.add_argument("--tau-off", type=float, default=0.0, metavar="MS", help="afterglow time constant")
+    args = parser.parse_args()
+
+    if args.measurements:
+        pairs = read_measurements(args.measurements)
+        tau_on, tau_off = fit(pairs)
+        residual = max(abs(dose(on_ms, tau_on, tau_off) - dose_ms) for on_ms, dose_ms in pairs)
+        print(f"tau_on {tau_on:.1f} ms, tau_off {tau_off:.1f} ms, worst residual {residual:.1f} ms", file=sys.stderr)
+        source = os.path.basename(args.measurements)
+    elif args.none:
+        tau_on, tau_off, source = 0.0, 0.0, "--none"
+    else:
+        tau_on, tau_off = args.tau_on, args.tau_off
+        source = f"--tau-on {tau_on:g} --tau-off {tau_off:g}"
+    sys.stdout.write(header(tau_on, tau_off, source))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+
+# File: log_decoder.py
+# Project: Darkroom Enlarger Timer
+# File Created: Sunday, 18th October 2026 8:25:50 pm
+# Author: Andrei Grichine (andrei.grichine@gmail.com)
+# -----
+# Last Modified: Sunday, 18th October 2026 8:35:28 pm
+# Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+# -----
+# Copyright: 2019 - 2025. Prime73 Inc.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+# -----
+# HISTORY:
+
+
+
+"""Decodes the binary serial stream of a DEBUG build back into log lines.
+
+The firmware sends COBS frames delimited by 0x00 (src/SerialOutput.h). Log
+frames carry the flash address of their format string instead of the text
+(src/TokenLog.h); the strings are read back from the .text section of the
+ELF of the same build, so the ELF must match the firmware on the board.
+
+    log_decoder.py --elf darkroom_timer.ino.elf --port /dev/ttyUSB0
+    log_decoder.py --elf darkroom_timer.ino.elf capture.bin
+
+Bytes outside valid frames (plain text from the sketch) are printed as they
+are. --port needs pyserial; a capture file or stdin works without it.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FRAME_LOG = 0x01
+FRAME_DROPPED = 0x02
+FRAME_TELEMETRY = 0x03   # see telemetry_to_csv.py
+
+# printf conversion: flags, width, precision, length modifier, conversion
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t|L)?([diouxXeEfgGcs%])")
+
+
+def crc8(data, crc=0):
+    """CRC-8, polynomial 0x07, as computed by the firmware."""
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def cobs_decode(data):
+    """Undoes COBS byte stuffing of one frame (without its delimiter)."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("bad COBS code")
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(chunks):
+    """Yields (type, payload) for each valid frame and (None, raw) for anything else."""
+    pending = bytearray()
+    for chunk in chunks:
+        pending += chunk
+        while True:
+            end = pending.find(0)
+            if end < 0:
+                break
+            raw = bytes(pending[:end])
+            del pending[:end + 1]
+            if not raw:
+                continue
+            try:
+                frame = cobs_decode(raw)
+            except ValueError:
+                frame = b""
+            if len(frame) >= 2 and crc8(frame[:-1]) == frame[-1]:
+                yield frame[0], frame[1:-1]
+            else:
+                yield None, raw
+    if pending:
+        yield None, bytes(pending)
+
+
+class FormatTable:
+    """Format strings by flash address, read from the .text section of an ELF."""
+
+    def __init__(self, path):
+        with open(path, "rb") as elf:
+            image = elf.read()
+        if image[:4] != b"\x7fELF" or image[4] != 1:
+            raise ValueError(f"{path}: not a 32-bit ELF file")
+        shoff, = struct.unpack_from("<I", image, 32)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", image, 46)
+        headers = [struct.unpack_from("<IIIIII", image, shoff + i * shentsize) for i in range(shnum)]
+        names_offset = headers[shstrndx][4]
+        self.text = None
+        for name, _type, _flags, addr, offset, size in headers:
+            end = image.index(b"\0", names_offset + name)
+            if image[names_offset + name:end] == b".text":
+                self.base = addr
+                self.text = image[offset:offset + size]
+        if self.text is None:
+            raise ValueError(f"{path}: no .text section")
+
+    def lookup(self, address):
+        start = address - self.base
+        if not 0 <= start < len(self.text):
+            return None
+        end = self.text.find(b"\0", start)
+        return self.text[start:end].decode("latin-1")
+
+
+def format_record(fmt, args):
+    """Applies a printf format to the raw argument bytes of a log record."""
+    out = []
+    position = 0
+    last = 0
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[last:match.start()])
+        last = match.end()
+        flags, _length, conversion = match.groups()
+        if conversion == "%":
+            out.append("%")
+            continue
+        if conversion == "s":
+            end = args.find(b"\0", position)
+            if end < 0:
+                out.append("<missing>")
+                continue
+            out.append(("%" + flags + "s") % args[position:end].decode("latin-1"))
+            position = end + 1
+            continue
+        if position + 4 > len(args):
+            out.append("<missing>")
+            continue
+        raw = args[position:position + 4]
+        position += 4
+        if conversion in "eEfgG":
+            value = struct.unpack("<f", raw)[0]
+        elif conversion in "di":
+            value = struct.unpack("<i", raw)[0]
+        else:
+            value = struct.unpack("<I", raw)[0]
+        if conversion == "c":
+            out.append(chr(value & 0xFF))
+        else:
+            out.append(("%" + flags + ("d" if conversion == "u" else conversion)) % value)
+    out.append(fmt[last:])
+    return "".join(out).rstrip("\n")
+
+
+def describe(table, frame_type, payload):
+    """One line of text for a decoded frame, or None for frame types this tool does not know."""
+    if frame_type == FRAME_DROPPED and len(payload) == 2:
+        return f"-- {struct.unpack('<H', payload)[0]} frame(s) dropped, transmit ring full --"
+    if frame_type != FRAME_LOG or len(payload) < 6:
+        return None
+    message, timestamp = struct.unpack_from("<HI", payload)
+    fmt = table.lookup(message)
+    text = format_record(fmt, payload[6:]) if fmt is not None else f"<unknown message 0x{message:04x}>"
+    return f"{timestamp / 1000.0:12.3f} ms  {text}"
+
+
+def read_chunks(args):
+    if args.port:
+        import serial  # pyserial, only needed for live capture
+        with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+            while True:
+                yield port.read(256)
+    stream = sys.stdin.buffer if args.capture in (None, "-") else open(args.capture, "rb")
+    with stream:
+        while True:
+            chunk = stream.read(4096)
+            if not chunk:
+                return
+            yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--elf", required=True, help="firmware ELF of the running build")
+    parser.add_argument("--port", help="serial port to read from (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("capture", nargs="?", help="raw capture file, or - for stdin (default)")
+    args = parser.parse_args()
+
+    table = FormatTable(args.elf)
+    try:
+        for frame_type, payload in frames(read_chunks(args)):
+            if frame_type == FRAME_TELEMETRY:
+                continue
+            line = describe(table, frame_type, payload) if frame_type is not None else None
+            if line is None:
+                line = payload.decode("latin-1").rstrip("\r\n") if frame_type is None else \
+                    f"<frame type 0x{frame_type:02x}: {payload.hex()}>"
+            print(line, flush=True)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
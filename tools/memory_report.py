@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+
+# File: memory_report.py
+# Project: Darkroom Enlarger Timer
+# File Created: Sunday, 18th October 2026 8:31:12 pm
+# Author: Andrei Grichine (andrei.grichine@gmail.com)
+# -----
+# Last Modified: Sunday, 18th October 2026 8:31:12 pm
+# Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+# -----
+# Copyright: 2019 - 2025. Prime73 Inc.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+# -----
+# HISTORY:
+
+
+"""Flash and SRAM used by every source file of an AVR firmware image.
+
+Reads the symbol table of the linked ELF (the per-object sizes are useless
+with -flto, the final image is what counts) and attributes each symbol to
+the source file it was defined in, using the debug line information. Prints
+per file: flash (code, constants and .data initializers), .data and .bss,
+then the totals against the ATmega328P budget and the RAM left for the
+stack.
+
+    memory_report.py [--min-stack BYTES] [--csv] [--nm avr-nm] firmware.elf
+
+With --min-stack the exit status is 1 when less RAM than that is left for
+the stack, so a build can fail before the board does.
+"""
+
+import argparse
+import collections
+import os
+import subprocess
+import sys
+
+FLASH_BUDGET = 30720   # 32 KB minus the 2 KB bootloader of the Nano
+SRAM_BUDGET = 2048
+RAM_BASE = 0x800000    # avr-gcc maps SRAM at 0x800000 in the ELF address space
+EEPROM_BASE = 0x810000
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def run(tool, *args):
+    return subprocess.run([tool, *args], check=True, capture_output=True, text=True).stdout
+
+
+def section_ranges(size_tool, elf):
+    """Address ranges of .data and .bss from `avr-size -A`."""
+    ranges = {}
+    for line in run(size_tool, "-A", elf).splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[0] in (".data", ".bss", ".text"):
+            ranges[fields[0]] = (int(fields[2]), int(fields[1]))
+    return ranges
+
+
+def source_name(location):
+    """Repository-relative path of a source file, or library/file outside the repo."""
+    path = os.path.normpath(location.rsplit(":", 1)[0])
+    if path.startswith(REPO_ROOT + os.sep):
+        return os.path.relpath(path, REPO_ROOT)
+    return os.path.join(os.path.basename(os.path.dirname(path)), os.path.basename(path))
+
+
+def attribute(nm_tool, elf, ranges):
+    usage = collections.defaultdict(lambda: {"flash": 0, "data": 0, "bss": 0})
+    data_start, data_size = ranges.get(".data", (0, 0))
+    for line in run(nm_tool, "--print-size", "--size-sort", "--line-numbers", elf).splitlines():
+        symbol, _, location = line.partition("\t")
+        fields = symbol.split()
+        if len(fields) < 4:
+            continue  # no size
+        address, size = int(fields[0], 16), int(fields[1], 16)
+        owner = source_name(location) if location else "(no debug info)"
+        if address >= EEPROM_BASE:
+            continue
+        if address < RAM_BASE:
+            usage[owner]["flash"] += size
+        elif data_start <= address < data_start + data_size:
+            usage[owner]["data"] += size
+            usage[owner]["flash"] += size  # initial values are copied from flash
+        else:
+            usage[owner]["bss"] += size
+    return usage
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="avr-nm", help="nm of the AVR toolchain (default avr-nm)")
+    parser.add_argument("--size", default="avr-size", help="size of the AVR toolchain (default avr-size)")
+    parser.add_argument("--min-stack", type=int, default=0, help="fail if less SRAM than this is left for the stack")
+    parser.add_argument("--csv", action="store_true", help="machine-readable output")
+    args = parser.parse_args()
+
+    ranges = section_ranges(args.size, args.elf)
+    usage = attribute(args.nm, args.elf, ranges)
+    text = ranges.get(".text", (0, 0))[1]
+    data = ranges.get(".data", (0, 0))[1]
+    bss = ranges.get(".bss", (0, 0))[1]
+    stack = SRAM_BUDGET - data - bss
+    rows = sorted(usage.items(), key=lambda item: (-(item[1]["data"] + item[1]["bss"]), -item[1]["flash"], item[0]))
+
+    if args.csv:
+        print("file,flash,data,bss")
+        for name, used in rows:
+            print(f"{name},{used['flash']},{used['data']},{used['bss']}")
+        print(f"# total,{text + data},{data},{bss}")
+    else:
+        print(f"{'file':<52} {'flash':>7} {'.data':>6} {'.bss':>6}")
+        for name, used in rows:
+            print(f"{name:<52} {used['flash']:>7} {used['data']:>6} {used['bss']:>6}")
+        print(f"{'total (including padding and vectors)':<52} {text + data:>7} {data:>6} {bss:>6}")
+        print()
+        print(f"flash {text + data} of {FLASH_BUDGET} bytes ({(text + data) * 100 // FLASH_BUDGET}%)")
+        print(f"SRAM  {data + bss} of {SRAM_BUDGET} bytes static, {stack} left for the stack")
+
+    if stack < args.min_stack:
+        print(f"memory_report: only {stack} bytes left for the stack, {args.min_stack} required", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+
+# File: telemetry_to_csv.py
+# Project: Darkroom Enlarger Timer
+# File Created: Sunday, 18th October 2026 8:35:05 pm
+# Author: Andrei Grichine (andrei.grichine@gmail.com)
+# -----
+# Last Modified: Sunday, 18th October 2026 9:00:56 pm
+# Modified By: Andrei Grichine (andrei.grichine@gmail.com>)
+# -----
+# Copyright: 2019 - 2025. Prime73 Inc.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the 'Software'), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions: The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+# -----
+# HISTORY:
+
+
+
+"""Converts the telemetry stream of the timer to CSV.
+
+Switch the stream on with the TELEM command (see src/SerialCommands.h),
+then record it:
+
+    telemetry_to_csv.py --port /dev/ttyUSB0 --period 100 > bench.csv
+    telemetry_to_csv.py capture.bin > bench.csv
+
+With --period the script sends "TELEM <ms>" itself and "TELEM 0" on exit.
+Every sample becomes one row (field layout in src/Telemetry.h); `missed`
+counts the samples skipped before it because the transmit ring was full.
+Log frames, drop reports and reply lines are ignored. --port needs pyserial.
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from log_decoder import frames  # noqa: E402  (shared frame splitter)
+
+FRAME_TELEMETRY = 0x03
+SAMPLE = struct.Struct("<HIBBIiHHBHH")
+STATES = ["IDLE", "ARMED", "EXPOSING", "PAUSED", "MANUAL_FOCUS", "FAULT", "HISTORY", "METER"]
+COLUMNS = ["sequence", "millis", "state", "relay", "manual_light", "eeprom_failed", "remaining_us",
+           "delay_ms", "loop_max_us", "loops", "ee_bad", "ee_address", "tx_dropped", "missed"]
+
+
+def rows(stream):
+    """Yields one CSV row per telemetry sample in a stream of byte chunks."""
+    previous = None
+    for frame_type, payload in frames(stream):
+        if frame_type != FRAME_TELEMETRY or len(payload) != SAMPLE.size:
+            continue
+        (sequence, millis, state, flags, remaining, delay, loop_max, loops,
+         ee_bad, ee_address, dropped) = SAMPLE.unpack(payload)
+        missed = 0 if previous is None else (sequence - previous - 1) & 0xFFFF
+        previous = sequence
+        yield [sequence, millis, STATES[state] if state < len(STATES) else state,
+               flags & 1, (flags >> 1) & 1, (flags >> 2) & 1, remaining, delay,
+               loop_max, loops, ee_bad, ee_address, dropped, missed]
+
+
+def port_chunks(port):
+    while True:
+        yield port.read(256)
+
+
+def file_chunks(stream):
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            return
+        yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", help="serial port to read from (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--period", type=int, help="with --port: sample period in ms to request")
+    parser.add_argument("capture", nargs="?", help="raw capture file, or - for stdin (default)")
+    args = parser.parse_args()
+
+    writer = csv.writer(sys.stdout, lineterminator="\n")
+    writer.writerow(COLUMNS)
+    try:
+        if args.port:
+            import serial  # pyserial, only needed for live capture
+            with serial.Serial(args.port, args.baud, timeout=0.1) as port:
+                if args.period is not None:
+                    port.write(f"TELEM {args.period}\n".encode())
+                try:
+                    for row in rows(port_chunks(port)):
+                        writer.writerow(row)
+                        sys.stdout.flush()
+                finally:
+                    if args.period is not None:
+                        port.write(b"TELEM 0\n")
+        else:
+            stream = sys.stdin.buffer if args.capture in (None, "-") else open(args.capture, "rb")
+            with stream:
+                for row in rows(file_chunks(stream)):
+                    writer.writerow(row)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())